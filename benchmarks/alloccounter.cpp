@@ -0,0 +1,81 @@
+#include "alloccounter.h"
+
+#include <atomic>
+#include <malloc.h>
+
+static std::atomic<size_t> s_allocCount {0};
+static std::atomic<size_t> s_allocBytes {0};
+static std::atomic<long long> s_liveBytes {0};
+
+static void *counted(void *ptr, size_t size)
+{
+    s_allocCount.fetch_add(1, std::memory_order_relaxed);
+    s_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (ptr)
+        s_liveBytes.fetch_add(static_cast<long long>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+    return ptr;
+}
+
+static void uncounted(void *ptr)
+{
+    if (ptr)
+        s_liveBytes.fetch_sub(static_cast<long long>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t num, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    return counted(__libc_malloc(size), size);
+}
+
+void *calloc(size_t num, size_t size)
+{
+    return counted(__libc_calloc(num, size), num * size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    uncounted(ptr);
+    return counted(__libc_realloc(ptr, size), size);
+}
+
+void free(void *ptr)
+{
+    uncounted(ptr);
+    __libc_free(ptr);
+}
+
+}
+
+AllocCounter::AllocCounter()
+{
+    reset();
+}
+
+size_t AllocCounter::count() const
+{
+    return s_allocCount.load(std::memory_order_relaxed) - m_startCount;
+}
+
+size_t AllocCounter::bytes() const
+{
+    return s_allocBytes.load(std::memory_order_relaxed) - m_startBytes;
+}
+
+long long AllocCounter::liveBytes() const
+{
+    return s_liveBytes.load(std::memory_order_relaxed) - m_startLiveBytes;
+}
+
+void AllocCounter::reset()
+{
+    m_startLiveBytes = s_liveBytes.load(std::memory_order_relaxed);
+    m_startCount = s_allocCount.load(std::memory_order_relaxed);
+    m_startBytes = s_allocBytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * AllocCounter counts heap allocations (malloc/calloc/realloc, and so operator new
+ * and QArrayData) made by the whole process since the object was created, and
+ * the change of heap memory in use.
+ *
+ * The counting is done by interposing glibc's malloc in the benchmark executable.
+ */
+class AllocCounter
+{
+public:
+    AllocCounter();
+
+    size_t count() const;
+    size_t bytes() const;
+    long long liveBytes() const;
+    void reset();
+
+private:
+    size_t m_startCount {0};
+    size_t m_startBytes {0};
+    long long m_startLiveBytes {0};
+};
@@ -0,0 +1,64 @@
+#include <doctest.h>
+#include "alloccounter.h"
+#include "paragraph.h"
+
+#include <QElapsedTimer>
+
+constexpr int WORDS_PER_LINE = 10;
+constexpr int NAVIGATION_STEPS = 10000;
+
+static Paragraph makeParagraph(int numWords)
+{
+    Paragraph paragraph(0);
+    QString line;
+    for (int i = 0; i < numWords; ++i) {
+        line.append(QString("word%1").arg(i % 100));
+        line.append((i + 1) % 15 == 0 ? ". " : " ");
+        if ((i + 1) % WORDS_PER_LINE == 0) {
+            paragraph.addLine(line, "eng");
+            line.clear();
+        }
+    }
+    if (!line.isEmpty())
+        paragraph.addLine(line, "eng");
+
+    return paragraph;
+}
+
+// Average time of one navigation step in nanoseconds, taken from the middle of the paragraph
+template <typename Step>
+static qint64 stepLatency(const Paragraph &paragraph, Step step)
+{
+    const int middle = paragraph.length() / 2;
+    QElapsedTimer timer;
+    timer.start();
+    int checksum = 0;
+    for (int i = 0; i < NAVIGATION_STEPS; ++i)
+        checksum += step(paragraph, middle + i % 64).parPos();
+    const auto elapsed = timer.nsecsElapsed();
+    CHECK(checksum > 0);
+    return elapsed / NAVIGATION_STEPS;
+}
+
+TEST_CASE("Benchmark Paragraph navigation latency")
+{
+    for (int numWords : {100, 1000, 10000}) {
+        AllocCounter allocs;
+        const auto paragraph = makeParagraph(numWords);
+        const auto memory = allocs.liveBytes();
+
+        const auto nextWord = stepLatency(paragraph, [](const Paragraph &p, int pos) {
+            return p.nextWordPosition(pos);
+        });
+        const auto backSymbol = stepLatency(paragraph, [](const Paragraph &p, int pos) {
+            return p.prevCharPosition(pos);
+        });
+        const auto nextSentence = stepLatency(paragraph, [](const Paragraph &p, int pos) {
+            return p.nextSentencePosition(pos);
+        });
+
+        MESSAGE(numWords << " words, " << paragraph.length() << " chars: "
+                << memory << " bytes in use, nextWord " << nextWord << " ns, backSymbol "
+                << backSymbol << " ns, nextSentence " << nextSentence << " ns");
+    }
+}
@@ -0,0 +1,99 @@
+#include <doctest.h>
+#include "alloccounter.h"
+#include "textpage.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+constexpr int NUM_PARAGRAPHS = 20;
+constexpr int LINES_PER_PARAGRAPH = 15;
+constexpr int NAVIGATION_STEPS = 1000;
+
+static QString ocrLine(int num)
+{
+    return QString("Line %1 of the scanned page, with some words. And one more").arg(num);
+}
+
+// Text storage as it was before paragraphs became views into the page storage:
+// the lines are joined on every read
+static QString joinOnRead(const QStringList &lines)
+{
+    return lines.join("").trimmed();
+}
+
+TEST_CASE("Benchmark TextPage ingestion")
+{
+    QStringList legacyLines;
+    int legacyLength = 0;
+    AllocCounter allocs;
+    QElapsedTimer timer;
+    timer.start();
+    for (int p = 0; p < NUM_PARAGRAPHS; ++p) {
+        legacyLines.clear();
+        for (int l = 0; l < LINES_PER_PARAGRAPH; ++l) {
+            legacyLines.append(ocrLine(l).simplified() + ' ');
+            // Old Paragraph::addLine() joined the text once per parsing pass and once for length()
+            for (int i = 0; i < 4; ++i)
+                legacyLength += joinOnRead(legacyLines).length();
+        }
+    }
+    CHECK(legacyLength > 0);
+    MESSAGE("join-on-read: " << allocs.count() << " allocations, " << allocs.bytes() << " bytes, "
+            << timer.nsecsElapsed() / 1000 << " us");
+
+    TextPage page;
+    allocs.reset();
+    timer.restart();
+    for (int p = 0; p < NUM_PARAGRAPHS; ++p) {
+        page.addParagraph();
+        for (int l = 0; l < LINES_PER_PARAGRAPH; ++l)
+            page.addParagraphLine(ocrLine(l), "eng");
+    }
+    MESSAGE("page storage: " << allocs.count() << " allocations, " << allocs.bytes() << " bytes, "
+            << timer.nsecsElapsed() / 1000 << " us");
+}
+
+TEST_CASE("Benchmark TextPage navigation reads")
+{
+    TextPage page;
+    QStringList legacyLines;
+    page.addParagraph();
+    for (int l = 0; l < LINES_PER_PARAGRAPH; ++l) {
+        page.addParagraphLine(ocrLine(l), "eng");
+        legacyLines.append(ocrLine(l).simplified() + ' ');
+    }
+    const auto &paragraph = page.paragraph(0);
+
+    // Reading current word as navigation does: once to get the text and once more for its length
+    int checksum = 0;
+    AllocCounter allocs;
+    QElapsedTimer timer;
+    timer.start();
+    auto position = paragraph.firstWordPosition();
+    for (int i = 0; i < NAVIGATION_STEPS && position.isValid(); ++i) {
+        checksum += joinOnRead(legacyLines).length();
+        checksum += joinOnRead(legacyLines).mid(position.parPos(), position.length()).length();
+        position = paragraph.nextWordPosition(position.parPos());
+    }
+    CHECK(checksum > 0);
+    MESSAGE("join-on-read: " << allocs.count() << " allocations, "
+            << timer.nsecsElapsed() / 1000 << " us");
+
+    allocs.reset();
+    timer.restart();
+    position = paragraph.firstWordPosition();
+    for (int i = 0; i < NAVIGATION_STEPS && position.isValid(); ++i) {
+        checksum += paragraph.length();
+        checksum += paragraph.textView().mid(position.parPos(), position.length()).length();
+        position = paragraph.nextWordPosition(position.parPos());
+    }
+    CHECK(checksum > 0);
+    MESSAGE("page storage: " << allocs.count() << " allocations, "
+            << timer.nsecsElapsed() / 1000 << " us");
+
+    allocs.reset();
+    for (int i = 0; i < NAVIGATION_STEPS; ++i)
+        checksum += page.text().length();
+    CHECK(checksum > 0);
+    MESSAGE("TextPage::text() x" << NAVIGATION_STEPS << ": " << allocs.count() << " allocations");
+}
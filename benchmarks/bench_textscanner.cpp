@@ -0,0 +1,62 @@
+#include <doctest.h>
+#include "textscanner.h"
+
+#include <QElapsedTimer>
+#include <QRegularExpression>
+
+constexpr int REPEATS = 100;
+
+static QString pageText()
+{
+    QString text;
+    for (int i = 0; i < 200; ++i)
+        text.append(QString("Sentence number %1 has some words, and a comma. ").arg(i));
+    return text;
+}
+
+// Positions scanning as it was done before TextScanner
+static int regexScan(const QString &text, const QRegularExpression &re)
+{
+    int count = 0;
+    int nextPos = 0;
+    while (true) {
+        auto match = re.match(text, nextPos);
+        if (!match.hasMatch())
+            break;
+        ++count;
+        nextPos = match.capturedEnd();
+    }
+    if (nextPos < text.length() && QRegularExpression("[^-\\s]").match(text, nextPos).hasMatch())
+        ++count;
+    return count;
+}
+
+TEST_CASE("Benchmark TextScanner against regular expressions")
+{
+    const auto text = pageText();
+    const QRegularExpression wordRe(R"([\w\d']+)");
+    const QRegularExpression sentenceRe(R"([^\.!?]{3,}[\.!?])");
+    const auto endMask = TextScanner::sentenceEndMask("eng");
+
+    QElapsedTimer timer;
+    timer.start();
+    int regexCount = 0;
+    for (int i = 0; i < REPEATS; ++i)
+        regexCount += regexScan(text, wordRe) + regexScan(text, sentenceRe);
+    const auto regexTime = timer.nsecsElapsed() / REPEATS;
+
+    timer.restart();
+    int scannerCount = 0;
+    for (int i = 0; i < REPEATS; ++i) {
+        PositionTable words;
+        PositionTable sentences;
+        TextScanner::scanWords(text, 0, words);
+        TextScanner::scanSentences(text, 0, endMask, sentences);
+        scannerCount += words.size() + sentences.size();
+    }
+    const auto scannerTime = timer.nsecsElapsed() / REPEATS;
+
+    CHECK_EQ(regexCount, scannerCount);
+    MESSAGE(text.size() << " chars: regex " << regexTime / 1000 << " us, scanner "
+            << scannerTime / 1000 << " us per page");
+}
@@ -0,0 +1,6 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+// Every benchmark is a doctest test case which reports its measurements with MESSAGE().
+// Run with "-s" to see the measurements of the passed benchmarks:
+//     ./benchmarks -s
@@ -32,6 +32,16 @@ extern "C"
 {
 #endif
 
+/* ******************************************************************
+**  DEFINITIONS
+** ******************************************************************/
+
+typedef struct VPLATFORM_CRITSEC_STATS_S {
+  unsigned long long  cntEnter;      /* Enter() calls, not counting the recursive ones */
+  unsigned long long  cntContended;  /* Enter() calls that waited for another thread */
+  unsigned int        cntOpen;       /* Critical sections open now */
+} VPLATFORM_CRITSEC_STATS;
+
 /* ******************************************************************
 **  GLOBAL FUNCTION PROTOTYPES
 ** ******************************************************************/
@@ -61,6 +71,18 @@ NUAN_ERROR vplatform_critsec_Leave(
   void *  hCritSec
 );
 
+/*-------------------------------------------------------------------
+**  @func   Get the contention counters of the critical sections
+**          opened with the class handle.
+**  @rdesc  NUAN_ERROR | Success or failure
+**------------------------------------------------------------------*/
+NUAN_ERROR vplatform_critsec_GetStats(
+  void                    * hCSClass,   /* @parm [in] <nl>
+                                        ** Class handle from VE_INSTALL */
+  VPLATFORM_CRITSEC_STATS * pStats      /* @parm [out] <nl>
+                                        ** Counters */
+);
+
 /*-------------------------------------------------------------------
 **  @func   Get the interface and a class handle of the Critical
 **          Sections service.
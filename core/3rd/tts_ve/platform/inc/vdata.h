@@ -46,6 +46,12 @@ typedef void * VPLATFORM_DATA_HENTRY;
 /* handle to the data cached in a data entry (stream or mapping handle) */
 typedef void * VPLATFORM_DATA_HDATA;
 
+/* Uses of the process wide index of the install directories */
+typedef struct VPLATFORM_DATA_INDEX_STATS_S {
+  unsigned long   cntHits;      /* Inits that used the index */
+  unsigned long   cntMisses;    /* Inits that walked the directories, the first one or after a change */
+} VPLATFORM_DATA_INDEX_STATS;
+
 /* ******************************************************************
 **  GLOBAL FUNCTION PROTOTYPES
 ** ******************************************************************/
@@ -231,6 +237,15 @@ NUAN_ERROR vplatform_data_GetInterface(
                                       ** Platform resources*/
 );
 
+/*-------------------------------------------------------------------
+**  @func   Get the counters of the install directories index.
+**  @rdesc  NUAN_ERROR | Success or failure
+**------------------------------------------------------------------*/
+NUAN_ERROR vplatform_data_GetIndexStats(
+  VPLATFORM_DATA_INDEX_STATS * pStats  /* @parm [out] <nl>
+                                       ** Counters */
+);
+
 /*-------------------------------------------------------------------
 **  @func   Release the handle of the data access services.
 **  @rdesc  NUAN_ERROR | Success or failure
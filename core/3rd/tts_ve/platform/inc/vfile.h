@@ -109,6 +109,20 @@ size_t vplatform_file_GetSize(
   VPLATFORM_FILE_H  hFile
 );
 
+/*-------------------------------------------------------------------
+**  @func   Get the contents of a file opened for reading only. The
+**          data is mapped and stays valid till the file is closed.
+**  @rdesc  NUAN_ERROR | NUAN_E_NOTIMPLEMENTED if the file isn't mapped
+**------------------------------------------------------------------*/
+NUAN_ERROR vplatform_file_GetData(
+  VPLATFORM_FILE_H    hFile,    /* @parm [in] <nl>
+                                ** File handle */
+  const void       ** ppData,   /* @parm [out] <nl>
+                                ** Start of the file, NULL for an empty file */
+  size_t            * pcBytes   /* @parm [out] <nl>
+                                ** Size of the file */
+);
+
 /*------------------------------------------------------------------*/
 NUAN_ERROR vplatform_file_Error(
   VPLATFORM_FILE_H  hFile
@@ -32,6 +32,22 @@ extern "C"
 {
 #endif
 
+/* ******************************************************************
+**  DEFINITIONS
+** ******************************************************************/
+
+/* Counters of the pool heap, selected by F_POOL_HEAP in the platform resources */
+typedef struct VPLATFORM_HEAP_STATS_S {
+  unsigned long long  cntAlloc;           /* Allocations, including the moving reallocations */
+  unsigned long long  cntFree;
+  unsigned long long  cntLarge;           /* Allocations too large for the pools */
+  size_t              cBytesInUse;        /* Requested bytes not freed yet */
+  size_t              cBytesPeak;         /* Peak of cBytesInUse */
+  size_t              cBytesPooled;       /* Pool blocks in use, with headers and rounding */
+  size_t              cBytesReserved;     /* Chunks and large blocks taken from the C library */
+  size_t              cBytesPeakReserved; /* Peak of cBytesReserved */
+} VPLATFORM_HEAP_STATS;
+
 /* ******************************************************************
 **  GLOBAL FUNCTION PROTOTYPES
 ** ******************************************************************/
@@ -66,6 +82,18 @@ void vplatform_heap_Free(
   void                       * pData
 );
 
+/*-------------------------------------------------------------------
+**  @func   Get the allocation counters of the pool heap. Reserved
+**          bytes not in use are free blocks and unused chunk tails.
+**  @rdesc  NUAN_ERROR | Success or failure
+**------------------------------------------------------------------*/
+NUAN_ERROR vplatform_heap_GetStats(
+  void                 * hHeap,    /* @parm [in] <nl>
+                                   ** Heap handle from VE_INSTALL */
+  VPLATFORM_HEAP_STATS * pStats    /* @parm [out] <nl>
+                                   ** Counters */
+);
+
 /*-------------------------------------------------------------------
 **  @func   Get the interface and an instance handle of the Heap service.
 **  @rdesc  NUAN_ERROR | Success or failure
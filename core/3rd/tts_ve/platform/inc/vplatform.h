@@ -85,6 +85,7 @@ typedef struct {
 } VPLATFORM_RESOURCES;
 
 #define F_ERROR_CHECK     0x1                     /* bitfield specifier for error checking flag (implementation dependent) */   
+#define F_POOL_HEAP       0x2                     /* per-install size-class heap instead of the C library one */
 
 /* ******************************************************************
 **  GLOBAL FUNCTION PROTOTYPES
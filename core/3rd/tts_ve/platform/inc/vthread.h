@@ -37,9 +37,40 @@ typedef NUAN_THREAD_T* NUAN_THREAD_H;
 typedef VE_HSAFE NUAN_SEMAPHORE_T;
 typedef NUAN_SEMAPHORE_T* NUAN_SEMAPHORE_H;
 
+/* Threads of the process that get their own scheduling parameters */
+typedef enum {
+  VPLATFORM_THREAD_ROLE_ENGINE,       /* Threads the engine starts through the interface */
+  VPLATFORM_THREAD_ROLE_SYNTHESIS,    /* Threads calling the engine to synthesize speech */
+  VPLATFORM_THREAD_ROLE_BACKGROUND,   /* Camera and other work that must not delay speech */
+  VPLATFORM_THREAD_ROLE_COUNT
+} VPLATFORM_THREAD_ROLE;
+
+typedef struct VPLATFORM_THREAD_PARAMS_S {
+  int           iPolicy;      /* SCHED_OTHER, SCHED_FIFO, ... */
+  int           iPriority;    /* Priority of SCHED_FIFO and SCHED_RR */
+  int           iNice;        /* Nice value of the other policies */
+  NUAN_U32      u32CpuMask;   /* CPUs the thread may run on, 0 - all */
+} VPLATFORM_THREAD_PARAMS;
+
+/* Counters of the thread pool, shared by all installs of the process */
+typedef struct VPLATFORM_THREAD_STATS_S {
+  unsigned long long  cntStart;         /* Started threads */
+  unsigned long long  cntCreated;       /* Pool workers created */
+  unsigned long long  cntReused;        /* Threads started on an idle worker */
+  unsigned long long  usStartTotal;     /* From Start() till the start function runs */
+  unsigned long long  usStartMax;
+  unsigned long long  cntJoin;
+  unsigned long long  usJoinTotal;      /* Time spent waiting in Join() */
+  unsigned long long  usJoinMax;
+  unsigned long long  cntParamErrors;   /* Scheduling settings refused by the system */
+  unsigned int        cntIdle;          /* Idle workers now */
+} VPLATFORM_THREAD_STATS;
+
 /*------------------------------------------------------------------*/
 /**
  * @brief Allocate memory for a thread handle in a safe mode.
+ *        Threads started on the handle run on the workers of a process
+ *        wide pool, idle workers are kept for the next threads.
  * @param phClass     [unused here]
           pHeap       [in] handle of the heap to be passed to the platform
                            heap primitives
@@ -53,8 +84,7 @@ NUAN_ERROR vplatform_thread_ObjOpen(void* phClass, void* pHeap, void ** pThreadH
  * @brief Destroy a thread handle.
  * @param pThread [in] a pointer to the thread handle
  * @return NUAN_ERROR | Success or failure
- * @note There isn't any control on the thread status. If the thread referenced by
- *       the pThreadH is still running the handle to it will be lost.
+ * @note Fails with NUAN_E_WRONG_STATE if the thread is still running.
  */
 NUAN_ERROR vplatform_thread_ObjClose(void * pThreadH);
 
@@ -104,6 +134,34 @@ NUAN_ERROR vplatform_thread_SleepMs(void *pThreadH ,unsigned short pMS);
  */
 NUAN_ERROR vplatform_thread_GetCallingThreadId(void *pThreadH, unsigned int *pThreadId);
 
+/*------------------------------------------------------------------*/
+/**
+ * @brief Sets the scheduling parameters of a role. The pool workers
+ *        apply the engine role parameters before their next thread.
+ * @param pRole    [in] role of concern
+ *        pParams  [in] scheduling parameters
+ * @return NUAN_ERROR | Success or failure
+ */
+NUAN_ERROR vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE pRole,
+                                          const VPLATFORM_THREAD_PARAMS * pParams);
+
+/*------------------------------------------------------------------*/
+/**
+ * @brief Applies the scheduling parameters of a role to the calling thread.
+ * @param pRole [in] role of concern
+ * @return NUAN_ERROR | NUAN_E_SYSTEM_ERROR if the system refused some
+ *         of the parameters, such as a higher priority without privileges
+ */
+NUAN_ERROR vplatform_thread_ApplyRole(VPLATFORM_THREAD_ROLE pRole);
+
+/*------------------------------------------------------------------*/
+/**
+ * @brief Get the counters of the thread pool.
+ * @param pStats [out] counters
+ * @return NUAN_ERROR | Success or failure
+ */
+NUAN_ERROR vplatform_thread_GetStats(VPLATFORM_THREAD_STATS * pStats);
+
 /*------------------------------------------------------------------*/
 /**
  * @brief Allocate memory for a Semaphore handle in a safe mode.
@@ -24,8 +24,13 @@
 
 #include "vplatform.h"
 #include "vcritsec.h"
+#include "vheap.h"
 
 #include <stdlib.h>
+#include <stdatomic.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 /* ******************************************************************
 **  COMPILER DIRECTIVES
@@ -36,9 +41,67 @@
 **  DEFINITIONS
 ** ******************************************************************/
 
-/*lint -esym(715, hHeap, hCritSecClass, hCritSec,hCSClass) 
-**           not used in this implementation */
+#define NUAN_CRITSEC_HCHECK  135974
 
+/* Lock states of the futex word */
+#define CRITSEC_FREE         0
+#define CRITSEC_LOCKED       1
+#define CRITSEC_WAITERS      2   /* Locked and Leave() must wake a waiter */
+
+typedef struct NUAN_CRITSEC_CLASS_S {
+  atomic_ullong   cntEnter;
+  atomic_ullong   cntContended;
+  atomic_uint     cntOpen;
+  void          * hHeap;
+} NUAN_CRITSEC_CLASS;
+
+/* Critical sections are recursive, like the Win32 ones the interface is
+** modelled on. Owner and depth are changed only by the owning thread */
+typedef struct NUAN_CRITSEC_S {
+  NUAN_U32              u32Check;
+  atomic_int            state;
+  atomic_int            owner;
+  unsigned int          depth;
+  NUAN_CRITSEC_CLASS  * pClass;
+  void                * hHeap;
+} NUAN_CRITSEC;
+
+/* ******************************************************************
+**  LOCAL FUNCTIONS
+** ******************************************************************/
+
+/*------------------------------------------------------------------*/
+static int vplatform_critsec_ThreadId(void)
+{
+  static _Thread_local int threadId = 0;
+  if (threadId == 0) {
+    threadId = (int)syscall(SYS_gettid);
+  }
+  return threadId;
+}
+
+/*------------------------------------------------------------------*/
+static NUAN_CRITSEC * vplatform_critsec_Validate(void * hCritSec)
+{
+  NUAN_CRITSEC * pCritSec = (NUAN_CRITSEC *)hCritSec;
+  if (pCritSec == NULL || pCritSec->u32Check != NUAN_CRITSEC_HCHECK) {
+    return NULL;
+  }
+  return pCritSec;
+}
+
+/*------------------------------------------------------------------*/
+static void vplatform_critsec_Wait(NUAN_CRITSEC * pCritSec)
+{
+  /* Returns at once if the state is not CRITSEC_WAITERS anymore */
+  syscall(SYS_futex, (int *)&pCritSec->state, FUTEX_WAIT_PRIVATE, CRITSEC_WAITERS, NULL, NULL, 0);
+}
+
+/*------------------------------------------------------------------*/
+static void vplatform_critsec_Wake(NUAN_CRITSEC * pCritSec)
+{
+  syscall(SYS_futex, (int *)&pCritSec->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
 
 /* ******************************************************************
 **  FUNCTIONS
@@ -54,16 +117,32 @@ NUAN_ERROR vplatform_critsec_ObjOpen(
   void *      hHeap,
   void **     phCritSec)
 {
-  /* Stub implementation */
-  (void) hCCritSec;
+  NUAN_CRITSEC * pCritSec = NULL;
 
   /* Validate args */
   if (! phCritSec) {
     return NUAN_E_INVALIDARG;
   }
+  *phCritSec = NULL;
+
+  pCritSec = (NUAN_CRITSEC *)vplatform_heap_Malloc(hHeap, sizeof(NUAN_CRITSEC));
+  if (pCritSec == NULL) {
+    return NUAN_E_MALLOC;
+  }
+
+  pCritSec->u32Check = NUAN_CRITSEC_HCHECK;
+  atomic_init(&pCritSec->state, CRITSEC_FREE);
+  atomic_init(&pCritSec->owner, 0);
+  pCritSec->depth = 0;
+  /* Platform streams open critical sections without a class */
+  pCritSec->pClass = (NUAN_CRITSEC_CLASS *)hCCritSec;
+  pCritSec->hHeap = hHeap;
+  if (pCritSec->pClass != NULL) {
+    atomic_fetch_add_explicit(&pCritSec->pClass->cntOpen, 1, memory_order_relaxed);
+  }
 
   /* Set output arg */
-  *phCritSec = (void * ) 0x1234abcd;
+  *phCritSec = pCritSec;
 
   return NUAN_OK;
 } /* vplatform_critsec_ObjOpen */
@@ -72,7 +151,19 @@ NUAN_ERROR vplatform_critsec_ObjOpen(
 NUAN_ERROR vplatform_critsec_ObjClose(
   void *  hCritSec)
 {
-  (void) hCritSec;
+  NUAN_CRITSEC * pCritSec = vplatform_critsec_Validate(hCritSec);
+  if (pCritSec == NULL) {
+    return NUAN_E_INVALIDHANDLE;
+  }
+  if (atomic_load(&pCritSec->state) != CRITSEC_FREE) {
+    return NUAN_E_WRONG_STATE;
+  }
+
+  if (pCritSec->pClass != NULL) {
+    atomic_fetch_sub_explicit(&pCritSec->pClass->cntOpen, 1, memory_order_relaxed);
+  }
+  pCritSec->u32Check = 0;
+  vplatform_heap_Free(pCritSec->hHeap, pCritSec);
   return NUAN_OK;
 } /* vplatform_critsec_ObjClose */
 
@@ -80,7 +171,40 @@ NUAN_ERROR vplatform_critsec_ObjClose(
 NUAN_ERROR vplatform_critsec_Enter(
   void *  hCritSec)
 {
-  (void) hCritSec;
+  NUAN_CRITSEC * pCritSec = vplatform_critsec_Validate(hCritSec);
+  const int threadId = vplatform_critsec_ThreadId();
+  int state = CRITSEC_FREE;
+
+  if (pCritSec == NULL) {
+    return NUAN_E_INVALIDHANDLE;
+  }
+
+  if (atomic_load_explicit(&pCritSec->owner, memory_order_relaxed) == threadId) {
+    ++pCritSec->depth;
+    return NUAN_OK;
+  }
+
+  if (pCritSec->pClass != NULL) {
+    atomic_fetch_add_explicit(&pCritSec->pClass->cntEnter, 1, memory_order_relaxed);
+  }
+
+  if (! atomic_compare_exchange_strong_explicit(&pCritSec->state, &state, CRITSEC_LOCKED,
+                                                memory_order_acquire, memory_order_relaxed)) {
+    if (pCritSec->pClass != NULL) {
+      atomic_fetch_add_explicit(&pCritSec->pClass->cntContended, 1, memory_order_relaxed);
+    }
+    /* The lock taken from now on is marked as having waiters, so Leave() wakes the next one */
+    if (state != CRITSEC_WAITERS) {
+      state = atomic_exchange_explicit(&pCritSec->state, CRITSEC_WAITERS, memory_order_acquire);
+    }
+    while (state != CRITSEC_FREE) {
+      vplatform_critsec_Wait(pCritSec);
+      state = atomic_exchange_explicit(&pCritSec->state, CRITSEC_WAITERS, memory_order_acquire);
+    }
+  }
+
+  atomic_store_explicit(&pCritSec->owner, threadId, memory_order_relaxed);
+  pCritSec->depth = 1;
   return NUAN_OK;
 } /* vplatform_critsec_Enter */
 
@@ -88,22 +212,51 @@ NUAN_ERROR vplatform_critsec_Enter(
 NUAN_ERROR vplatform_critsec_Leave(
   void *  hCritSec)
 {
-  (void) hCritSec;
+  NUAN_CRITSEC * pCritSec = vplatform_critsec_Validate(hCritSec);
+  if (pCritSec == NULL) {
+    return NUAN_E_INVALIDHANDLE;
+  }
+  if (atomic_load_explicit(&pCritSec->owner, memory_order_relaxed) != vplatform_critsec_ThreadId()) {
+    return NUAN_E_WRONG_STATE;
+  }
+
+  if (--pCritSec->depth > 0) {
+    return NUAN_OK;
+  }
+  atomic_store_explicit(&pCritSec->owner, 0, memory_order_relaxed);
+  if (atomic_exchange_explicit(&pCritSec->state, CRITSEC_FREE, memory_order_release) == CRITSEC_WAITERS) {
+    vplatform_critsec_Wake(pCritSec);
+  }
   return NUAN_OK;
 } /* vplatform_critsec_Leave */
 
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_critsec_GetStats(
+  void                    * hCSClass,
+  VPLATFORM_CRITSEC_STATS * pStats)
+{
+  NUAN_CRITSEC_CLASS * pClass = (NUAN_CRITSEC_CLASS *)hCSClass;
+  if (pClass == NULL || pStats == NULL) {
+    return NUAN_E_NULLPOINTER;
+  }
+
+  pStats->cntEnter = atomic_load_explicit(&pClass->cntEnter, memory_order_relaxed);
+  pStats->cntContended = atomic_load_explicit(&pClass->cntContended, memory_order_relaxed);
+  pStats->cntOpen = atomic_load_explicit(&pClass->cntOpen, memory_order_relaxed);
+  return NUAN_OK;
+} /* vplatform_critsec_GetStats */
+
 
 /*===================================================================
 **  Definition of static interfaces
 **==================================================================*/
-/*
+
 static const VE_CRITSEC_INTERFACE     ICritSec = {
   vplatform_critsec_ObjOpen,
   vplatform_critsec_ObjClose,
   vplatform_critsec_Enter,
   vplatform_critsec_Leave
 };
-*/
 
 /* ******************************************************************
 **  PUBLIC INTERFACE RETRIEVAL FUNCTIONS
@@ -114,9 +267,21 @@ NUAN_ERROR vplatform_critsec_GetInterface(
   VE_INSTALL       * pInstall,
   VPLATFORM_RESOURCES * pResources)
 {
+  NUAN_CRITSEC_CLASS * pClass = NULL;
   (void) pResources;
-  pInstall->pICritSec = NULL; /*&ICritSec;*/
-  pInstall->hCSClass = NULL;
+
+  /* Every install has its own class, which collects the contention of its critical sections */
+  pClass = (NUAN_CRITSEC_CLASS *)vplatform_heap_Malloc(pInstall->hHeap, sizeof(NUAN_CRITSEC_CLASS));
+  if (pClass == NULL) {
+    return NUAN_E_MALLOC;
+  }
+  atomic_init(&pClass->cntEnter, 0);
+  atomic_init(&pClass->cntContended, 0);
+  atomic_init(&pClass->cntOpen, 0);
+  pClass->hHeap = pInstall->hHeap;
+
+  pInstall->pICritSec = &ICritSec;
+  pInstall->hCSClass = pClass;
   return NUAN_OK;
 } /* vplatform_critsec_GetInterface */
 
@@ -124,7 +289,10 @@ NUAN_ERROR vplatform_critsec_GetInterface(
 NUAN_ERROR vplatform_critsec_ReleaseInterface(
   void  * hCSClass)
 {
-  (void) hCSClass;
+  NUAN_CRITSEC_CLASS * pClass = (NUAN_CRITSEC_CLASS *)hCSClass;
+  if (pClass != NULL) {
+    vplatform_heap_Free(pClass->hHeap, pClass);
+  }
   return NUAN_OK;
 } /* vplatform_critsec_ReleaseInterface */
 
@@ -422,7 +422,7 @@ NUAN_ERROR vplatform_data_GetInterface(
   {
     /* Initialize the engine by finding individual *.hdr files in the
     ** configured installation paths */
-    fRet = vplatform_FindFiles((void * )pClass, hHeap,
+    fRet = vplatform_FindFilesIndexed((void * )pClass, hHeap,
                                pResources->u16NbrOfDataInstall,
                                (const PLATFORM_TCHAR * const *)pResources->apDataInstall,
                                &(pClass->szBrokerInfo),
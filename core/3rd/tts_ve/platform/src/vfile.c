@@ -22,6 +22,8 @@
 **  HEADER (INCLUDE) SECTION
 ** ******************************************************************/
 
+#define _FILE_OFFSET_BITS 64
+
 #include "vplatform.h"
 #include "vplatform_tchar.h"
 #include "vheap.h"
@@ -33,6 +35,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /* ******************************************************************
 **  COMPILER DIRECTIVES
@@ -43,13 +51,110 @@
 **  DEFINITIONS
 ** ******************************************************************/
 
-/*lint -esym(715, hHeap, hDataClass, pbIsDir, pszPath, pszDir) 
+/*lint -esym(715, hDataClass, pbIsDir, pszPath, pszDir) 
 **           not used in this implementation */
 
+/* Read-only files are mapped once per process, every engine opening the
+** same voice data reads the same pages of the page cache */
+typedef struct VPLATFORM_FILE_MAP_S {
+  dev_t                         dev;
+  ino_t                         ino;
+  const unsigned char         * pData;
+  size_t                        cSize;
+  unsigned int                  cRefs;
+  struct VPLATFORM_FILE_MAP_S * pNext;
+} VPLATFORM_FILE_MAP;
+
+/* File handle, either a mapped read-only file or a stdio one */
+typedef struct VPLATFORM_FILE_S {
+  FILE                * fp;
+  VPLATFORM_FILE_MAP  * pMap;
+  size_t                cPos;
+  void                * hHeap;
+} VPLATFORM_FILE_T;
+
+static pthread_mutex_t       mapsMutex = PTHREAD_MUTEX_INITIALIZER;
+static VPLATFORM_FILE_MAP  * pMaps = NULL;
+
 /* ******************************************************************
 **  LOCAL FUNCTIONS
 ** ******************************************************************/
 
+/*------------------------------------------------------------------*/
+static VPLATFORM_FILE_MAP * vplatform_file_AcquireMap(
+  const char  * szName)
+{
+  VPLATFORM_FILE_MAP * pMap = NULL;
+  struct stat          st;
+  void               * pData = NULL;
+  int                  fd = open(szName, O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&mapsMutex);
+  for (pMap = pMaps; pMap != NULL; pMap = pMap->pNext) {
+    if (pMap->dev == st.st_dev && pMap->ino == st.st_ino) {
+      ++pMap->cRefs;
+      pthread_mutex_unlock(&mapsMutex);
+      close(fd);
+      return pMap;
+    }
+  }
+
+  /* Empty files can't be mapped, they are read as zero bytes */
+  if (st.st_size > 0) {
+    pData = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (pData == MAP_FAILED) {
+      pthread_mutex_unlock(&mapsMutex);
+      close(fd);
+      return NULL;
+    }
+  }
+  close(fd);
+
+  pMap = (VPLATFORM_FILE_MAP *)malloc(sizeof(VPLATFORM_FILE_MAP));
+  if (pMap == NULL) {
+    if (pData != NULL) munmap(pData, (size_t)st.st_size);
+    pthread_mutex_unlock(&mapsMutex);
+    return NULL;
+  }
+  pMap->dev = st.st_dev;
+  pMap->ino = st.st_ino;
+  pMap->pData = (const unsigned char *)pData;
+  pMap->cSize = (size_t)st.st_size;
+  pMap->cRefs = 1;
+  pMap->pNext = pMaps;
+  pMaps = pMap;
+  pthread_mutex_unlock(&mapsMutex);
+  return pMap;
+}
+
+/*------------------------------------------------------------------*/
+static void vplatform_file_ReleaseMap(
+  VPLATFORM_FILE_MAP  * pMap)
+{
+  VPLATFORM_FILE_MAP ** ppMap = NULL;
+
+  pthread_mutex_lock(&mapsMutex);
+  if (--pMap->cRefs == 0) {
+    for (ppMap = &pMaps; *ppMap != NULL; ppMap = &(*ppMap)->pNext) {
+      if (*ppMap == pMap) {
+        *ppMap = pMap->pNext;
+        break;
+      }
+    }
+    if (pMap->pData != NULL) munmap((void *)pMap->pData, pMap->cSize);
+    free(pMap);
+  }
+  pthread_mutex_unlock(&mapsMutex);
+}
+
 /* ------------------------------------------------------------------
 **  FILE I/O
 ** -----------------------------------------------------------------*/
@@ -65,8 +170,34 @@ NUAN_ERROR vplatform_file_Open(
 #ifdef PLATFORM_UNICODE
   return NUAN_E_NOTIMPLEMENTED;
 #else
-  *phFile = (VPLATFORM_FILE_H *)fopen(szName, szMode);
-  return (*phFile == NULL) ? NUAN_E_COULDNOTOPENFILE : NUAN_OK;
+  VPLATFORM_FILE_T * pFile = NULL;
+
+  *phFile = NULL;
+  pFile = (VPLATFORM_FILE_T *)vplatform_heap_Calloc(hHeap, 1, sizeof(VPLATFORM_FILE_T));
+  if (pFile == NULL) {
+    return NUAN_E_MALLOC;
+  }
+  pFile->hHeap = hHeap;
+
+  /* Data files are only read, falling back to stdio if they can't be mapped */
+  if (szMode[0] == 'r' && strchr(szMode, '+') == NULL) {
+    pFile->pMap = vplatform_file_AcquireMap(szName);
+  }
+  if (pFile->pMap != NULL) {
+    /* Streams are copied to the engine heap from start to end */
+    if (pFile->pMap->pData != NULL) {
+      madvise((void *)pFile->pMap->pData, pFile->pMap->cSize, MADV_SEQUENTIAL);
+    }
+  } else {
+    pFile->fp = fopen(szName, szMode);
+    if (pFile->fp == NULL) {
+      vplatform_heap_Free(hHeap, pFile);
+      return NUAN_E_COULDNOTOPENFILE;
+    }
+  }
+
+  *phFile = (VPLATFORM_FILE_H)pFile;
+  return NUAN_OK;
 #endif
 }
 
@@ -104,13 +235,18 @@ endOpenUTF8:
 NUAN_ERROR vplatform_file_Close(
   VPLATFORM_FILE_H  hFile)
 {
-  NUAN_ERROR     fRet = NUAN_OK;
-  FILE          *fp = (FILE *) hFile;
+  NUAN_ERROR         fRet = NUAN_OK;
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
 
-  if (0 != fclose(fp))
+  if (pFile->pMap != NULL)
+  {
+    vplatform_file_ReleaseMap(pFile->pMap);
+  }
+  else if (0 != fclose(pFile->fp))
   {
     fRet = NUAN_E_FILECLOSE;
   }
+  vplatform_heap_Free(pFile->hHeap, pFile);
 
   return fRet;
 } /* vplatform_file_Close */
@@ -122,9 +258,22 @@ size_t vplatform_file_Read(
   size_t              cElements,
   VPLATFORM_FILE_H      hFile)
 {
-  FILE *fp = (FILE *) hFile;
-  size_t u32Read = fread(pBuffer, cElementBytes, cElements, fp);
-  return ((u32Read == 0) && (ferror(fp)) ? (size_t)0xffffffff : u32Read);
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
+  size_t u32Read = 0;
+
+  if (pFile->pMap != NULL)
+  {
+    /* Like fread() only whole elements are read */
+    if (cElementBytes == 0 || pFile->cPos >= pFile->pMap->cSize) return 0;
+    u32Read = (pFile->pMap->cSize - pFile->cPos) / cElementBytes;
+    if (u32Read > cElements) u32Read = cElements;
+    memcpy(pBuffer, pFile->pMap->pData + pFile->cPos, u32Read * cElementBytes);
+    pFile->cPos += u32Read * cElementBytes;
+    return u32Read;
+  }
+
+  u32Read = fread(pBuffer, cElementBytes, cElements, pFile->fp);
+  return ((u32Read == 0) && (ferror(pFile->fp)) ? (size_t)0xffffffff : u32Read);
 } /* vplatform_file_Read */
 /*------------------------------------------------------------------*/
 NUAN_ERROR vplatform_file_Seek(
@@ -134,8 +283,8 @@ NUAN_ERROR vplatform_file_Seek(
   VE_STREAM_DIRECTION      eDirection)
 {
   NUAN_ERROR fRet = NUAN_OK;
-  FILE *fp = (FILE *) hFile;
-  int iRet;
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
+  size_t cBase = 0;
   NUAN_S32 s32Origin;
   
   switch (eOrigin)
@@ -148,21 +297,27 @@ NUAN_ERROR vplatform_file_Seek(
     break;
   }
 
-  /* Not safe for files larger then 2 GB, but portable for
-  ** demonstration purposes. For production use we recommend a seek
-  ** method that supports files up to UINT_MAX, such as _fseeki64( )
-  ** for Windows OSes and fseeko( ) for many Unix variants. */
-  if (cOffset > INT_MAX)
+  if (pFile->pMap != NULL)
   {
-    fRet = NUAN_E_FILESEEK;
-  }
-  else
-  {
-    iRet = fseek(fp, eDirection * (long int) cOffset, (int) s32Origin);
-    if (iRet != 0)
+    /* Position may be past the end as with fseek(), reading there returns nothing */
+    cBase = (s32Origin == SEEK_SET) ? 0 : (s32Origin == SEEK_CUR) ? pFile->cPos : pFile->pMap->cSize;
+    if (eDirection == VE_STREAM_BACKWARD)
     {
-      fRet = NUAN_E_FILESEEK;
+      if (cOffset > cBase) return NUAN_E_FILESEEK;
+      pFile->cPos = cBase - cOffset;
     }
+    else
+    {
+      if (cOffset > SIZE_MAX - cBase) return NUAN_E_FILESEEK;
+      pFile->cPos = cBase + cOffset;
+    }
+    return NUAN_OK;
+  }
+
+  /* off_t is 64 bits wide, so files over 2 GB seek as well */
+  if (0 != fseeko(pFile->fp, (off_t)eDirection * (off_t)cOffset, (int) s32Origin))
+  {
+    fRet = NUAN_E_FILESEEK;
   }
   
   return fRet;
@@ -172,37 +327,47 @@ NUAN_ERROR vplatform_file_Seek(
 size_t vplatform_file_GetSize(
   VPLATFORM_FILE_H  hFile)
 {
-  NUAN_U32        u32FileSize = 0;
-  FILE           *fp = (FILE *) hFile;
-  NUAN_S32        s32Cur, s32Size;
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
+  struct stat        st;
 
-  /* Not safe for files larger then 2 GB, but portable for
-  ** demonstration purposes. For production use we recommend a file
-  ** size method that supports files up to UINT_MAX, such as _filelengthi64( )
-  ** for Windows OSes and fstat(fileno(fp), [...]) for many Unix variants. */
-  s32Cur = (NUAN_S32)ftell(fp);
-  if (s32Cur < 0) goto errorGetSize;
+  if (pFile->pMap != NULL)
+  {
+    return pFile->pMap->cSize;
+  }
 
-  if (0 != fseek(fp, 0, SEEK_END)) goto errorGetSize;
-  s32Size = (NUAN_S32)ftell(fp);
-  if (s32Size < 0) goto errorGetSize;
-  u32FileSize = (NUAN_U32)s32Size;
+  /* Buffered writes are counted as well */
+  if (0 != fflush(pFile->fp) || 0 != fstat(fileno(pFile->fp), &st))
+  {
+    /* return 0 if something is wrong */
+    return 0;
+  }
+  return (size_t)st.st_size;
+} /* vplatform_file_GetSize */
 
-  if (0 != fseek(fp, s32Cur, SEEK_SET)) goto errorGetSize;
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_file_GetData(
+  VPLATFORM_FILE_H    hFile,
+  const void       ** ppData,
+  size_t            * pcBytes)
+{
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
 
-  return u32FileSize;
-  
-errorGetSize:
-  /* return 0 if something is wrong */
-  return 0;
-} /* vplatform_file_GetSize */
+  if (pFile == NULL || pFile->pMap == NULL)
+  {
+    return NUAN_E_NOTIMPLEMENTED;
+  }
+  *ppData = pFile->pMap->pData;
+  *pcBytes = pFile->pMap->cSize;
+  return NUAN_OK;
+} /* vplatform_file_GetData */
 
 /*------------------------------------------------------------------*/
 NUAN_ERROR vplatform_file_Error(
   VPLATFORM_FILE_H  hFile)
 {
-  FILE *fp = (FILE *) hFile;
-  return (ferror(fp) ? NUAN_E_FILEREADERROR : NUAN_OK);
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
+  if (pFile->pMap != NULL) return NUAN_OK;
+  return (ferror(pFile->fp) ? NUAN_E_FILEREADERROR : NUAN_OK);
 } /* vplatform_file_Error */
 
 /*------------------------------------------------------------------*/
@@ -210,9 +375,9 @@ NUAN_ERROR vplatform_file_Flush(
   VPLATFORM_FILE_H  hFile)
 {
   NUAN_ERROR     fRet = NUAN_OK;
-  FILE *fp = (FILE *) hFile;
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
   
-  if (0 != fflush(fp))
+  if (pFile->pMap != NULL || 0 != fflush(pFile->fp))
   {
     fRet = NUAN_E_FILEWRITEERROR;
   }
@@ -227,8 +392,9 @@ size_t vplatform_file_Write(
   size_t                cElements,
   VPLATFORM_FILE_H      hFile)
 {
-  FILE *fp = (FILE *) hFile;
-  return fwrite(pBuffer, cElementBytes, cElements, fp);
+  VPLATFORM_FILE_T * pFile = (VPLATFORM_FILE_T *) hFile;
+  if (pFile->pMap != NULL) return 0;
+  return fwrite(pBuffer, cElementBytes, cElements, pFile->fp);
 } /* vplatform_file_Write */
 
 /*------------------------------------------------------------------*/
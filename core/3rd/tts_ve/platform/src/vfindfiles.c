@@ -23,6 +23,9 @@
 ** ******************************************************************/
 
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include "vplatform.h"
 #include "vplatform_tchar.h"
@@ -37,6 +40,37 @@
 /* Class structure for the data interface */
 #include "vdatapriv.h"
 
+/* Index of the install directories, so every engine of the process after
+** the first one doesn't walk them again. The index holds the stat of every
+** directory, header and data file found, and is used while none of them
+** has changed */
+typedef enum { VPLATFORM_INDEX_DIR, VPLATFORM_INDEX_HDR, VPLATFORM_INDEX_DATA } VPLATFORM_INDEX_TYPE;
+
+typedef struct VPLATFORM_INDEX_ENTRY_S {
+  VPLATFORM_INDEX_TYPE              eType;
+  NUAN_BOOL                         bExists;
+  off_t                             size;
+  struct timespec                   mtime;
+  char                            * szPath;
+  char                            * szBrokerString;   /* Data files only */
+  struct VPLATFORM_INDEX_ENTRY_S  * pNext;
+} VPLATFORM_INDEX_ENTRY;
+
+typedef struct VPLATFORM_INDEX_S {
+  NUAN_U16                          u16NbrOfPaths;
+  char                           ** aszPaths;
+  NUAN_BOOL                         bRecurse;
+  char                            * szBrokerInfo;
+  VPLATFORM_INDEX_ENTRY           * pEntries;
+  VPLATFORM_INDEX_ENTRY          ** ppLastEntry;
+  NUAN_BOOL                         bFailed;          /* Out of memory while recording */
+  struct VPLATFORM_INDEX_S        * pNext;
+} VPLATFORM_INDEX;
+
+static pthread_mutex_t               indexMutex = PTHREAD_MUTEX_INITIALIZER;
+static VPLATFORM_INDEX             * pIndexes = NULL;
+static VPLATFORM_DATA_INDEX_STATS    indexStats = { 0, 0 };
+
 /* ******************************************************************
 **  LOCAL FUNCTION PROTOTYPES
 ** ******************************************************************/
@@ -83,13 +117,230 @@ static NUAN_ERROR vplatform_WalkDir(
   char                           ** pszBrokerInfo,
   VPLATFORM_FILELIST             ** ppFileList,
   NUAN_BOOL                         bRecurse,
-  NUAN_BOOL                         bAdd
+  NUAN_BOOL                         bAdd,
+  VPLATFORM_INDEX                 * pIndex
+);
+
+/*-------------------------------------------------------------------
+**  @func   Records the current stat of <p szPath> in the index
+**  @comm   Does nothing if <p pIndex> is NULL
+**  @rdesc  void
+**------------------------------------------------------------------*/
+static void vplatform_IndexAdd(
+  VPLATFORM_INDEX                 * pIndex,
+  VPLATFORM_INDEX_TYPE              eType,
+  const char                      * szPath,
+  const char                      * szBrokerString
 );
 
 /* ******************************************************************
 **  LOCAL FUNCTION DEFINITIONS
 ** ******************************************************************/
 
+/*-----------------------------------------------------------------*/
+static char * vplatform_IndexCopy(const char * sz)
+{
+    char * szCopy = (char *)malloc(strlen(sz) + 1);
+    if (szCopy != NULL) strcpy(szCopy, sz);
+    return szCopy;
+} /* vplatform_IndexCopy */
+
+/*-----------------------------------------------------------------*/
+static void vplatform_IndexStat(
+    VPLATFORM_INDEX_ENTRY * pEntry,
+    const char            * szPath)
+{
+    struct stat st;
+
+    pEntry->bExists = (stat(szPath, &st) == 0) ? NUAN_TRUE : NUAN_FALSE;
+    pEntry->size = pEntry->bExists ? st.st_size : 0;
+    pEntry->mtime.tv_sec = pEntry->bExists ? st.st_mtim.tv_sec : 0;
+    pEntry->mtime.tv_nsec = pEntry->bExists ? st.st_mtim.tv_nsec : 0;
+} /* vplatform_IndexStat */
+
+/*-----------------------------------------------------------------*/
+static void vplatform_IndexAdd(
+  VPLATFORM_INDEX                 * pIndex,
+  VPLATFORM_INDEX_TYPE              eType,
+  const char                      * szPath,
+  const char                      * szBrokerString)
+{
+    VPLATFORM_INDEX_ENTRY * pEntry = NULL;
+
+    if ((pIndex == NULL) || (pIndex->bFailed == NUAN_TRUE)) return;
+
+    pEntry = (VPLATFORM_INDEX_ENTRY *)calloc(1, sizeof(VPLATFORM_INDEX_ENTRY));
+    if (pEntry != NULL)
+    {
+        pEntry->eType = eType;
+        pEntry->szPath = vplatform_IndexCopy(szPath);
+        if (szBrokerString != NULL) pEntry->szBrokerString = vplatform_IndexCopy(szBrokerString);
+    }
+    if ((pEntry == NULL) || (pEntry->szPath == NULL) ||
+        ((szBrokerString != NULL) && (pEntry->szBrokerString == NULL)))
+    {
+        if (pEntry != NULL)
+        {
+            free(pEntry->szPath);
+            free(pEntry);
+        }
+        pIndex->bFailed = NUAN_TRUE;
+        return;
+    }
+
+    vplatform_IndexStat(pEntry, szPath);
+    *pIndex->ppLastEntry = pEntry;
+    pIndex->ppLastEntry = &pEntry->pNext;
+} /* vplatform_IndexAdd */
+
+/*-----------------------------------------------------------------*/
+static void vplatform_IndexFree(
+    VPLATFORM_INDEX * pIndex)
+{
+    VPLATFORM_INDEX_ENTRY * pEntry = pIndex->pEntries;
+    NUAN_U16 i;
+
+    while (pEntry != NULL)
+    {
+        VPLATFORM_INDEX_ENTRY * pNext = pEntry->pNext;
+        free(pEntry->szPath);
+        free(pEntry->szBrokerString);
+        free(pEntry);
+        pEntry = pNext;
+    }
+    for (i = 0; (pIndex->aszPaths != NULL) && (i < pIndex->u16NbrOfPaths); i++)
+    {
+        free(pIndex->aszPaths[i]);
+    }
+    free(pIndex->aszPaths);
+    free(pIndex->szBrokerInfo);
+    free(pIndex);
+} /* vplatform_IndexFree */
+
+/*-----------------------------------------------------------------*/
+static VPLATFORM_INDEX * vplatform_IndexCreate(
+        NUAN_U16                    u16NbrOfDataInstallPaths,
+  const PLATFORM_TCHAR    * const * aszDataInstallPaths,
+        NUAN_BOOL                   bRecurse)
+{
+    VPLATFORM_INDEX * pIndex = (VPLATFORM_INDEX *)calloc(1, sizeof(VPLATFORM_INDEX));
+    NUAN_U16 i;
+
+    if (pIndex == NULL) return NULL;
+    pIndex->ppLastEntry = &pIndex->pEntries;
+    pIndex->bRecurse = bRecurse;
+    pIndex->aszPaths = (char **)calloc(u16NbrOfDataInstallPaths, sizeof(char *));
+    if (pIndex->aszPaths == NULL)
+    {
+        vplatform_IndexFree(pIndex);
+        return NULL;
+    }
+    pIndex->u16NbrOfPaths = u16NbrOfDataInstallPaths;
+    for (i = 0; i < u16NbrOfDataInstallPaths; i++)
+    {
+        pIndex->aszPaths[i] = vplatform_IndexCopy(aszDataInstallPaths[i]);
+        if (pIndex->aszPaths[i] == NULL)
+        {
+            vplatform_IndexFree(pIndex);
+            return NULL;
+        }
+    }
+    return pIndex;
+} /* vplatform_IndexCreate */
+
+/*-----------------------------------------------------------------*/
+static NUAN_BOOL vplatform_IndexMatches(
+    const VPLATFORM_INDEX     * pIndex,
+          NUAN_U16              u16NbrOfDataInstallPaths,
+    const PLATFORM_TCHAR * const * aszDataInstallPaths,
+          NUAN_BOOL             bRecurse)
+{
+    NUAN_U16 i;
+
+    if ((pIndex->u16NbrOfPaths != u16NbrOfDataInstallPaths) || (pIndex->bRecurse != bRecurse)) return NUAN_FALSE;
+    for (i = 0; i < u16NbrOfDataInstallPaths; i++)
+    {
+        if (strcmp(pIndex->aszPaths[i], aszDataInstallPaths[i]) != 0) return NUAN_FALSE;
+    }
+    return NUAN_TRUE;
+} /* vplatform_IndexMatches */
+
+/*-----------------------------------------------------------------*/
+/* Files added to or removed from a directory change its mtime, replaced
+** files change their own size or mtime */
+static NUAN_BOOL vplatform_IndexIsValid(
+    const VPLATFORM_INDEX * pIndex)
+{
+    const VPLATFORM_INDEX_ENTRY * pEntry = NULL;
+    VPLATFORM_INDEX_ENTRY current;
+
+    for (pEntry = pIndex->pEntries; pEntry != NULL; pEntry = pEntry->pNext)
+    {
+        vplatform_IndexStat(&current, pEntry->szPath);
+        if ((current.bExists != pEntry->bExists) ||
+            (current.mtime.tv_sec != pEntry->mtime.tv_sec) ||
+            (current.mtime.tv_nsec != pEntry->mtime.tv_nsec) ||
+            ((pEntry->eType != VPLATFORM_INDEX_DIR) && (current.size != pEntry->size)))
+        {
+            return NUAN_FALSE;
+        }
+    }
+    return NUAN_TRUE;
+} /* vplatform_IndexIsValid */
+
+/*-----------------------------------------------------------------*/
+/* Copies the indexed broker info and data files to the data class heap */
+static NUAN_ERROR vplatform_IndexLoad(
+        void *                      hDataClass,
+        void *                      hHeap,
+  const VPLATFORM_INDEX           * pIndex,
+        char                     ** pszBrokerInfo,
+        VPLATFORM_FILELIST       ** ppFileList)
+{
+    NUAN_ERROR fRet = NUAN_OK;
+    VPLATFORM_DATA_CLASS_T * pClass = (VPLATFORM_DATA_CLASS_T *)hDataClass;
+    const VPLATFORM_INDEX_ENTRY * pEntry = NULL;
+
+    if ((pszBrokerInfo != NULL) && (pIndex->szBrokerInfo != NULL))
+    {
+        *pszBrokerInfo = (char *)vplatform_heap_Calloc(hHeap, strlen(pIndex->szBrokerInfo) + 1, 1);
+        if (*pszBrokerInfo == NULL) return NUAN_E_OUTOFMEMORY;
+        strcpy(*pszBrokerInfo, pIndex->szBrokerInfo);
+    }
+
+    for (pEntry = pIndex->pEntries; (fRet == NUAN_OK) && (pEntry != NULL); pEntry = pEntry->pNext)
+    {
+        char * szBrokerString = NULL;
+        PLATFORM_TCHAR * szFullPath = NULL;
+
+        if (pEntry->eType != VPLATFORM_INDEX_DATA) continue;
+
+        szBrokerString = (char *)vplatform_heap_Malloc(hHeap, strlen(pEntry->szBrokerString) + 1);
+        szFullPath = (PLATFORM_TCHAR *)vplatform_heap_Malloc(hHeap, strlen(pEntry->szPath) + 1);
+        if ((szBrokerString == NULL) || (szFullPath == NULL))
+        {
+            if (szBrokerString != NULL) vplatform_heap_Free(hHeap, szBrokerString);
+            if (szFullPath != NULL) vplatform_heap_Free(hHeap, szFullPath);
+            return NUAN_E_OUTOFMEMORY;
+        }
+        strcpy(szBrokerString, pEntry->szBrokerString);
+        strcpy(szFullPath, pEntry->szPath);
+
+        fRet = vplatform_AddFileToFileList(hDataClass, szFullPath, szBrokerString, ppFileList);
+        if (fRet == NUAN_W_ALREADYPRESENT)
+        {
+            vplatform_heap_Free(hHeap, szBrokerString);
+            vplatform_heap_Free(hHeap, szFullPath);
+            fRet = NUAN_OK;
+        }
+        if ((fRet == NUAN_OK) && (pClass->bErrorCheck == NUAN_FALSE))
+        {
+            ppFileList = &((*ppFileList)->pNext); /* small optimization if no error checking */
+        }
+    }
+    return fRet;
+} /* vplatform_IndexLoad */
+
 /*-----------------------------------------------------------------*/
 static NUAN_BOOL vplatform_CmpFilePaths(
     PLATFORM_TCHAR *szFile1,
@@ -163,7 +414,8 @@ static NUAN_ERROR vplatform_WalkDir(
   char                           ** pszBrokerInfo,
   VPLATFORM_FILELIST             ** ppFileList,
   NUAN_BOOL                         bRecurse,
-  NUAN_BOOL                         bAdd)
+  NUAN_BOOL                         bAdd,
+  VPLATFORM_INDEX                 * pIndex)
 {
   NUAN_ERROR fRet = NUAN_OK, fRet2 = NUAN_OK;
   VPLATFORM_DATA_CLASS_T * pClass = (VPLATFORM_DATA_CLASS_T *)hDataClass;
@@ -181,6 +433,7 @@ static NUAN_ERROR vplatform_WalkDir(
 
   /* Recursively walk a directory tree, adding paths to data
   ** components to pszDataPaths */
+  vplatform_IndexAdd(pIndex, VPLATFORM_INDEX_DIR, szRoot, NULL);
 
   fRet = vplatform_find_Open(hDataClass, hHeap, szRoot, &szElem, &eType, &hFind);
   /* vplatform_find_Open() and vplatform_find_Next() return
@@ -200,7 +453,7 @@ static NUAN_ERROR vplatform_WalkDir(
         }
         else
         {
-          fRet = vplatform_WalkDir(hDataClass, hHeap, szFullPath, pszBrokerInfo, ppFileList, bRecurse, bAdd);
+          fRet = vplatform_WalkDir(hDataClass, hHeap, szFullPath, pszBrokerInfo, ppFileList, bRecurse, bAdd, pIndex);
           vplatform_heap_Free(hHeap, szFullPath);
         }
       }
@@ -214,6 +467,7 @@ static NUAN_ERROR vplatform_WalkDir(
         }
         else
         {
+          vplatform_IndexAdd(pIndex, VPLATFORM_INDEX_HDR, szFullPath, NULL);
           fRet = vplatform_AddHdrToBrokerInfo(hDataClass, hHeap, szFullPath, pszBrokerInfo);
           vplatform_heap_Free(hHeap, szFullPath);
         }
@@ -242,6 +496,7 @@ static NUAN_ERROR vplatform_WalkDir(
             }
             else
             {
+              vplatform_IndexAdd(pIndex, VPLATFORM_INDEX_DATA, szFullPath, szBrokerString);
               fRet = vplatform_AddFileToFileList(hDataClass, szFullPath, szBrokerString, ppFileList);
               if (fRet == NUAN_W_ALREADYPRESENT)
               {
@@ -329,6 +584,66 @@ NUAN_ERROR vplatform_BuildBrokerIdFromFullPath(
     return NUAN_OK;
 } /* vplatform_BuildBrokerIdFromFullPath */
 
+/*------------------------------------------------------------------*/
+static NUAN_ERROR vplatform_FindFilesToIndex(
+        void *        hDataClass,
+        void *    hHeap,
+        NUAN_U16                    u16NbrOfDataInstallPaths,
+  const PLATFORM_TCHAR    * const * aszDataInstallPaths,
+        char                     ** pszBrokerInfo,
+        VPLATFORM_FILELIST       ** ppFileList,
+        NUAN_BOOL                   bRecurse,
+        VPLATFORM_INDEX           * pIndex)
+{
+    NUAN_ERROR fRet = NUAN_OK;
+    NUAN_U16 i;
+
+    if ( (u16NbrOfDataInstallPaths == 0) || (ppFileList == NULL) )
+        return NUAN_E_INVALIDARG;
+
+    if (pszBrokerInfo != NULL) *pszBrokerInfo = NULL;
+
+    /* Walk the installation directories to load the *.hdr files */
+    for (i = 0; (fRet == NUAN_OK) && (i < u16NbrOfDataInstallPaths); i++)
+    {
+        NUAN_BOOL bIsDir = NUAN_TRUE;
+        fRet = vplatform_file_IsDirectory(hDataClass, aszDataInstallPaths[i], &bIsDir);
+        if (fRet == NUAN_E_NOTIMPLEMENTED)
+        {
+            bIsDir = NUAN_TRUE;
+            fRet = NUAN_OK;
+        }
+        if (fRet == NUAN_OK)
+        {
+            if (bIsDir == NUAN_TRUE)
+            {
+                fRet = vplatform_WalkDir(hDataClass, hHeap, aszDataInstallPaths[i],
+                                        pszBrokerInfo, ppFileList, bRecurse, NUAN_TRUE, pIndex);
+            }
+            else
+            {
+                char * szBrokerString = NULL;
+                PLATFORM_TCHAR *szFullPath = NULL;
+                fRet = vplatform_BuildBrokerIdFromFullPath(hHeap, aszDataInstallPaths[i], &szBrokerString, &szFullPath);
+                if (fRet == NUAN_OK)
+                {
+                    vplatform_IndexAdd(pIndex, VPLATFORM_INDEX_DATA, szFullPath, szBrokerString);
+                    fRet = vplatform_AddFileToFileList(hDataClass, szFullPath, szBrokerString, ppFileList);
+                    if (fRet == NUAN_W_ALREADYPRESENT)
+                    {
+                        vplatform_heap_Free(hHeap, szBrokerString);
+                        vplatform_heap_Free(hHeap, szFullPath);
+                        fRet = NUAN_OK;
+                    }
+                }
+            }
+        }
+  }
+
+  /* Clean up if this fails should be done by the caller */
+  return fRet;
+} /* vplatform_FindFilesToIndex */
+
 /* ******************************************************************
 **  GLOBAL FUNCTIONS (prototypes in header file)
 ** ******************************************************************/
@@ -446,53 +761,81 @@ NUAN_ERROR vplatform_FindFiles(
         VPLATFORM_FILELIST       ** ppFileList,
         NUAN_BOOL                   bRecurse)
 {
-    NUAN_ERROR fRet = NUAN_OK;
-    NUAN_U16 i;
+  return vplatform_FindFilesToIndex(hDataClass, hHeap, u16NbrOfDataInstallPaths, aszDataInstallPaths,
+                                    pszBrokerInfo, ppFileList, bRecurse, NULL);
+} /* vplatform_FindFiles */
 
-    if ( (u16NbrOfDataInstallPaths == 0) || (ppFileList == NULL) )
-        return NUAN_E_INVALIDARG;
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_FindFilesIndexed(
+        void *        hDataClass,
+        void *    hHeap,
+        NUAN_U16                    u16NbrOfDataInstallPaths,
+  const PLATFORM_TCHAR    * const * aszDataInstallPaths,
+        char                     ** pszBrokerInfo,
+        VPLATFORM_FILELIST       ** ppFileList,
+        NUAN_BOOL                   bRecurse)
+{
+  NUAN_ERROR fRet = NUAN_OK;
+  VPLATFORM_INDEX ** ppIndex = NULL;
+  VPLATFORM_INDEX * pIndex = NULL;
 
-    if (pszBrokerInfo != NULL) *pszBrokerInfo = NULL;
+  if ( (u16NbrOfDataInstallPaths == 0) || (ppFileList == NULL) )
+      return NUAN_E_INVALIDARG;
 
-    /* Walk the installation directories to load the *.hdr files */
-    for (i = 0; (fRet == NUAN_OK) && (i < u16NbrOfDataInstallPaths); i++)
+  if (pszBrokerInfo != NULL) *pszBrokerInfo = NULL;
+
+  /* Engines created at the same time wait for the first walk and use its index */
+  pthread_mutex_lock(&indexMutex);
+  for (ppIndex = &pIndexes; *ppIndex != NULL; ppIndex = &(*ppIndex)->pNext)
+  {
+    if (vplatform_IndexMatches(*ppIndex, u16NbrOfDataInstallPaths, aszDataInstallPaths, bRecurse))
     {
-        NUAN_BOOL bIsDir = NUAN_TRUE;
-        fRet = vplatform_file_IsDirectory(hDataClass, aszDataInstallPaths[i], &bIsDir);
-        if (fRet == NUAN_E_NOTIMPLEMENTED)
-        {
-            bIsDir = NUAN_TRUE;
-            fRet = NUAN_OK;
-        }
-        if (fRet == NUAN_OK)
-        {
-            if (bIsDir == NUAN_TRUE)
-            {
-                fRet = vplatform_WalkDir(hDataClass, hHeap, aszDataInstallPaths[i],
-                                        pszBrokerInfo, ppFileList, bRecurse, NUAN_TRUE);
-            }
-            else
-            {
-                char * szBrokerString = NULL;
-                PLATFORM_TCHAR *szFullPath = NULL;
-                fRet = vplatform_BuildBrokerIdFromFullPath(hHeap, aszDataInstallPaths[i], &szBrokerString, &szFullPath);
-                if (fRet == NUAN_OK)
-                {
-                    fRet = vplatform_AddFileToFileList(hDataClass, szFullPath, szBrokerString, ppFileList);
-                    if (fRet == NUAN_W_ALREADYPRESENT)
-                    {
-                        vplatform_heap_Free(hHeap, szBrokerString);
-                        vplatform_heap_Free(hHeap, szFullPath);
-                        fRet = NUAN_OK;
-                    }
-                }
-            }
-        }
+      pIndex = *ppIndex;
+      if (vplatform_IndexIsValid(pIndex))
+      {
+        indexStats.cntHits++;
+        fRet = vplatform_IndexLoad(hDataClass, hHeap, pIndex, pszBrokerInfo, ppFileList);
+        pthread_mutex_unlock(&indexMutex);
+        return fRet;
+      }
+      *ppIndex = pIndex->pNext;
+      vplatform_IndexFree(pIndex);
+      break;
+    }
+  }
+
+  indexStats.cntMisses++;
+  pIndex = vplatform_IndexCreate(u16NbrOfDataInstallPaths, aszDataInstallPaths, bRecurse);
+  fRet = vplatform_FindFilesToIndex(hDataClass, hHeap, u16NbrOfDataInstallPaths, aszDataInstallPaths,
+                                    pszBrokerInfo, ppFileList, bRecurse, pIndex);
+  if ((pIndex != NULL) && (fRet == NUAN_OK) && (pIndex->bFailed == NUAN_FALSE) && (pszBrokerInfo != NULL) &&
+      ((*pszBrokerInfo == NULL) || ((pIndex->szBrokerInfo = vplatform_IndexCopy(*pszBrokerInfo)) != NULL)))
+  {
+    pIndex->pNext = pIndexes;
+    pIndexes = pIndex;
+  }
+  else if (pIndex != NULL)
+  {
+    /* The walk is still used, only it isn't indexed */
+    vplatform_IndexFree(pIndex);
   }
+  pthread_mutex_unlock(&indexMutex);
 
   /* Clean up if this fails should be done by the caller */
   return fRet;
-} /* vplatform_FindFiles */
+} /* vplatform_FindFilesIndexed */
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_data_GetIndexStats(
+  VPLATFORM_DATA_INDEX_STATS * pStats)
+{
+  if (pStats == NULL) return NUAN_E_NULLPOINTER;
+
+  pthread_mutex_lock(&indexMutex);
+  *pStats = indexStats;
+  pthread_mutex_unlock(&indexMutex);
+  return NUAN_OK;
+} /* vplatform_data_GetIndexStats */
 
 /*------------------------------------------------------------------*/
 NUAN_ERROR vplatform_RemoveFiles(
@@ -524,7 +867,7 @@ NUAN_ERROR vplatform_RemoveFiles(
             if (bIsDir == NUAN_TRUE)
             {
                 fRet = vplatform_WalkDir(hDataClass, hHeap, aszDataInstallPaths[i],
-                                         NULL, ppFileList, bRecurse, NUAN_FALSE);
+                                         NULL, ppFileList, bRecurse, NUAN_FALSE, NULL);
             }
             else
             {
@@ -85,6 +85,24 @@ NUAN_ERROR vplatform_FindFiles(
 
 );
 
+/*-------------------------------------------------------------------
+**  @func   Same as vplatform_FindFiles, but uses the process wide index
+**          of the install directories when none of the indexed
+**          directories and files has changed since it was built.
+**  @comm   The index is built by the first call for the paths and
+**          rebuilt by the call that finds it outdated.
+**  @rdesc  error code.
+**------------------------------------------------------------------*/
+NUAN_ERROR vplatform_FindFilesIndexed(
+        void *                      hDataClass,
+        void *                      hHeap,
+        NUAN_U16                    u16NbrOfDataInstallPaths,
+  const PLATFORM_TCHAR    * const * aszDataInstallPaths,
+        char                     ** pszBrokerInfo,
+        VPLATFORM_FILELIST       ** pFileList,
+        NUAN_BOOL                   bRecurse
+);
+
 /*-------------------------------------------------------------------
 **  @func   Searches for *.dat files
 **          under the <p u16NbrOfDataInstallPaths> directories in
@@ -26,6 +26,9 @@
 #include "vheap.h"
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
 
 /* ******************************************************************
 **  COMPILER DIRECTIVES
@@ -36,20 +39,181 @@
 **  DEFINITIONS
 ** ******************************************************************/
 
-/*lint -esym(715, hHeap, pResources) 
+/*lint -esym(715, pResources) 
 **           not used in this implementation */
 
+#define NUAN_HEAP_HCHECK     246813
+
+#define HEAP_CHUNK_SIZE      (64 * 1024)   /* Blocks of the size classes are carved from the chunks */
+#define HEAP_CLASS_COUNT     15
+#define HEAP_CLASS_LARGE     HEAP_CLASS_COUNT
+#define HEAP_GRANULE         16
+
+/* Block sizes, with the header, grow by half of the power of two so
+** a block wastes at most a third of its size */
+static const size_t aClassSize[HEAP_CLASS_COUNT] = {
+  32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+#define HEAP_MAX_CLASS_SIZE  4096
+
+/* Header in front of every block keeps the payload aligned as malloc() does */
+typedef struct HEAP_BLOCK_HDR_S {
+  _Alignas(max_align_t) size_t  cBytes;   /* Requested size */
+  NUAN_U32  iClass;                       /* HEAP_CLASS_LARGE for blocks taken right from the C library */
+} HEAP_BLOCK_HDR;
+
+typedef struct HEAP_FREE_BLOCK_S {
+  struct HEAP_FREE_BLOCK_S * pNext;
+} HEAP_FREE_BLOCK;
+
+typedef struct HEAP_CHUNK_HDR_S {
+  _Alignas(max_align_t) struct HEAP_CHUNK_HDR_S * pNext;
+} HEAP_CHUNK_HDR;
+
+typedef struct NUAN_HEAP_S {
+  NUAN_U32              u32Check;
+  pthread_mutex_t       mutex;
+  HEAP_FREE_BLOCK     * apFree[HEAP_CLASS_COUNT];
+  HEAP_CHUNK_HDR      * pChunks;
+  char                * pBump;      /* Free tail of the last chunk */
+  char                * pBumpEnd;
+  unsigned char         aClassOf[HEAP_MAX_CLASS_SIZE / HEAP_GRANULE + 1];
+  VPLATFORM_HEAP_STATS  stats;
+} NUAN_HEAP;
+
+/* ******************************************************************
+**  LOCAL FUNCTIONS
+** ******************************************************************/
+
+/*------------------------------------------------------------------*/
+static HEAP_BLOCK_HDR * vplatform_heap_Header(void * pData)
+{
+  return (HEAP_BLOCK_HDR *)pData - 1;
+}
+
+/*------------------------------------------------------------------*/
+static void vplatform_heap_AddInUse(NUAN_HEAP * pHeap, size_t cBytes)
+{
+  ++pHeap->stats.cntAlloc;
+  pHeap->stats.cBytesInUse += cBytes;
+  if (pHeap->stats.cBytesInUse > pHeap->stats.cBytesPeak) {
+    pHeap->stats.cBytesPeak = pHeap->stats.cBytesInUse;
+  }
+}
+
+/*------------------------------------------------------------------*/
+static void vplatform_heap_AddReserved(NUAN_HEAP * pHeap, size_t cBytes)
+{
+  pHeap->stats.cBytesReserved += cBytes;
+  if (pHeap->stats.cBytesReserved > pHeap->stats.cBytesPeakReserved) {
+    pHeap->stats.cBytesPeakReserved = pHeap->stats.cBytesReserved;
+  }
+}
+
+/*------------------------------------------------------------------*/
+/* Called with the heap mutex locked */
+static void * vplatform_heap_PoolAlloc(NUAN_HEAP * pHeap, size_t cBytes)
+{
+  const size_t cTotal = cBytes + sizeof(HEAP_BLOCK_HDR);
+  HEAP_BLOCK_HDR * pBlock = NULL;
+  NUAN_U32 iClass = HEAP_CLASS_LARGE;
+
+  if (cTotal < cBytes) {
+    return NULL;
+  }
+
+  if (cTotal <= HEAP_MAX_CLASS_SIZE) {
+    iClass = pHeap->aClassOf[(cTotal + HEAP_GRANULE - 1) / HEAP_GRANULE];
+    if (pHeap->apFree[iClass] != NULL) {
+      pBlock = (HEAP_BLOCK_HDR *)pHeap->apFree[iClass];
+      pHeap->apFree[iClass] = pHeap->apFree[iClass]->pNext;
+    } else {
+      if ((size_t)(pHeap->pBumpEnd - pHeap->pBump) < aClassSize[iClass]) {
+        /* The tail of the previous chunk stays unused */
+        HEAP_CHUNK_HDR * pChunk = (HEAP_CHUNK_HDR *)malloc(HEAP_CHUNK_SIZE);
+        if (pChunk == NULL) {
+          return NULL;
+        }
+        pChunk->pNext = pHeap->pChunks;
+        pHeap->pChunks = pChunk;
+        pHeap->pBump = (char *)(pChunk + 1);
+        pHeap->pBumpEnd = (char *)pChunk + HEAP_CHUNK_SIZE;
+        vplatform_heap_AddReserved(pHeap, HEAP_CHUNK_SIZE);
+      }
+      pBlock = (HEAP_BLOCK_HDR *)pHeap->pBump;
+      pHeap->pBump += aClassSize[iClass];
+    }
+    pHeap->stats.cBytesPooled += aClassSize[iClass];
+  } else {
+    pBlock = (HEAP_BLOCK_HDR *)malloc(cTotal);
+    if (pBlock == NULL) {
+      return NULL;
+    }
+    ++pHeap->stats.cntLarge;
+    vplatform_heap_AddReserved(pHeap, cTotal);
+  }
+
+  pBlock->cBytes = cBytes;
+  pBlock->iClass = iClass;
+  vplatform_heap_AddInUse(pHeap, cBytes);
+  return pBlock + 1;
+}
+
+/*------------------------------------------------------------------*/
+/* Called with the heap mutex locked */
+static void vplatform_heap_PoolFree(NUAN_HEAP * pHeap, void * pData)
+{
+  HEAP_BLOCK_HDR * pBlock = vplatform_heap_Header(pData);
+  const NUAN_U32 iClass = pBlock->iClass;
+
+  ++pHeap->stats.cntFree;
+  pHeap->stats.cBytesInUse -= pBlock->cBytes;
+  if (iClass == HEAP_CLASS_LARGE) {
+    pHeap->stats.cBytesReserved -= pBlock->cBytes + sizeof(HEAP_BLOCK_HDR);
+    free(pBlock);
+    return;
+  }
+  pHeap->stats.cBytesPooled -= aClassSize[iClass];
+  ((HEAP_FREE_BLOCK *)pBlock)->pNext = pHeap->apFree[iClass];
+  pHeap->apFree[iClass] = (HEAP_FREE_BLOCK *)pBlock;
+}
+
+/*------------------------------------------------------------------*/
+static NUAN_HEAP * vplatform_heap_Validate(void * hHeap)
+{
+  NUAN_HEAP * pHeap = (NUAN_HEAP *)hHeap;
+  if (pHeap == NULL || pHeap->u32Check != NUAN_HEAP_HCHECK) {
+    return NULL;
+  }
+  return pHeap;
+}
+
+/* ******************************************************************
+**  FUNCTIONS
+** ******************************************************************/
 
 /* ------------------------------------------------------------------
 **  Heap service
 ** -----------------------------------------------------------------*/
 
+/* Without the heap handle the memory comes right from the C library */
+
 /*------------------------------------------------------------------*/
 void* vplatform_heap_Malloc(
   void *   hHeap,
   size_t                     cBytes)
 {
-  return malloc(cBytes);
+  NUAN_HEAP * pHeap = (NUAN_HEAP *)hHeap;
+  void * pData = NULL;
+
+  if (pHeap == NULL) {
+    return malloc(cBytes);
+  }
+  pthread_mutex_lock(&pHeap->mutex);
+  pData = vplatform_heap_PoolAlloc(pHeap, cBytes);
+  pthread_mutex_unlock(&pHeap->mutex);
+  return pData;
 } /* vplatform_heap_Malloc */
 
 /*------------------------------------------------------------------*/
@@ -58,7 +222,19 @@ void* vplatform_heap_Calloc(
   size_t                     cElements,
   size_t                     cElementBytes)
 {
-  return calloc(cElements, cElementBytes);
+  void * pData = NULL;
+
+  if (hHeap == NULL) {
+    return calloc(cElements, cElementBytes);
+  }
+  if (cElementBytes != 0 && cElements > (size_t)-1 / cElementBytes) {
+    return NULL;
+  }
+  pData = vplatform_heap_Malloc(hHeap, cElements * cElementBytes);
+  if (pData != NULL) {
+    memset(pData, 0, cElements * cElementBytes);
+  }
+  return pData;
 } /* vplatform_heap_Calloc */
 
 /*------------------------------------------------------------------*/
@@ -67,7 +243,43 @@ void* vplatform_heap_Realloc(
   void                       * pData,
   size_t                       cBytes)
 {
-  return realloc(pData, cBytes);
+  NUAN_HEAP * pHeap = (NUAN_HEAP *)hHeap;
+  HEAP_BLOCK_HDR * pBlock = NULL;
+  void * pNewData = NULL;
+
+  if (pHeap == NULL) {
+    return realloc(pData, cBytes);
+  }
+  if (pData == NULL) {
+    return vplatform_heap_Malloc(hHeap, cBytes);
+  }
+  if (cBytes == 0) {
+    vplatform_heap_Free(hHeap, pData);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&pHeap->mutex);
+  pBlock = vplatform_heap_Header(pData);
+  /* The block is kept while the new size fits in it */
+  if (pBlock->iClass != HEAP_CLASS_LARGE &&
+      cBytes + sizeof(HEAP_BLOCK_HDR) <= aClassSize[pBlock->iClass]) {
+    pHeap->stats.cBytesInUse += cBytes;
+    pHeap->stats.cBytesInUse -= pBlock->cBytes;
+    if (pHeap->stats.cBytesInUse > pHeap->stats.cBytesPeak) {
+      pHeap->stats.cBytesPeak = pHeap->stats.cBytesInUse;
+    }
+    pBlock->cBytes = cBytes;
+    pthread_mutex_unlock(&pHeap->mutex);
+    return pData;
+  }
+
+  pNewData = vplatform_heap_PoolAlloc(pHeap, cBytes);
+  if (pNewData != NULL) {
+    memcpy(pNewData, pData, pBlock->cBytes < cBytes ? pBlock->cBytes : cBytes);
+    vplatform_heap_PoolFree(pHeap, pData);
+  }
+  pthread_mutex_unlock(&pHeap->mutex);
+  return pNewData;
 } /* vplatform_heap_Realloc */
 
 /*------------------------------------------------------------------*/
@@ -75,9 +287,36 @@ void vplatform_heap_Free(
   void *     hHeap,
   void                       * pData)
 {
-  free(pData);
+  NUAN_HEAP * pHeap = (NUAN_HEAP *)hHeap;
+
+  if (pHeap == NULL) {
+    free(pData);
+    return;
+  }
+  if (pData == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pHeap->mutex);
+  vplatform_heap_PoolFree(pHeap, pData);
+  pthread_mutex_unlock(&pHeap->mutex);
 } /* vplatform_heap_Free */
 
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_heap_GetStats(
+  void                 * hHeap,
+  VPLATFORM_HEAP_STATS * pStats)
+{
+  NUAN_HEAP * pHeap = vplatform_heap_Validate(hHeap);
+  if (pHeap == NULL || pStats == NULL) {
+    return NUAN_E_NULLPOINTER;
+  }
+
+  pthread_mutex_lock(&pHeap->mutex);
+  *pStats = pHeap->stats;
+  pthread_mutex_unlock(&pHeap->mutex);
+  return NUAN_OK;
+} /* vplatform_heap_GetStats */
+
 /*===================================================================
 **  Definition of static interfaces
 **==================================================================*/
@@ -98,8 +337,32 @@ NUAN_ERROR vplatform_heap_GetInterface(
     VE_INSTALL       * pInstall,
     VPLATFORM_RESOURCES * pResources)
 {
+  NUAN_HEAP * pHeap = NULL;
+  NUAN_U32 iClass = 0;
+  size_t iGranule = 0;
+
   pInstall->pIHeap = &IHeap;
   pInstall->hHeap = NULL;
+  if ((pResources->bFlags & F_POOL_HEAP) == 0) {
+    return NUAN_OK;
+  }
+
+  /* Every install has its own pools, so the memory of a voice is kept
+  ** apart from the rest of the process */
+  pHeap = (NUAN_HEAP *)calloc(1, sizeof(NUAN_HEAP));
+  if (pHeap == NULL) {
+    return NUAN_E_MALLOC;
+  }
+  pHeap->u32Check = NUAN_HEAP_HCHECK;
+  pthread_mutex_init(&pHeap->mutex, NULL);
+  for (iGranule = 0; iGranule < sizeof(pHeap->aClassOf); ++iGranule) {
+    while (aClassSize[iClass] < iGranule * HEAP_GRANULE) {
+      ++iClass;
+    }
+    pHeap->aClassOf[iGranule] = (unsigned char)iClass;
+  }
+
+  pInstall->hHeap = pHeap;
   return NUAN_OK;
 } /* vplatform_heap_GetInterface */
 
@@ -107,7 +370,23 @@ NUAN_ERROR vplatform_heap_GetInterface(
 NUAN_ERROR vplatform_heap_ReleaseInterface(
   void *               hHeap)
 {
-  (void) hHeap;
+  NUAN_HEAP * pHeap = vplatform_heap_Validate(hHeap);
+  HEAP_CHUNK_HDR * pChunk = NULL;
+
+  if (pHeap == NULL) {
+    return NUAN_OK;
+  }
+
+  /* Pooled blocks go with their chunks, large blocks still in use are leaked */
+  pChunk = pHeap->pChunks;
+  while (pChunk != NULL) {
+    HEAP_CHUNK_HDR * pNext = pChunk->pNext;
+    free(pChunk);
+    pChunk = pNext;
+  }
+  pthread_mutex_destroy(&pHeap->mutex);
+  pHeap->u32Check = 0;
+  free(pHeap);
   return NUAN_OK;
 } /* vplatform_heap_ReleaseInterface */
 
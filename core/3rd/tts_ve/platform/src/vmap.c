@@ -0,0 +1,186 @@
+/* ******************************************************************
+**  Nuance Communications, Inc.
+** ******************************************************************/
+
+/* ******************************************************************
+**
+**  COPYRIGHT INFORMATION
+**
+**  This program contains proprietary information that is a trade secret
+**  of Nuance Communications, Inc. and also is protected as an unpublished
+**  work under applicable Copyright laws. Recipient is to retain this
+**  program in confidence and is not permitted to use or make copies
+**  thereof other than as permitted in a prior written agreement with
+**  Nuance Communications, Inc. or its affiliates.
+**
+**  (c) Copyright 2008 Nuance Communications, Inc.
+**  All rights reserved. Company confidential.
+**  
+** ******************************************************************/
+
+/* ******************************************************************
+**  HEADER (INCLUDE) SECTION
+** ******************************************************************/
+
+#include "vplatform.h"
+#include "vplatform_tchar.h"
+#include "vheap.h"
+#include "vdata.h"
+#include "vfile.h"
+#include "vmap.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+/* ******************************************************************
+**  COMPILER DIRECTIVES
+** ******************************************************************/
+
+
+/* ******************************************************************
+**  DEFINITIONS
+** ******************************************************************/
+
+/* The engine reads the data in place, instead of copying it to its heap
+** through a stream, so the instances of a voice share its pages */
+typedef struct VPLATFORM_MAPPING_S {
+  VPLATFORM_FILE_H        hFile;
+  const unsigned char   * pData;
+  size_t                  cSize;
+  void                  * hHeap;
+} VPLATFORM_MAPPING_T;
+
+/* ******************************************************************
+**  FUNCTIONS
+** ******************************************************************/
+
+/* ------------------------------------------------------------------
+**  Data access services
+** -----------------------------------------------------------------*/
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_datamapping_Open(
+  void *         hDataClass,
+  void *     hHeap,
+  const char                 * szName,
+  void *     * phMapping)
+{
+  NUAN_ERROR            fRet = NUAN_OK;
+  VPLATFORM_MAPPING_T * pMapping = NULL;
+  PLATFORM_TCHAR      * szFullPathName = NULL;
+  const void          * pData = NULL;
+
+  if ((! szName) || (! hDataClass) || (! phMapping))
+  {
+    return NUAN_E_INVALIDARG;
+  }
+  *phMapping = NULL;
+
+  pMapping = (VPLATFORM_MAPPING_T *)vplatform_heap_Calloc(hHeap, 1, sizeof(VPLATFORM_MAPPING_T));
+  if (pMapping == NULL)
+  {
+    return NUAN_E_MALLOC;
+  }
+  pMapping->hHeap = hHeap;
+
+  /* Full file path in UTF-8 or a broker string, as for the local streams */
+  if (strchr(szName, '.') != NULL)
+  {
+    fRet = vplatform_file_OpenUTF8(hDataClass, hHeap, szName, "rb", &pMapping->hFile);
+  }
+  else
+  {
+    fRet = vplatform_data_GetFullPathName(szName, &szFullPathName, hDataClass);
+    if (fRet == NUAN_OK)
+    {
+      fRet = vplatform_file_Open(hDataClass, hHeap, szFullPathName, _T("rb"), &pMapping->hFile);
+    }
+    vplatform_data_FreeFullPathName(szFullPathName, hDataClass);
+  }
+
+  if (fRet == NUAN_OK)
+  {
+    fRet = vplatform_file_GetData(pMapping->hFile, &pData, &pMapping->cSize);
+  }
+  if (fRet != NUAN_OK)
+  {
+    vplatform_datamapping_Close(pMapping);
+    return fRet;
+  }
+
+  pMapping->pData = (const unsigned char *)pData;
+  /* Synthesis jumps around the voice data, read-ahead would only load pages it doesn't need */
+  if (pMapping->pData != NULL)
+  {
+    madvise((void *)pMapping->pData, pMapping->cSize, MADV_RANDOM);
+  }
+  *phMapping = pMapping;
+  return NUAN_OK;
+} /* vplatform_datamapping_Open */
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_datamapping_Close(
+  void *  hMapping)
+{
+  VPLATFORM_MAPPING_T * pMapping = (VPLATFORM_MAPPING_T *)hMapping;
+
+  if (pMapping == NULL)
+  {
+    return NUAN_E_INVALIDHANDLE;
+  }
+  if (pMapping->hFile != NULL)
+  {
+    (void)vplatform_file_Close(pMapping->hFile);
+  }
+  vplatform_heap_Free(pMapping->hHeap, pMapping);
+  return NUAN_OK;
+} /* vplatform_datamapping_Close */
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_datamapping_Map(
+  void *     hMapping,
+  size_t                     cOffset,
+  size_t                 * pcBytes,
+  const void              ** ppData)
+{
+  VPLATFORM_MAPPING_T * pMapping = (VPLATFORM_MAPPING_T *)hMapping;
+
+  if (pMapping == NULL || pcBytes == NULL || ppData == NULL)
+  {
+    return NUAN_E_INVALIDARG;
+  }
+  if (cOffset > pMapping->cSize)
+  {
+    return NUAN_E_OUTOFRANGE;
+  }
+
+  /* The whole file is mapped already, the request is only clipped to its end */
+  if (*pcBytes > pMapping->cSize - cOffset)
+  {
+    *pcBytes = pMapping->cSize - cOffset;
+  }
+  *ppData = pMapping->pData + cOffset;
+  return NUAN_OK;
+} /* vplatform_datamapping_Map */
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_datamapping_Unmap(
+  void *     hMapping,
+  const void               * pData)
+{
+  (void) pData;
+  return (hMapping == NULL) ? NUAN_E_INVALIDHANDLE : NUAN_OK;
+} /* vplatform_datamapping_Unmap */
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_datamapping_Freeze(
+  void *  hMapping)
+{
+  /* The mapping is read-only, so its data can't change anyway */
+  return (hMapping == NULL) ? NUAN_E_INVALIDHANDLE : NUAN_OK;
+} /* vplatform_datamapping_Freeze */
+
+
+/* ******************************************************************
+**  END
+** ******************************************************************/
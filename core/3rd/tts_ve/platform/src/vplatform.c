@@ -140,8 +140,9 @@ NUAN_ERROR vplatform_ReleaseInterfaces(
     vplatform_thread_ReleaseInterface((void*)pInstall->pIThread);
     pInstall->pIThread = NULL;
   }
-  vplatform_heap_ReleaseInterface(pInstall->hHeap);
 #endif
+  vplatform_heap_ReleaseInterface(pInstall->hHeap);
+  pInstall->hHeap = NULL;
 
   return NUAN_OK;
 }
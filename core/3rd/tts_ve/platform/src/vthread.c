@@ -11,14 +11,21 @@
 **  HEADER (INCLUDE) SECTION
 ** ******************************************************************/
 
+#define _GNU_SOURCE   /* CPU affinity of threads */
+
 #include "vplatform.h"
 #include "vthread.h"
 #include "vheap.h"
 
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/errno.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/time.h>  /* Needed for select() in Linux */
 #include <sys/types.h>
 
@@ -31,6 +38,9 @@
 #define NUAN_THREAD_HCHECK     135972
 #define NUAN_SEMAPHORE_HCHECK  135973
 
+#define VTHREAD_POOL_IDLE_MAX    4            /* Idle workers kept for the next Start() */
+#define VTHREAD_POOL_STACK_SIZE  (256 * 1024) /* Least stack of a worker */
+
 #define CHECK_POINTER(__PTR) \
 {\
   if(NULL==__PTR){\
@@ -45,16 +55,45 @@
   }\
 }
 
+typedef enum {
+  VTHREAD_STATE_IDLE,       /* Not started or joined */
+  VTHREAD_STATE_RUNNING,
+  VTHREAD_STATE_DONE        /* Finished, not joined yet */
+} VTHREAD_STATE;
+
+/* The engine's threads run on the workers of a process wide pool, the
+** handle only holds the start function and its result */
 typedef struct NUAN_THREAD_S {
-  pthread_t*   threadHandle;
-  void*    vHeap;
+  NUAN_THREAD_T               extHandle;      /* Handle given to the engine */
+  void*                       vHeap;
+  VTHREAD_STATE               state;
+  VPLATFORM_THREAD_STARTFUNC  pStartFunction;
+  void*                       pArgs;
+  void*                       pResult;
+  struct timespec             startTime;
+  pthread_cond_t              doneCond;
 } NUAN_VTHREAD;
 
+typedef struct VTHREAD_WORKER_S {
+  pthread_cond_t              wakeCond;
+  NUAN_VTHREAD*               pJob;
+  size_t                      stackSize;
+  unsigned int                paramsGeneration;
+  struct VTHREAD_WORKER_S*    pNext;          /* Next idle worker */
+} VTHREAD_WORKER;
+
 typedef struct NUAN_SEMAPHORE_S {
   sem_t*   semaphoreHandle;
   void*     vHeap;
 } NUAN_VSEMAPHORE;
 
+/* Pool and role parameters are shared by all installs of the process */
+static pthread_mutex_t          poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static VTHREAD_WORKER*          pIdleWorkers = NULL;
+static VPLATFORM_THREAD_STATS   poolStats;
+static VPLATFORM_THREAD_PARAMS  roleParams[VPLATFORM_THREAD_ROLE_COUNT];
+static unsigned int             roleParamsGeneration = 0;
+
 
 /* ******************************************************************
 **  LOCAL FUNCTIONS
@@ -80,6 +119,146 @@ static NUAN_ERROR vplatform_thread_ValidateHandle(VE_HSAFE * pSafeHandle, NUAN_U
   return lRet;
 }
 
+/*------------------------------------------------------------------*/
+static unsigned long long vplatform_thread_ElapsedUs(const struct timespec * pSince)
+{
+  struct timespec lNow;
+  long long lUs;
+
+  clock_gettime(CLOCK_MONOTONIC, &lNow);
+  lUs = (lNow.tv_sec - pSince->tv_sec) * 1000000LL + (lNow.tv_nsec - pSince->tv_nsec) / 1000;
+  return lUs > 0 ? (unsigned long long)lUs : 0;
+}
+
+/*------------------------------------------------------------------*/
+/* Applies the parameters to the calling thread, returns the number of
+** settings the system refused */
+static int vplatform_thread_ApplyParams(const VPLATFORM_THREAD_PARAMS * pParams)
+{
+  int lErrors = 0;
+  int lRealtime = (pParams->iPolicy == SCHED_FIFO) || (pParams->iPolicy == SCHED_RR);
+  struct sched_param lSched;
+  cpu_set_t lCpus;
+  int i;
+
+  lSched.sched_priority = lRealtime ? pParams->iPriority : 0;
+  if (0 != pthread_setschedparam(pthread_self(), pParams->iPolicy, &lSched)) {
+    lErrors++;
+  }
+  /* Nice value of a Linux thread is set by its id */
+  if (!lRealtime && 0 != setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), pParams->iNice)) {
+    lErrors++;
+  }
+
+  CPU_ZERO(&lCpus);
+  for (i = 0; i < 32; i++) {
+    if ((0 == pParams->u32CpuMask) || (pParams->u32CpuMask & (1u << i))) {
+      CPU_SET(i, &lCpus);
+    }
+  }
+  if (0 != pthread_setaffinity_np(pthread_self(), sizeof(lCpus), &lCpus)) {
+    lErrors++;
+  }
+  return lErrors;
+}
+
+/*------------------------------------------------------------------*/
+static void* vplatform_thread_WorkerMain(void* pArg)
+{
+  VTHREAD_WORKER* lWorker = (VTHREAD_WORKER*)pArg;
+  NUAN_VTHREAD* lJob = NULL;
+  unsigned long long lStartUs;
+  void* lResult;
+
+  pthread_mutex_lock(&poolMutex);
+  for (;;) {
+    while (NULL == lWorker->pJob) {
+      pthread_cond_wait(&lWorker->wakeCond, &poolMutex);
+    }
+    lJob = lWorker->pJob;
+
+    if (lWorker->paramsGeneration != roleParamsGeneration) {
+      VPLATFORM_THREAD_PARAMS lParams = roleParams[VPLATFORM_THREAD_ROLE_ENGINE];
+      int lErrors;
+      lWorker->paramsGeneration = roleParamsGeneration;
+      pthread_mutex_unlock(&poolMutex);
+      lErrors = vplatform_thread_ApplyParams(&lParams);
+      pthread_mutex_lock(&poolMutex);
+      poolStats.cntParamErrors += lErrors;
+    }
+
+    lStartUs = vplatform_thread_ElapsedUs(&lJob->startTime);
+    poolStats.usStartTotal += lStartUs;
+    if (lStartUs > poolStats.usStartMax) poolStats.usStartMax = lStartUs;
+    pthread_mutex_unlock(&poolMutex);
+
+    lResult = lJob->pStartFunction(lJob->pArgs);
+
+    pthread_mutex_lock(&poolMutex);
+    lJob->pResult = lResult;
+    lJob->state = VTHREAD_STATE_DONE;
+    pthread_cond_signal(&lJob->doneCond);
+    lWorker->pJob = NULL;
+
+    if (poolStats.cntIdle >= VTHREAD_POOL_IDLE_MAX) {
+      break;
+    }
+    lWorker->pNext = pIdleWorkers;
+    pIdleWorkers = lWorker;
+    poolStats.cntIdle++;
+  }
+  pthread_mutex_unlock(&poolMutex);
+
+  pthread_cond_destroy(&lWorker->wakeCond);
+  free(lWorker);
+  return NULL;
+}
+
+/*------------------------------------------------------------------*/
+/* Takes an idle worker with enough stack or creates a new one, called
+** with the pool locked */
+static VTHREAD_WORKER* vplatform_thread_GetWorker(size_t pStackSize)
+{
+  VTHREAD_WORKER** ppWorker = &pIdleWorkers;
+  VTHREAD_WORKER* lWorker = NULL;
+  pthread_attr_t lAttr;
+  pthread_t lThread;
+  int lRes;
+
+  for (; NULL != *ppWorker; ppWorker = &(*ppWorker)->pNext) {
+    if ((*ppWorker)->stackSize >= pStackSize) {
+      lWorker = *ppWorker;
+      *ppWorker = lWorker->pNext;
+      lWorker->pNext = NULL;
+      poolStats.cntIdle--;
+      poolStats.cntReused++;
+      return lWorker;
+    }
+  }
+
+  /* Workers outlive the installs, so they aren't on an install heap */
+  lWorker = (VTHREAD_WORKER*)calloc(1, sizeof(VTHREAD_WORKER));
+  if (NULL == lWorker) {
+    return NULL;
+  }
+  pthread_cond_init(&lWorker->wakeCond, NULL);
+  lWorker->stackSize = pStackSize > VTHREAD_POOL_STACK_SIZE ? pStackSize : VTHREAD_POOL_STACK_SIZE;
+  lWorker->paramsGeneration = 0;   /* Role parameters not applied */
+
+  pthread_attr_init(&lAttr);
+  pthread_attr_setstacksize(&lAttr, lWorker->stackSize);
+  pthread_attr_setdetachstate(&lAttr, PTHREAD_CREATE_DETACHED);
+  lRes = pthread_create(&lThread, &lAttr, vplatform_thread_WorkerMain, lWorker);
+  pthread_attr_destroy(&lAttr);
+  if (lRes != 0) {
+    pthread_cond_destroy(&lWorker->wakeCond);
+    free(lWorker);
+    return NULL;
+  }
+  poolStats.cntCreated++;
+  return lWorker;
+}
+
 
 /* ------------------------------------------------------------------
 **  THREADS
@@ -89,35 +268,24 @@ static NUAN_ERROR vplatform_thread_ValidateHandle(VE_HSAFE * pSafeHandle, NUAN_U
 /*lint -esym(715, phClass) */
 NUAN_ERROR vplatform_thread_ObjOpen(void* phClass, void* pHeap, void ** pThreadH)
 {
-  NUAN_ERROR      fRet = NUAN_OK;
-  NUAN_THREAD_H   lExtThread; 
   NUAN_VTHREAD*   lThread = NULL;
-  *pThreadH = (NUAN_THREAD_H)vplatform_heap_Malloc(pHeap,sizeof(NUAN_THREAD_T));
-  CHECK_POINTER(*pThreadH);
-
-  lExtThread = ((NUAN_THREAD_H)(*pThreadH));
 
-  lExtThread->u32Check = NUAN_THREAD_HCHECK;
+  CHECK_POINTER(pThreadH);
+  *pThreadH = NULL;
 
-  lThread = (NUAN_VTHREAD*)vplatform_heap_Malloc(pHeap,sizeof(NUAN_VTHREAD));
-  if (NULL != lThread) {
-    lThread->threadHandle = (pthread_t*)vplatform_heap_Malloc(pHeap,sizeof(pthread_t));
-    if(NULL != lThread->threadHandle) {
-      lThread->vHeap = pHeap; 
-      lExtThread->pHandleData = (void*)lThread;
-    }else {
-      /*rollback*/
-      vplatform_heap_Free(pHeap,lThread);
-      vplatform_heap_Free(pHeap,pThreadH);
-      fRet = NUAN_E_MALLOC;
-    }
-  } else {
-    /*rollback*/
-    vplatform_heap_Free(pHeap,pThreadH);
-    fRet = NUAN_E_MALLOC;
+  /* Handle and thread data are one block */
+  lThread = (NUAN_VTHREAD*)vplatform_heap_Calloc(pHeap, 1, sizeof(NUAN_VTHREAD));
+  if (NULL == lThread) {
+    return NUAN_E_MALLOC;
   }
-  
-  return fRet;
+  lThread->extHandle.u32Check = NUAN_THREAD_HCHECK;
+  lThread->extHandle.pHandleData = (void*)lThread;
+  lThread->vHeap = pHeap;
+  lThread->state = VTHREAD_STATE_IDLE;
+  pthread_cond_init(&lThread->doneCond, NULL);
+
+  *pThreadH = &lThread->extHandle;
+  return NUAN_OK;
 }
 
 /*------------------------------------------------------------------*/
@@ -131,8 +299,17 @@ NUAN_ERROR vplatform_thread_ObjClose(void * pThreadH)
   RETURN_ON_ERROR(fRet);
 
   lThread = (NUAN_VTHREAD*)lExtThread->pHandleData;
-  vplatform_heap_Free(lThread->vHeap, lThread->threadHandle);
-  vplatform_heap_Free(lThread->vHeap,pThreadH);
+
+  /* The worker still writes the result of a running thread */
+  pthread_mutex_lock(&poolMutex);
+  if (lThread->state == VTHREAD_STATE_RUNNING) {
+    fRet = NUAN_E_WRONG_STATE;
+  }
+  pthread_mutex_unlock(&poolMutex);
+  RETURN_ON_ERROR(fRet);
+
+  lExtThread->u32Check = 0;
+  pthread_cond_destroy(&lThread->doneCond);
   vplatform_heap_Free(lThread->vHeap, lThread);
 
   return fRet;
@@ -146,29 +323,39 @@ NUAN_ERROR vplatform_thread_Start(void * pThreadH,
 {
   NUAN_ERROR              fRet = NUAN_OK;
   NUAN_VTHREAD             *lThread = NULL;
-  int                     lRes = 0;
+  VTHREAD_WORKER          *lWorker = NULL;
   NUAN_THREAD_H  lExtThread = ((NUAN_THREAD_H)(pThreadH));
-  pthread_attr_t          lAttr;
   
   CHECK_POINTER(pThreadH);
+  CHECK_POINTER(pStartFunction);
 
   fRet = vplatform_thread_ValidateHandle(lExtThread,NUAN_THREAD_HCHECK);
   RETURN_ON_ERROR(fRet);
 
   lThread = (NUAN_VTHREAD*)(lExtThread->pHandleData);
 
-  /* the usual pthread default stack size is 2MB which is much more than we
-    really need. At higher thread counts, thread creation can fail because
-    of the lack of virtual memory. For now, 100K seems safe. */
-  pthread_attr_init(&lAttr);
-  pthread_attr_setstacksize(&lAttr, pStackSize);
-  pthread_attr_setdetachstate(&lAttr, PTHREAD_CREATE_JOINABLE);
+  pthread_mutex_lock(&poolMutex);
+  if (lThread->state != VTHREAD_STATE_IDLE) {
+    pthread_mutex_unlock(&poolMutex);
+    return NUAN_E_WRONG_STATE;
+  }
 
-  lRes = pthread_create((pthread_t *)(lThread->threadHandle), 
-                                     &lAttr, pStartFunction, pArgs);
-  if (lRes != 0) {
+  /* Workers have a stack of their own size or the largest one asked for,
+     much less than the usual 2MB pthread default. */
+  clock_gettime(CLOCK_MONOTONIC, &lThread->startTime);
+  lWorker = vplatform_thread_GetWorker(pStackSize);
+  if (NULL == lWorker) {
     fRet = NUAN_E_COULDNOTOPENFILE;
+  } else {
+    lThread->pStartFunction = pStartFunction;
+    lThread->pArgs = pArgs;
+    lThread->pResult = NULL;
+    lThread->state = VTHREAD_STATE_RUNNING;
+    poolStats.cntStart++;
+    lWorker->pJob = lThread;
+    pthread_cond_signal(&lWorker->wakeCond);
   }
+  pthread_mutex_unlock(&poolMutex);
 
   return fRet;
 }
@@ -178,8 +365,9 @@ NUAN_ERROR vplatform_thread_Join(void * pThreadH,void* pStatus)
 {
   NUAN_ERROR      fRet = NUAN_OK;
   NUAN_VTHREAD   *lThread = NULL;
-  int             lRes = 0; 
   NUAN_THREAD_H   lExtThread = ((NUAN_THREAD_H)(pThreadH));
+  struct timespec lJoinTime;
+  unsigned long long lJoinUs;
   
   CHECK_POINTER(pThreadH);
 
@@ -188,11 +376,26 @@ NUAN_ERROR vplatform_thread_Join(void * pThreadH,void* pStatus)
 
   lThread = (NUAN_VTHREAD*)(lExtThread->pHandleData);
 
-  lRes = pthread_join(*(lThread->threadHandle), pStatus);
-  
-  if (lRes != 0) {
+  clock_gettime(CLOCK_MONOTONIC, &lJoinTime);
+  pthread_mutex_lock(&poolMutex);
+  if (lThread->state == VTHREAD_STATE_IDLE) {
     fRet = NUAN_E_NOK;
+  } else {
+    while (lThread->state == VTHREAD_STATE_RUNNING) {
+      pthread_cond_wait(&lThread->doneCond, &poolMutex);
+    }
+    /* Status is the void** of pthread_join() */
+    if (NULL != pStatus) {
+      *(void**)pStatus = lThread->pResult;
+    }
+    lThread->state = VTHREAD_STATE_IDLE;
+
+    lJoinUs = vplatform_thread_ElapsedUs(&lJoinTime);
+    poolStats.cntJoin++;
+    poolStats.usJoinTotal += lJoinUs;
+    if (lJoinUs > poolStats.usJoinMax) poolStats.usJoinMax = lJoinUs;
   }
+  pthread_mutex_unlock(&poolMutex);
 
   return fRet;
 }
@@ -225,6 +428,60 @@ if (NULL != pThreadId) {
   return fRet;
 }
 
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE pRole,
+                                          const VPLATFORM_THREAD_PARAMS * pParams)
+{
+  CHECK_POINTER(pParams);
+  if (((int)pRole < 0) || (pRole >= VPLATFORM_THREAD_ROLE_COUNT)) {
+    return NUAN_E_INVALIDARG;
+  }
+
+  pthread_mutex_lock(&poolMutex);
+  roleParams[pRole] = *pParams;
+  /* Workers apply the new engine parameters before their next thread */
+  roleParamsGeneration++;
+  pthread_mutex_unlock(&poolMutex);
+
+  return NUAN_OK;
+}
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_thread_ApplyRole(VPLATFORM_THREAD_ROLE pRole)
+{
+  VPLATFORM_THREAD_PARAMS lParams;
+  int lErrors;
+
+  if (((int)pRole < 0) || (pRole >= VPLATFORM_THREAD_ROLE_COUNT)) {
+    return NUAN_E_INVALIDARG;
+  }
+
+  pthread_mutex_lock(&poolMutex);
+  lParams = roleParams[pRole];
+  pthread_mutex_unlock(&poolMutex);
+
+  lErrors = vplatform_thread_ApplyParams(&lParams);
+  if (lErrors != 0) {
+    pthread_mutex_lock(&poolMutex);
+    poolStats.cntParamErrors += lErrors;
+    pthread_mutex_unlock(&poolMutex);
+    return NUAN_E_SYSTEM_ERROR;
+  }
+  return NUAN_OK;
+}
+
+/*------------------------------------------------------------------*/
+NUAN_ERROR vplatform_thread_GetStats(VPLATFORM_THREAD_STATS * pStats)
+{
+  CHECK_POINTER(pStats);
+
+  pthread_mutex_lock(&poolMutex);
+  *pStats = poolStats;
+  pthread_mutex_unlock(&poolMutex);
+
+  return NUAN_OK;
+}
+
 
 /* -------------------------------------------------------------------------+
 |   SEMAPHORES SECTIONS BEGIN                                              |
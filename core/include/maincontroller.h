@@ -8,18 +8,28 @@
 #pragma once
 
 #include <QObject>
-#include <QSound>
 #include <QFuture>
+#include <QElapsedTimer>
 #include "translator.h"
 #include "textposition.h"
+#include "textpage.h"
 #include "kbdinputinjector.h"
+#include <array>
+#include <atomic>
 #include <deque>
+#include <optional>
+#include <string>
 
 class OcrHandler;
 class Paragraph;
 class ZyrloTts;
 class HWHandler;
 class TtsAudioLayer;
+class StartupSequence;
+class BookConverter;
+class SpeechScheduler;
+enum class SpeechPriority;
+enum class Earcon;
 
 namespace cv {
     class Mat;
@@ -36,6 +46,14 @@ class MainController : public QObject
         Paused,
     };
 
+    // Text queued to TTS after the one being spoken
+    struct SpeechSegment {
+        int     paragraphNum;
+        int     position;
+        QString text;
+        int     utterance;
+    };
+
     typedef enum  {
         BY_SYMBOL = 0,
         BY_WORD,
@@ -45,6 +63,14 @@ class MainController : public QObject
     } NavigationMode;
 
 public:
+    // Time from the page capture till the first spoken word
+    struct FirstWordStats {
+        int    count {0};
+        qint64 lastMs {0};
+        qint64 totalMs {0};
+        qint64 maxMs {0};
+    };
+
     MainController();
     ~MainController();
 
@@ -74,8 +100,8 @@ public:
     void toggleVoiceEnabled(int nIndx);
     void saveVoiceSettings();
     void setMenuOpen(bool bMenuOpen);
-    void readSettings();
     void writeSettings() const;
+    void setThreadRoles() const;
     void toggleNavigationMode(bool bForward);
     void onLeftArrow();
     void onRightArrow();
@@ -86,7 +112,8 @@ public:
     void convertTextToAudio(const QString & sText, const QString & sAudioFileName);
     bool saveScannedImage(const cv::Mat & img);
     bool isSpeaking();
-    bool isPlayingSound();
+    // Speech or an earcon is playing, safe to call from other threads
+    bool isAudioBusy();
     bool ProcessScannedImage(const std::string & path);
     bool StartProcessScannedImages();
     bool saveScannedText() const;
@@ -94,6 +121,10 @@ public:
     bool ProcessNextScannedImg();
     void onReaderReady();
     void SetLocalLightFreqTest(bool bOn);
+    // The voice and the audio layer are created, the input may be dispatched
+    bool isReady() const;
+    // Text of the page OCR'd so far
+    QString getPageText() const;
     int getCurrentExposure() const;
     int getCurrentGain() const;
     int getExposureStep() const;
@@ -106,7 +137,12 @@ public:
 
 
 signals:
-    void textUpdated(const QString &text);
+    // Page text grows only by appending, so the views get the new text only.
+    // Offset is the position of the text in the page, which has its paragraphs
+    // joined by newlines
+    void textAppended(int offset, const QString &text);
+    void textReset();
+    void ready();
     void finished();
     void wordPositionChanged(const TextPosition &position);
     void previewUpdated(const cv::Mat & img);
@@ -135,6 +171,7 @@ public slots:
 
     void sayText(QString text, bool bAfter = false);
     void sayTranslationTag(const QString &tag, bool bAfter = false);
+    void prerenderPrompts();
     void spellText(const QString &text);
     void speechRateUp();
     void speechRateDown();
@@ -142,13 +179,47 @@ public slots:
     void onToggleAudioSink();
     void onSaveMainBatterylevel() const;
 
+    // Boundary the first utterance of the page can start at before OCR finishes the sentence
+    void setSpeechStartBoundary(TextPage::Boundary boundary);
+    TextPage::Boundary speechStartBoundary() const;
+    const FirstWordStats &firstWordStats(TextPage::Boundary boundary) const;
+    // How often the spoken word is updated during the playback
+    void setWordNotifyInterval(int ms);
+
 private:
+    // Values of the settings file, missing ones keep the defaults
+    struct Settings {
+        std::optional<int>          nCurrentLangaugeSettingIndx;
+        std::optional<bool>         bUseCameraFlash;
+        std::optional<float>        fExposureStep;
+        std::optional<int>          nLookAheadUtterances;
+        std::optional<int>          nConversionWorkers;
+        std::optional<int>          nSpeechThreadNice;
+        std::optional<int>          nCameraThreadNice;
+        std::optional<int>          nLeadingPauseMs;
+        std::optional<int>          nWordPauseMs;
+        std::optional<int>          nClausePauseMs;
+        std::optional<int>          nSentencePauseMs;
+        std::optional<bool>         bDirectAudioOutput;
+        std::optional<std::string>  sAlsaDevice;
+        std::optional<int>          nAlsaPeriodUs;
+        std::optional<int>          nAlsaBufferUs;
+        std::optional<int>          nAlsaThreadPriority;
+        std::optional<int>          nWordNotifyIntervalMs;
+        std::optional<int>          nSpeechStartBoundary;
+    };
+
     OcrHandler &ocr();
     const OcrHandler &ocr() const;
+    static Settings readSettings();
+    void applySettings(const Settings &settings);
+    void applyCameraSettings(const Settings &settings);
     void startSpeaking(int delayMs = 0);
+    void queueLookAhead();
     const Paragraph &paragraph() const;
     void startBeeping();
     void stopBeeping();
+    void playEarcon(Earcon earcon);
     void startLongPressTimer(void (MainController::*action)(void), int nDelay);
     void stopLongPressTimer();
     void setCurrentWordPosition(const TextPosition &textPosition);
@@ -160,13 +231,25 @@ private:
     void SetDefaultTts();
      void InitTtsEngines();
     void ReleaseTtsEngines();
+    void connectOcr();
+    ZyrloTts *ttsEngine(int nIndx);
+    void createTtsEngine(int nIndx);
+    void prewarmTtsEngines();
+    void evictTtsEngines(int nKeepIndx);
+    void setSpeechPauses(ZyrloTts *engine) const;
+    void saySpeech(const QString &text, SpeechPriority priority, bool bQueued = false);
+    void startPrompt(const QString &text);
+    qint64 trimmedSilenceMs() const;
     bool setAudioSink(int indx);
+    bool updateDirectAudioOutput() const;
+    void setupAudioLayer(TtsAudioLayer *audioLayer);
     QString GetCharName(QChar c) const;
     int numOfParagraphs() const;
 
 private slots:
     void onNewTextExtracted();
     void onSpeakingFinished();
+    void onUtteranceStarted(int utterance);
     void setCurrentWord(int wordPosition, int wordLength);
     void previewImgUpdate(const cv::Mat & prevImg);
     void readerReady();
@@ -178,29 +261,67 @@ private slots:
     void onToggleSingleColumn();
     void onGesture(int nGest);
     void onSayBatteryStatus();
-    void onSavingAudioDone(QString sFileName);
+    void onPageConverted(const QString &sFileName, bool bOk);
     void onUsbKeyInsert(bool bInserted);
     void onUsbKpConnect(bool bConnected);
     void onBtKpRegistered();
 
 
 private:
-    QVector<ZyrloTts *>m_ttsEnginesList;
+    // Engine of every voice in LANGUAGES, created on first use
+    struct TtsEngineSlot {
+        ZyrloTts   *engine {nullptr};
+        qint64      initMs {0};
+        qint64      memoryKb {0};   // Resident memory growth on creation
+        quint64     lastUsed {0};
+    };
+    QVector<TtsEngineSlot> m_ttsEngines;
+    StartupSequence *m_startup {nullptr};
+    Settings    m_settings;     // Read by the "settings" stage, applied by the GUI stages after it
+    BookConverter *m_bookConverter {nullptr};
+    SpeechScheduler *m_speechScheduler {nullptr};  // Orders the prompts and the page reading
+    QElapsedTimer m_speechClock;
+    quint64     m_ttsEngineUses {0};
     ZyrloTts *m_ttsEngine {nullptr};
     int         m_currentTTSIndex {0};
     HWHandler  *m_hwhandler {nullptr};
     int         m_ttsStartPositionInParagraph {0};
     int         m_currentParagraphNum {-1};
     QString     m_currentText;
+    int         m_sentTextLength {0};
+    TextPage::Boundary m_speechStartBoundary {TextPage::Boundary::Line};
+    bool        m_isFirstUtterance {false};     // Nothing is said from the current page yet
+    bool        m_isFirstWordPending {false};
+    QElapsedTimer m_pageTimer;
+    std::array<FirstWordStats, 3> m_firstWordStats;
+    QString     m_currentLang;
+    std::deque<SpeechSegment> m_speechQueue;
+    int         m_nextUtterance {0};
+    int         m_lookAheadUtterances {2};      // 0 - synthesize next text only after the current is played
+    int         m_wordNotifyIntervalMs {50};
+    int         m_nConversionWorkers {0};
+    int         m_nSpeechThreadNice {-5};       // Synthesis and engine threads
+    int         m_nCameraThreadNice {5};
+    // Longest silence kept around the page segments, by the end of the segment text
+    int         m_nLeadingPauseMs {30};
+    int         m_nWordPauseMs {80};
+    int         m_nClausePauseMs {200};
+    int         m_nSentencePauseMs {400};
+    // Speech plays straight on the ALSA device of the built-in speaker instead of PulseAudio
+    bool        m_bDirectAudioOutput {false};
+    QString     m_sAlsaDevice {"plughw:0,0"};
+    int         m_nAlsaPeriodUs {10000};
+    int         m_nAlsaBufferUs {40000};
+    int         m_nAlsaThreadPriority {70};
+    qint64      m_pageTrimmedSilenceMs {0};     // Trimmed by all engines before the page started
+    QElapsedTimer m_utteranceGapTimer;
     TextPosition m_currentWordPosition;
     State       m_prevState {State::Stopped};
     State       m_state {State::Stopped};
-    QSound *m_shutterSound {nullptr}, *m_beepSound{nullptr}, *m_armOpenSound{nullptr}, *m_armClosedSound{nullptr};
     Translator m_translator;//, m_help;
     bool        m_wordNavigationWithDelay {false};  // Determines if it's need to do delay before continue page reading
     bool        m_isContinueAfterSpeakingFinished {true};
-    bool m_bKeepBeeping = false;
-    QFuture<void> m_beepingThread, m_longPressTimerThread, m_batteryTestThread;
+    QFuture<void> m_longPressTimerThread, m_batteryTestThread;
     unsigned int m_deviceButtonsMask = 0, m_keypadButtonMask = 0;
     int m_nLongPressCount = -1;
     void (MainController::*m_longPressAction)(void);
@@ -219,5 +340,7 @@ private:
     std::deque<std::string> m_vScannedImagesQue;
     int m_nImagesToConvert = 0;
     TtsAudioLayer *m_pTtsAudioLayer {nullptr};
+    // Busy state of the layer for the other threads, the layer itself is replaced by resetAudio()
+    std::atomic<bool> m_isAudioBusy {false};
 };
 
@@ -29,6 +29,9 @@ public:
             ocr = new OcrHandler;
         return *ocr;
     }
+    // Loads OCR engine data, which takes long. May be called ahead from any thread,
+    // then the instance is created without waiting
+    static void initEngine();
     OcrHandler(OcrHandler const&) = delete;
     void operator=(OcrHandler const&) = delete;
     ~OcrHandler();
@@ -48,6 +51,7 @@ public:
     const TextPage *textPage() const;
 
 signals:
+    void pageStarted();
     void lineAdded();
     void finished();
 
@@ -56,14 +60,16 @@ private slots:
 
 private:
     explicit OcrHandler();
-    QString getStatus() const;
+    static QString getStatus();
 
     void createTextPage();
     void destroyTextPage();
     bool getOcrResults();
 
 private:
-    unsigned long long m_languageCode {1};
+    static constexpr unsigned long long DEFAULT_LANGUAGE_CODE = 1;
+
+    unsigned long long m_languageCode {DEFAULT_LANGUAGE_CODE};
     int m_processingParagraphNum {-1};
     int m_currentParagraphId {-1};
     TextPage *m_page {nullptr};
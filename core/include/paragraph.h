@@ -8,25 +8,33 @@
 #pragma once
 
 #include <QString>
-#include <QStringList>
+#include <QStringView>
+#include <QSharedPointer>
 
 #include "textposition.h"
+#include "positiontable.h"
 #include <map>
 
-using Positions = QVector<TextPosition>; // Represents starting position of words/sentences in the paragraph
+// Append-only UTF-16 text of a page. All paragraphs of the page are views into
+// it, separated by a newline character (the same way TextPage::text() joins them)
+using TextStorage = QSharedPointer<QString>;
 
 class Paragraph
 {
 
 public:
     Paragraph() = default;
-    explicit Paragraph(int id);
+    explicit Paragraph(int id, const TextStorage &storage = TextStorage());
+    // A copy would append to the storage of the original
+    Paragraph(const Paragraph &) = delete;
+    Paragraph &operator=(const Paragraph &) = delete;
+    Paragraph(Paragraph &&) = default;
+    Paragraph &operator=(Paragraph &&) = default;
 
     int id() const;
     void setId(int id);
 
     int paragraphPosition() const;
-    void setParagraphPosition(int pos);
 
     int length() const;
 
@@ -37,11 +45,15 @@ public:
 
     void addLine(const QString &line, const QString &lang);
     QString text() const;
+    // The view is invalidated as soon as more text is added to the page
+    QStringView textView() const;
     std::pair<QString, int> lang(int position) const;
 
     bool isComplete() const;
     void setCompleted();
     bool hasText() const;
+    // False if the last line ended with a dash and its last word continues on the next line
+    bool isLastWordComplete() const;
 
     TextPosition prevCharPosition(int pos) const;
     TextPosition nextCharPosition(int pos) const;
@@ -60,30 +72,33 @@ public:
     TextPosition lastSentencePosition() const;
 
 private:
-    void parseChars();
-    void parseWords();
-    void parseSenteces();
-    Positions parseToPositions(const QString &text, const QRegularExpression &re);
-
-    TextPosition prevPosition(const Positions &positions, int pos) const;
-    TextPosition nextPosition(const Positions &positions, int pos) const;
-    TextPosition currentPosition(const Positions &positions, int pos) const;
-    TextPosition firstPosition(const Positions &positions) const;
-    TextPosition lastPosition(const Positions &positions) const;
-    int indexByTextPosition(const Positions &positions, int currentPosition) const;
+    void parseWords(QStringView text);
+    void parseSenteces(QStringView text);
+    static int truncateLastPosition(PositionTable &positions);
+
+    TextPosition positionAt(const PositionTable &positions, int index) const;
+    TextPosition prevPosition(const PositionTable &positions, int pos) const;
+    TextPosition nextPosition(const PositionTable &positions, int pos) const;
+    TextPosition currentPosition(const PositionTable &positions, int pos) const;
+    TextPosition firstPosition(const PositionTable &positions) const;
+    TextPosition lastPosition(const PositionTable &positions) const;
+    TextPosition charPosition(int index) const;
+    int charIndex(int pos) const;
 
 private:
     int m_id {-1};
     int m_firstLineNum {-1};
     int m_addedNumLines {0};
-    int m_paragraphPosition {-1};
     bool m_isComplete {false};
+    bool m_isSpacePending {false};  // Space between lines is added only when the next line comes
 
-    QStringList m_lines;
+    TextStorage m_storage;
+    int m_offset {-1};              // Paragraph's position in the storage
+    int m_length {0};
     std::map<int, QString> m_langTagPos;
 
-    Positions m_chars;
-    Positions m_words;
-    Positions m_sentences;
+    // Every character is a position itself, so char positions are not stored
+    PositionTable m_words;
+    PositionTable m_sentences;
 };
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QVector>
+#include <algorithm>
+
+/*
+ * @brief PositionTable keeps start positions and lengths of text items (words,
+ * sentences) in separate arrays. Start positions are relative to the paragraph
+ * and must be appended in increasing order, so an item can be found by binary search.
+ *
+ */
+class PositionTable {
+public:
+    PositionTable() = default;
+
+    inline void clear() { m_starts.clear(); m_lengths.clear(); }
+    inline void reserve(int size) { m_starts.reserve(size); m_lengths.reserve(size); }
+    inline void append(int start, int length) { m_starts.append(start); m_lengths.append(length); }
+    inline void truncate(int size) { m_starts.resize(size); m_lengths.resize(size); }
+
+    inline int size() const { return m_starts.size(); }
+    inline bool isEmpty() const { return m_starts.isEmpty(); }
+    inline int start(int index) const { return m_starts[index]; }
+    inline int length(int index) const { return m_lengths[index]; }
+
+    // Returns index of the last item starting at or before the given position,
+    // or -1 if the position is before the first item
+    inline int indexOf(int position) const
+    {
+        const auto it = std::upper_bound(m_starts.cbegin(), m_starts.cend(), position);
+        return static_cast<int>(it - m_starts.cbegin()) - 1;
+    }
+
+private:
+    QVector<int> m_starts;
+    QVector<int> m_lengths;
+};
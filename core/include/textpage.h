@@ -7,7 +7,7 @@
 
 #pragma once
 
-#include <QVector>
+#include <vector>
 #include "paragraph.h"
 
 /*
@@ -17,13 +17,24 @@
 class TextPage
 {
 public:
+    // Text of incomplete paragraph is cut to the last sentence terminator. If there is no
+    // terminator yet, it's cut to the last boundary of this kind or nothing is returned
+    enum class Boundary {
+        Sentence,
+        Clause,
+        Line,   // End of the last complete word
+    };
+
     TextPage() = default;
+    // Paragraphs are views into the storage of the page, so the page isn't copied
+    TextPage(const TextPage &) = delete;
+    TextPage &operator=(const TextPage &) = delete;
 
     int numParagraphs() const;
 
     const Paragraph &paragraph(int num) const;
     QString text() const;
-    std::pair<QString, QString> getText(int paragraphNum, int position) const;
+    std::pair<QString, QString> getText(int paragraphNum, int position, Boundary boundary = Boundary::Line) const;
 
     void addParagraph();
     void addParagraphLine(const QString &text, const QString &lang);
@@ -36,6 +47,7 @@ private:
 
 private:
     bool m_isComplete {false};
-    QVector<Paragraph> m_paragraphs;
+    TextStorage m_storage {TextStorage::create()};
+    std::vector<Paragraph> m_paragraphs;
 };
 
@@ -2,6 +2,9 @@
 #define TRANSLATOR_H
 
 #include <map>
+#include <string>
+#include <vector>
+
 class Translator : public std::map<std::string, std::map<std::string, std::string> >
 {
     std::string m_sCurrLang = "eng";
@@ -10,6 +13,7 @@ public:
     bool Init(std::string sFileName);
     void SetLanguage(const std::string & sLang);
     std::string GetString(const std::string & sTag) const;
+    std::vector<std::string> GetStrings() const;
 };
 
 #define MENU_ABOUT                                      "MENU_ABOUT"
@@ -90,7 +90,7 @@ int BTComm::receiveLoopStep(int & nVal) {
 int BTComm::btConnect(const std::atomic_bool &isStop) {
     int status = 0;
     for(; !isStop;  sleep(1)) {
-        if((m_pMainController->isSpeaking()  || m_pMainController->isPlayingSound()) && !m_bUsingMainAudioSink) {
+        if(m_pMainController->isAudioBusy() && !m_bUsingMainAudioSink) {
             continue;
         }
         m_s = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
@@ -0,0 +1,319 @@
+#include "alsaoutput.h"
+
+#include <QDebug>
+#include <alsa/asoundlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static qint64 steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AlsaOutput::AlsaOutput(const Config &config, int sampleRate, int channels)
+    : m_config(config)
+    , m_sampleRate(sampleRate)
+    , m_channels(channels)
+    , m_frameBytes(channels * static_cast<int>(sizeof(qint16)))
+{
+}
+
+AlsaOutput::~AlsaOutput()
+{
+    stop();
+    close();
+}
+
+bool AlsaOutput::open()
+{
+    if (m_pcm)
+        return true;
+
+    int err = snd_pcm_open(&m_pcm, m_config.device.toLocal8Bit().constData(), SND_PCM_STREAM_PLAYBACK,
+                           SND_PCM_NONBLOCK);
+    if (err < 0) {
+        qWarning() << "Can't open ALSA device" << m_config.device << snd_strerror(err);
+        m_pcm = nullptr;
+        return false;
+    }
+
+    snd_pcm_hw_params_t *hwParams;
+    snd_pcm_hw_params_alloca(&hwParams);
+    unsigned int bufferUs = static_cast<unsigned int>(m_config.bufferUs);
+    unsigned int periodUs = static_cast<unsigned int>(m_config.periodUs);
+    int dir = 0;
+    if ((err = snd_pcm_hw_params_any(m_pcm, hwParams)) < 0
+            || (err = snd_pcm_hw_params_set_access(m_pcm, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0
+            || (err = snd_pcm_hw_params_set_format(m_pcm, hwParams, SND_PCM_FORMAT_S16_LE)) < 0
+            || (err = snd_pcm_hw_params_set_channels(m_pcm, hwParams, static_cast<unsigned int>(m_channels))) < 0
+            || (err = snd_pcm_hw_params_set_rate(m_pcm, hwParams, static_cast<unsigned int>(m_sampleRate), 0)) < 0
+            || (err = snd_pcm_hw_params_set_buffer_time_near(m_pcm, hwParams, &bufferUs, &dir)) < 0
+            || (err = snd_pcm_hw_params_set_period_time_near(m_pcm, hwParams, &periodUs, &dir)) < 0
+            || (err = snd_pcm_hw_params(m_pcm, hwParams)) < 0) {
+        qWarning() << "Can't configure ALSA device" << m_config.device << snd_strerror(err);
+        close();
+        return false;
+    }
+    snd_pcm_uframes_t periodFrames = 0;
+    snd_pcm_uframes_t bufferFrames = 0;
+    snd_pcm_hw_params_get_period_size(hwParams, &periodFrames, &dir);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &bufferFrames);
+    m_periodFrames = static_cast<int>(periodFrames);
+    m_bufferFrames = static_cast<int>(bufferFrames);
+    m_canPause = snd_pcm_hw_params_can_pause(hwParams);
+
+    // Playback starts with the first period, the thread is woken for every free period
+    snd_pcm_sw_params_t *swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    if ((err = snd_pcm_sw_params_current(m_pcm, swParams)) < 0
+            || (err = snd_pcm_sw_params_set_start_threshold(m_pcm, swParams, periodFrames)) < 0
+            || (err = snd_pcm_sw_params_set_avail_min(m_pcm, swParams, periodFrames)) < 0
+            || (err = snd_pcm_sw_params(m_pcm, swParams)) < 0) {
+        qWarning() << "Can't configure ALSA device" << m_config.device << snd_strerror(err);
+        close();
+        return false;
+    }
+
+    m_period.resize(static_cast<size_t>(m_periodFrames * m_frameBytes));
+    qDebug() << "ALSA output" << m_config.device << "period" << m_periodFrames << "buffer" << m_bufferFrames
+             << "frames at" << m_sampleRate << "Hz";
+    return true;
+}
+
+bool AlsaOutput::isOpen() const
+{
+    return m_pcm != nullptr;
+}
+
+void AlsaOutput::setStateHandler(StateHandler handler)
+{
+    m_stateHandler = std::move(handler);
+}
+
+void AlsaOutput::start(Source source)
+{
+    if (!m_pcm)
+        return;
+    stop();
+
+    m_source = std::move(source);
+    m_writtenFrames = 0;
+    m_playedFrames = 0;
+    m_playedAtNs = steadyNs();
+    m_isStopping = false;
+    m_isSuspendRequested = false;
+    const int err = snd_pcm_prepare(m_pcm);
+    if (err < 0)
+        qWarning() << "Can't prepare ALSA device" << snd_strerror(err);
+    m_state = State::Active;
+    m_thread = std::thread(&AlsaOutput::run, this);
+}
+
+void AlsaOutput::stop()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_wakeUp.notify_all();
+        m_thread.join();
+        snd_pcm_drop(m_pcm);
+    }
+    m_state = State::Stopped;
+}
+
+void AlsaOutput::suspend()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable() || m_state == State::Stopped || m_state == State::Error)
+        return;
+    m_isSuspendRequested = true;
+    m_state = State::Suspended;
+}
+
+void AlsaOutput::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_isSuspendRequested)
+            return;
+        m_isSuspendRequested = false;
+        m_state = State::Active;
+    }
+    m_wakeUp.notify_all();
+}
+
+AlsaOutput::State AlsaOutput::state() const
+{
+    return m_state;
+}
+
+// Hardware pointer is read once a period, the position between the reads runs with the clock
+qint64 AlsaOutput::playedFrames() const
+{
+    qint64 played = m_playedFrames;
+    if (m_state == State::Active) {
+        played += (steadyNs() - m_playedAtNs) * m_sampleRate / 1'000'000'000;
+        played = std::min<qint64>(played, m_writtenFrames);
+    }
+    return played;
+}
+
+int AlsaOutput::periodFrames() const
+{
+    return m_periodFrames;
+}
+
+int AlsaOutput::bufferFrames() const
+{
+    return m_bufferFrames;
+}
+
+int AlsaOutput::underruns() const
+{
+    return m_underruns;
+}
+
+void AlsaOutput::run()
+{
+    setPriority();
+    const int waitMs = std::max(1, 2 * m_periodFrames * 1000 / m_sampleRate);
+    const auto starvedSleep = std::chrono::microseconds(std::max(500, m_config.periodUs / 2));
+    bool isPaused = false;
+    bool isHardwarePaused = false;
+    // Source ran out, so the device running dry is the end of the data, not the underrun
+    bool isStarved = false;
+
+    while (!m_isStopping) {
+        if (m_isSuspendRequested) {
+            if (!isPaused) {
+                isPaused = true;
+                isHardwarePaused = m_canPause && snd_pcm_pause(m_pcm, 1) >= 0;
+                if (!isHardwarePaused)
+                    snd_pcm_drop(m_pcm);
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this]() { return m_isStopping || !m_isSuspendRequested; });
+            continue;
+        }
+        if (isPaused) {
+            isPaused = false;
+            if (!isHardwarePaused || snd_pcm_pause(m_pcm, 0) < 0)
+                snd_pcm_prepare(m_pcm);
+            m_playedAtNs = steadyNs();
+        }
+
+        snd_pcm_sframes_t avail = 0;
+        snd_pcm_sframes_t delay = 0;
+        int err = snd_pcm_avail_delay(m_pcm, &avail, &delay);
+        if (err < 0) {
+            if (err == -EPIPE && !isStarved)
+                ++m_underruns;
+            if (!recover(err))
+                break;
+            if (isStarved)
+                changeState(State::Idle);
+            continue;
+        }
+        updatePosition(delay);
+        if (avail < m_periodFrames) {
+            snd_pcm_wait(m_pcm, waitMs);
+            continue;
+        }
+
+        const qint64 size = m_source(m_period.data(), static_cast<qint64>(m_period.size()));
+        if (size <= 0) {
+            isStarved = true;
+            if (delay <= 0)
+                changeState(State::Idle);
+            else if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED)
+                snd_pcm_start(m_pcm);   // Less than a period is buffered, it wouldn't start by itself
+            std::this_thread::sleep_for(starvedSleep);
+            continue;
+        }
+        isStarved = false;
+        const int frames = static_cast<int>((size + m_frameBytes - 1) / m_frameBytes);
+        std::memset(m_period.data() + size, 0, static_cast<size_t>(frames * m_frameBytes - size));
+        changeState(State::Active);
+        if (!writeFrames(m_period.data(), frames))
+            break;
+    }
+}
+
+void AlsaOutput::setPriority()
+{
+    if (m_config.priority <= 0)
+        return;
+    sched_param param {};
+    param.sched_priority = m_config.priority;
+    const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0)
+        qWarning() << "ALSA output thread runs without real-time priority:" << strerror(err);
+}
+
+bool AlsaOutput::writeFrames(const char *data, int frames)
+{
+    int offset = 0;
+    while (offset < frames && !m_isStopping) {
+        const auto written = snd_pcm_writei(m_pcm, data + offset * m_frameBytes,
+                                            static_cast<snd_pcm_uframes_t>(frames - offset));
+        if (written == -EAGAIN) {
+            snd_pcm_wait(m_pcm, std::max(1, 2 * m_periodFrames * 1000 / m_sampleRate));
+            continue;
+        }
+        if (written < 0) {
+            if (written == -EPIPE)
+                ++m_underruns;
+            if (!recover(static_cast<int>(written)))
+                return false;
+            continue;
+        }
+        offset += static_cast<int>(written);
+        m_writtenFrames += written;
+    }
+    return true;
+}
+
+// Underrun and system suspend are recovered by preparing the device again
+bool AlsaOutput::recover(int error)
+{
+    const int err = snd_pcm_recover(m_pcm, error, 1);
+    if (err >= 0)
+        return true;
+    qWarning() << "ALSA output failed" << snd_strerror(err);
+    changeState(State::Error);
+    return false;
+}
+
+void AlsaOutput::updatePosition(long delay)
+{
+    const qint64 played = m_writtenFrames - std::max<qint64>(0, delay);
+    if (played >= m_playedFrames)
+        m_playedFrames = played;
+    m_playedAtNs = steadyNs();
+}
+
+void AlsaOutput::changeState(State state)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isSuspendRequested || m_isStopping || m_state == state)
+            return;
+        m_state = state;
+    }
+    if (m_stateHandler)
+        m_stateHandler(state);
+}
+
+void AlsaOutput::close()
+{
+    if (!m_pcm)
+        return;
+    snd_pcm_close(m_pcm);
+    m_pcm = nullptr;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct _snd_pcm snd_pcm_t;
+
+/*
+ * AlsaOutput plays PCM straight on an ALSA device, bypassing the sound server.
+ *
+ * A dedicated real-time thread pulls one period at a time from the source and
+ * writes it to the device, so the latency is bounded by the configured buffer.
+ * The played position is read from the hardware pointer of the device.
+ *
+ * All calls on the device are made by the playback thread while it runs, the
+ * rest of the class only sets the requests it executes.
+ *
+ */
+class AlsaOutput
+{
+public:
+    struct Config {
+        QString device {"plughw:0,0"};
+        int     periodUs {10000};
+        int     bufferUs {40000};
+        int     priority {70};      // SCHED_FIFO priority of the playback thread, 0 - normal thread
+    };
+
+    enum class State { Stopped, Active, Idle, Suspended, Error };
+
+    // Reads up to maxSize bytes, 0 when nothing is buffered now. Called from the playback thread
+    using Source = std::function<qint64(char *data, qint64 maxSize)>;
+    // Called from the playback thread when it changes the state on its own
+    using StateHandler = std::function<void(State state)>;
+
+    AlsaOutput(const Config &config, int sampleRate, int channels);
+    ~AlsaOutput();
+
+    // Opens the device for 16-bit samples, false if it can't be used
+    bool open();
+    bool isOpen() const;
+    void setStateHandler(StateHandler handler);
+
+    void start(Source source);
+    void stop();
+    void suspend();
+    void resume();
+
+    State state() const;
+    // Frames played since start, by the hardware pointer
+    qint64 playedFrames() const;
+    int periodFrames() const;
+    int bufferFrames() const;
+    int underruns() const;
+
+private:
+    void run();
+    void setPriority();
+    bool writeFrames(const char *data, int frames);
+    bool recover(int error);
+    void updatePosition(long delay);
+    void changeState(State state);
+    void close();
+
+private:
+    const Config            m_config;
+    const int               m_sampleRate;
+    const int               m_channels;
+    const int               m_frameBytes;
+    snd_pcm_t              *m_pcm {nullptr};
+    int                     m_periodFrames {0};
+    int                     m_bufferFrames {0};
+    bool                    m_canPause {false};
+    Source                  m_source;
+    StateHandler            m_stateHandler;
+    std::vector<char>       m_period;
+
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<bool>       m_isStopping {false};
+    std::atomic<bool>       m_isSuspendRequested {false};
+    std::atomic<State>      m_state {State::Stopped};
+
+    // Position written by the playback thread, read by the others
+    std::atomic<qint64>     m_writtenFrames {0};
+    std::atomic<qint64>     m_playedFrames {0};
+    std::atomic<qint64>     m_playedAtNs {0};     // Steady clock time of m_playedFrames
+    std::atomic<int>        m_underruns {0};
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * AppendLog is an append only log of values written by one thread and read by
+ * another without locks. Values are stored in fixed size chunks, so appending
+ * never moves the values being read.
+ *
+ * The reader sees all values appended before size() was read. clear() must not
+ * run concurrently with the writer or the reader.
+ *
+ */
+template<typename T>
+class AppendLog
+{
+public:
+    static constexpr int CHUNK_SIZE = 256;
+    static constexpr int MAX_CHUNKS = 1024;
+
+    AppendLog()
+    {
+        for (auto &chunk : m_chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~AppendLog()
+    {
+        for (auto &chunk : m_chunks)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    AppendLog(const AppendLog &) = delete;
+    AppendLog &operator=(const AppendLog &) = delete;
+
+    // Writer side, returns false if the log is full
+    bool append(const T &value)
+    {
+        const int size = m_size.load(std::memory_order_relaxed);
+        const int chunkNum = size / CHUNK_SIZE;
+        if (chunkNum >= MAX_CHUNKS)
+            return false;
+
+        T *chunk = m_chunks[chunkNum].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new T[CHUNK_SIZE];
+            m_chunks[chunkNum].store(chunk, std::memory_order_relaxed);
+        }
+        chunk[size % CHUNK_SIZE] = value;
+        m_size.store(size + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Chunks are kept for reuse
+    void clear()
+    {
+        m_size.store(0, std::memory_order_relaxed);
+    }
+
+    int size() const
+    {
+        return m_size.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    // Index must be less than size() read before
+    const T &operator[](int i) const
+    {
+        return m_chunks[i / CHUNK_SIZE].load(std::memory_order_relaxed)[i % CHUNK_SIZE];
+    }
+
+    // Binary search for the first value from the index first, for which isBefore is false.
+    // Values must be partitioned by isBefore
+    template<typename Predicate>
+    int partitionPoint(int first, Predicate isBefore) const
+    {
+        int last = size();
+        while (first < last) {
+            const int middle = first + (last - first) / 2;
+            if (isBefore((*this)[middle]))
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return first;
+    }
+
+private:
+    std::atomic<T *>    m_chunks[MAX_CHUNKS];
+    std::atomic<int>    m_size {0};
+};
+
+template<typename T>
+constexpr int AppendLog<T>::CHUNK_SIZE;
+template<typename T>
+constexpr int AppendLog<T>::MAX_CHUNKS;
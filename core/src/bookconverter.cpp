@@ -0,0 +1,174 @@
+#include "bookconverter.h"
+#include "zyrlotts.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+BookConverter::BookConverter(EngineFactory engineFactory, QObject *parent)
+    : QObject(parent)
+    , m_engineFactory(std::move(engineFactory))
+{
+}
+
+BookConverter::~BookConverter()
+{
+    stop();
+}
+
+void BookConverter::setWorkerCount(int count)
+{
+    m_workerCount = std::max(0, count);
+}
+
+int BookConverter::workerCount() const
+{
+    if (m_workerCount > 0)
+        return m_workerCount;
+    return std::max(1, QThread::idealThreadCount() - 1);
+}
+
+void BookConverter::start(int totalPages)
+{
+    stop();
+    m_workers = QVector<Worker>(workerCount());
+    m_totalPages = totalPages;
+    m_convertedPages = 0;
+    m_failedPages = 0;
+    m_audioBytes = 0;
+    m_timer.start();
+}
+
+void BookConverter::addPage(const QString &textFileName, const QString &audioFileName)
+{
+    m_pages.push_back({textFileName, audioFileName});
+    dispatchPages();
+}
+
+void BookConverter::stop()
+{
+    m_pages.clear();
+    for (auto &worker : m_workers) {
+        // Stopped engine removes its unfinished file and doesn't report the page
+        if (worker.engine && worker.isBusy)
+            worker.engine->stop();
+        worker.isBusy = false;
+    }
+    releaseWorkers();
+}
+
+bool BookConverter::isIdle() const
+{
+    return m_pages.empty() && std::none_of(m_workers.begin(), m_workers.end(), [](const Worker &worker) {
+        return worker.isBusy;
+    });
+}
+
+int BookConverter::finishedPages() const
+{
+    return m_convertedPages + m_failedPages;
+}
+
+QString BookConverter::report() const
+{
+    const qint64 elapsedMs = std::max<qint64>(1, m_timer.elapsed());
+    qint64 busyMs = 0;
+    for (const auto &worker : m_workers)
+        busyMs += worker.busyMs;
+
+    return QString("Converted %1 of %2 pages, %3 failed, in %4 s: %5 pages per minute, %6 KB of MP3, "
+                   "%7 workers busy %8% of the time")
+            .arg(m_convertedPages)
+            .arg(m_totalPages)
+            .arg(m_failedPages)
+            .arg(elapsedMs / 1000)
+            .arg(m_convertedPages * 60000.0 / elapsedMs, 0, 'f', 1)
+            .arg(m_audioBytes / 1024)
+            .arg(m_workers.size())
+            .arg(m_workers.isEmpty() ? 0 : busyMs * 100 / (elapsedMs * m_workers.size()));
+}
+
+void BookConverter::dispatchPages()
+{
+    for (int i = 0; i < m_workers.size() && !m_pages.empty(); ++i) {
+        if (m_workers[i].isBusy)
+            continue;
+
+        const auto page = m_pages.front();
+        m_pages.pop_front();
+
+        QFile file(page.textFileName);
+        QString text;
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+            text = QTextStream(&file).readAll();
+        auto &worker = m_workers[i];
+        if (!text.isEmpty() && !worker.engine) {
+            worker.engine = m_engineFactory(this);
+            if (worker.engine) {
+                connect(worker.engine, &ZyrloTts::savingAudioDone, this, [this, i](QString audioFileName) {
+                    onPageDone(i, audioFileName);
+                });
+            }
+        }
+        if (text.isEmpty() || !worker.engine) {
+            qWarning() << "Can't convert the page" << page.textFileName;
+            ++m_failedPages;
+            emit pageConverted(page.audioFileName, false);
+            // The worker is still free for the next page
+            --i;
+            continue;
+        }
+        worker.isBusy = true;
+        worker.audioFileName = page.audioFileName;
+        worker.pageTimer.start();
+        worker.engine->convertTextToAudio(text, page.audioFileName);
+    }
+
+    if (isIdle() && finishedPages() >= m_totalPages && !m_workers.isEmpty()) {
+        qDebug() << report();
+        releaseWorkers();
+        emit finished();
+    }
+}
+
+void BookConverter::onPageDone(int workerNum, const QString &audioFileName)
+{
+    // Late notification of the stopped conversion
+    if (workerNum >= m_workers.size() || !m_workers[workerNum].isBusy
+            || m_workers[workerNum].audioFileName != audioFileName)
+        return;
+    auto &worker = m_workers[workerNum];
+    const qint64 pageMs = worker.pageTimer.elapsed();
+    worker.isBusy = false;
+    worker.busyMs += pageMs;
+    ++worker.pages;
+
+    // The file is complete if all the encoded audio is on the disk
+    const auto stats = worker.engine->audioFileStats();
+    const bool isOk = stats.pcmBytes > 0 && QFileInfo(audioFileName).size() == stats.mp3Bytes;
+    if (isOk) {
+        ++m_convertedPages;
+        m_audioBytes += stats.mp3Bytes;
+    } else {
+        ++m_failedPages;
+    }
+    qDebug() << "Page" << audioFileName << "converted in" << pageMs << "ms by worker" << workerNum;
+    emit pageConverted(audioFileName, isOk);
+
+    dispatchPages();
+}
+
+// Engines are released when the conversion is finished, workers keep their stats for the report
+void BookConverter::releaseWorkers()
+{
+    for (auto &worker : m_workers) {
+        if (worker.engine) {
+            worker.engine->deleteLater();
+            worker.engine = nullptr;
+        }
+        worker.isBusy = false;
+    }
+}
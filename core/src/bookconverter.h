@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <deque>
+#include <functional>
+
+class ZyrloTts;
+
+/*
+ * BookConverter converts the texts of book pages to MP3 files on several TTS
+ * engines at once, so the synthesis of the pages runs on all cores while OCR
+ * extracts the text of the next pages.
+ *
+ * Engines are created by the factory when the conversion needs them and are
+ * deleted when all queued pages are converted, as every engine holds its own
+ * voice data.
+ *
+ */
+class BookConverter : public QObject
+{
+    Q_OBJECT
+
+public:
+    using EngineFactory = std::function<ZyrloTts *(QObject *parent)>;
+
+    explicit BookConverter(EngineFactory engineFactory, QObject *parent = nullptr);
+    ~BookConverter();
+
+    // 0 - one worker per core, except the core left for OCR
+    void setWorkerCount(int count);
+    int workerCount() const;
+
+    // Total is the number of pages in the conversion, including the ones still waiting for OCR
+    void start(int totalPages);
+    void addPage(const QString &textFileName, const QString &audioFileName);
+    // Drops the queued pages and removes the unfinished files
+    void stop();
+    bool isIdle() const;
+
+    // Converted and failed pages since start()
+    int finishedPages() const;
+    // Progress and throughput of the conversion
+    QString report() const;
+
+signals:
+    void pageConverted(const QString &audioFileName, bool isOk);
+    void finished();
+
+private:
+    struct Page {
+        QString textFileName;
+        QString audioFileName;
+    };
+
+    struct Worker {
+        ZyrloTts       *engine {nullptr};
+        bool            isBusy {false};
+        QString         audioFileName;
+        QElapsedTimer   pageTimer;
+        qint64          busyMs {0};
+        int             pages {0};
+    };
+
+    void dispatchPages();
+    void onPageDone(int workerNum, const QString &audioFileName);
+    void releaseWorkers();
+
+private:
+    EngineFactory       m_engineFactory;
+    int                 m_workerCount {0};
+    QVector<Worker>     m_workers;
+    std::deque<Page>    m_pages;
+    int                 m_totalPages {0};
+    int                 m_convertedPages {0};
+    int                 m_failedPages {0};
+    qint64              m_audioBytes {0};
+    QElapsedTimer       m_timer;
+};
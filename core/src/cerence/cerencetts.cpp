@@ -11,13 +11,26 @@
 
 #include <QAudioDeviceInfo>
 #include <QAudioOutput>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
 #include <QDebug>
 #include <QThread>
 #include <QtConcurrent>
 #include <lame/lame.h>
+#include <utime.h>
+#include <vcritsec.h>
+#include <vdata.h>
+#include <vheap.h>
+#include <vthread.h>
 #include "../ttsaudiolayer.h"
 
-void WriteWaveHeader(FILE *fp, int nSampleRate, int nBitsPerSample, int nChannels, int nBuffSize);
+static constexpr int SAMPLE_RATE = 22050;
+static constexpr qint64 PCM_CACHE_SIZE = 4 * 1024 * 1024;
+static constexpr qint64 PROMPT_CACHE_SIZE = 8 * 1024 * 1024;
+static const char *PROMPT_CACHE_DIR = "/opt/zyrlo/cache/prompts";
+static constexpr int MAX_PROMPT_DIRS = 8;
+static constexpr int PROMPT_VOLUME = 100;   // Prompts are scaled to the voice volume as they're played
 
 static const char *INSTALL_PATHS[] = {
     "/opt/zyrlo/ve/languages",
@@ -39,10 +52,6 @@ static NUAN_ERROR vout_Write(VE_HINSTANCE hTtsInst, void *pUserData,
 
     case VE_MSG_ENDPROCESS:
         qDebug() << "Text-to-speech process has ended";
-        if(p->outputToFile()) {
-            p->writeToMp3(p->getAudioOutFileName().toStdString().c_str());
-            QtConcurrent::run([p](){ emit p->savingAudioDone(p->getAudioOutFileName()); });
-        }
         break;
 
     case VE_MSG_OUTBUFREQ:
@@ -75,7 +84,12 @@ static NUAN_ERROR vout_Write(VE_HINSTANCE hTtsInst, void *pUserData,
 
 CerenceTTS::CerenceTTS(const QString &voice, QObject *parent, TtsAudioLayer **ppTtsAudioLayer)
     : ZyrloTts(parent, ppTtsAudioLayer)
+    , m_silenceTrimmer(SAMPLE_RATE)
+    , m_pcmCache(PCM_CACHE_SIZE, sizeof(qint16))
+    , m_voice(voice)
+    , m_promptCache(PROMPT_CACHE_SIZE, sizeof(qint16))
 {
+    m_synthesisPool.setMaxThreadCount(1);
     initTTS(voice);
     initAudio();
 
@@ -94,6 +108,16 @@ CerenceTTS::~CerenceTTS()
         ve_ttsUnInitialize(m_hSpeech);
     }
 
+    logHeapStats();
+    VPLATFORM_CRITSEC_STATS critSecStats;
+    if (vplatform_critsec_GetStats(m_stInstall.hCSClass, &critSecStats) == NUAN_OK)
+        qDebug() << "Vocalizer critical sections entered" << critSecStats.cntEnter << "times, contended"
+                 << critSecStats.cntContended;
+    VPLATFORM_THREAD_STATS threadStats;
+    if (vplatform_thread_GetStats(&threadStats) == NUAN_OK && threadStats.cntStart > 0)
+        qDebug() << "Vocalizer threads started" << threadStats.cntStart << "times on" << threadStats.cntCreated
+                 << "workers, start avg" << threadStats.usStartTotal / threadStats.cntStart << "us max"
+                 << threadStats.usStartMax << "us, join max" << threadStats.usJoinMax << "us";
     vplatform_ReleaseInterfaces(&m_stInstall);
 }
 
@@ -102,58 +126,411 @@ void CerenceTTS::say(const QString &text, int delayMs)
     stop();
 
     m_currentWord = -1;
+    m_currentUtterance = -1;
     m_wordMarks.clear();
-    (*m_ppTtsAudioLayer)->clear();
+    m_isWordMarksFull = false;
+    m_utterances.clear();
+    m_synthesizedUtterances = 0;
+    m_synthesizedSamples = 0;
+    m_audioRate = 0;
+    m_isNativeRatePending = false;
+    if (audioLayer())
+        audioLayer()->clear();
+
+    appendUtterance(text);
+    m_isPromptStopped = false;
+    m_isSynthesizing = true;
+    m_ttsFuture = QtConcurrent::run(&m_synthesisPool, [this]() { synthesizeUtterances(); });
+
+    if (audioLayer() && !m_bOutputToFile)
+        audioLayer()->startTimer(delayMs);
+}
+
+void CerenceTTS::sayNext(const QString &text)
+{
+    QMutexLocker locker(&m_wordMarksMutex);
+    appendUtterance(text);
+    if (!m_isSynthesizing) {
+        m_isSynthesizing = true;
+        m_ttsFuture = QtConcurrent::run(&m_synthesisPool, [this]() { synthesizeUtterances(); });
+    }
+}
+
+void CerenceTTS::stop()
+{
+    if (audioLayer())
+        audioLayer()->stopSpeech();
+    {
+        // Drop the queued utterances
+        QMutexLocker locker(&m_wordMarksMutex);
+        m_synthesizedUtterances = m_utterances.size();
+        m_isPromptStopped = true;
+    }
+    ve_ttsStop(m_hTtsInst);
+    m_ttsFuture.waitForFinished();
+}
+
+void CerenceTTS::clearCache()
+{
+    m_pcmCache.clear();
+}
+
+// Directories of the voices and rates not used lately are removed, so the rate steps don't fill the
+// storage. The directory in use is touched to keep it recent
+static void evictPromptDirs(const QString &promptDir)
+{
+    utime(QFile::encodeName(promptDir).constData(), nullptr);
+    const auto dirs = QDir(PROMPT_CACHE_DIR).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
+    for (int i = MAX_PROMPT_DIRS; i < dirs.size(); ++i) {
+        if (!QDir(dirs[i].absoluteFilePath()).removeRecursively())
+            qWarning() << "Can't remove prompt cache directory" << dirs[i].absoluteFilePath();
+    }
+}
 
-    m_positionMapper.setText(text);
+void CerenceTTS::prerender(const QStringList &texts)
+{
+    // Audio of the other rate is kept in its own directory
+    const auto promptDir = QString("%1/%2-%3").arg(PROMPT_CACHE_DIR, m_voice).arg(getSpeechRate());
+    if (!QDir().mkpath(promptDir))
+        qWarning() << "Can't create prompt cache directory" << promptDir;
+
+    {
+        QMutexLocker locker(&m_wordMarksMutex);
+        m_promptDir = promptDir;
+        m_pendingPrompts.clear();
+        for (const auto &text : texts)
+            m_pendingPrompts.append(text.toUtf8());
+        m_isPromptStopped = false;
+        if (!m_isSynthesizing) {
+            m_isSynthesizing = true;
+            m_ttsFuture = QtConcurrent::run(&m_synthesisPool, [this]() { synthesizeUtterances(); });
+        }
+    }
+    // Prompts of the evicted directories aren't saved, as they aren't in m_promptDir anymore
+    evictPromptDirs(promptDir);
+}
+
+static QString promptFileName(const QString &promptDir, const QByteArray &textBytes)
+{
+    const auto hash = QCryptographicHash::hash(textBytes, QCryptographicHash::Sha1).toHex();
+    return QString("%1/%2.pcm").arg(promptDir, QString::fromLatin1(hash));
+}
+
+void CerenceTTS::appendUtterance(const QString &text)
+{
+    Utterance utterance;
+    utterance.text = text;
+    utterance.positionMapper.setText(text);
+    m_utterances.append(utterance);
+}
 
-    m_ttsFuture = QtConcurrent::run([this, text](){
-        auto textBytes = text.toUtf8();
+// Runs in the synthesis thread till all queued utterances are synthesized and prompts rendered
+void CerenceTTS::synthesizeUtterances()
+{
+    // Pool thread may have run other work since the last utterance
+    vplatform_thread_ApplyRole(VPLATFORM_THREAD_ROLE_SYNTHESIS);
+    bool isStopped = false;
+    while (true) {
+        QByteArray textBytes;
+        QString promptDir;
+        int leadingMs = 0;
+        int trailingMs = 0;
+        int speechRate = 0;
+        int volume = 0;
+        int generation = 0;
+        {
+            QMutexLocker locker(&m_wordMarksMutex);
+            speechRate = m_speechRate;
+            volume = m_volume;
+            generation = m_voiceGeneration;
+            if (m_synthesizedUtterances < m_utterances.size()) {
+                m_synthesizingUtterance = m_synthesizedUtterances;
+                const auto &text = m_utterances[m_synthesizingUtterance].text;
+                textBytes = text.toUtf8();
+                leadingMs = m_pauses.leadingMs;
+                trailingMs = SilenceTrimmer::pauseAfterMs(m_pauses, text);
+                // The next utterance continues the same audio stream, even if it's finished already
+                if (audioLayer())
+                    audioLayer()->reopenSamples();
+                if (m_isNativeRatePending && audioLayer()) {
+                    m_isNativeRatePending = false;
+                    m_audioRate = m_pendingRate;
+                    audioLayer()->markNativeRate();
+                }
+            } else {
+                if (audioLayer())
+                    audioLayer()->finishSamples();
+                if (m_pendingPrompts.isEmpty() || m_isPromptStopped || m_bOutputToFile) {
+                    m_isSynthesizing = false;
+                    isStopped = m_isPromptStopped;
+                    break;
+                }
+                textBytes = m_pendingPrompts.first();
+                promptDir = m_promptDir;
+            }
+        }
 
-        VE_INTEXT inText;
-        inText.eTextFormat = VE_NORM_TEXT;
-        inText.szInText = textBytes.data();
-        // Caveat: ve_ttsProcessText2Speech expects the number of bytes as cntTextLength
-        inText.cntTextLength = static_cast<NUAN_U32>(textBytes.size());
+        applyVoiceParams(speechRate, promptDir.isEmpty() ? volume : PROMPT_VOLUME);
+        if (!promptDir.isEmpty()) {
+            renderPrompt(textBytes, promptDir);
+            continue;
+        }
 
         QElapsedTimer timer;
         timer.start();
-        ve_ttsProcessText2Speech(m_hTtsInst, &inText);
-        qDebug() << "TTS processing finished in" << timer.elapsed() << "ms";
-    });
+        m_silenceTrimmer.start(leadingMs);
+        m_heldMarks.clear();
+        m_utteranceStartSample = m_synthesizedSamples;
+        // Cached audio may cover the utterance beginning, the rest is synthesized
+        int srcOffset = 0;
+        while (srcOffset < textBytes.size() && !isStopRequested()) {
+            PcmCache::Hit hit;
+            if (!m_bOutputToFile && srcOffset == 0 && findPrompt(textBytes, hit)) {
+                appendCached(hit, srcOffset, static_cast<float>(volume) / PROMPT_VOLUME);
+                srcOffset += hit.textLength;
+            } else if (!m_bOutputToFile && m_pcmCache.find(textBytes.mid(srcOffset), hit)) {
+                appendCached(hit, srcOffset);
+                srcOffset += hit.textLength;
+            } else {
+                synthesize(textBytes.mid(srcOffset), srcOffset, generation);
+                break;
+            }
+        }
+        if (!isStopRequested())
+            finishTrimmed(trailingMs);
+        qDebug() << "TTS processing of utterance" << m_synthesizingUtterance << "finished in" << timer.elapsed() << "ms,"
+                 << "PCM cache hits" << m_pcmCache.hits() << "misses" << m_pcmCache.misses()
+                 << "prompt hits" << m_promptCache.hits();
+
+        QMutexLocker locker(&m_wordMarksMutex);
+        ++m_synthesizedUtterances;
+    }
 
-    (*m_ppTtsAudioLayer)->startTimer(delayMs);
+    if (!m_bOutputToFile)
+        return;
+    // The file was encoded while the text was synthesized, only its tail is left
+    if (isStopped) {
+        abortAudioFile();
+    } else {
+        if (!finishAudioFile())
+            qWarning() << "Can't save audio to" << m_audioOutFileName;
+        emit savingAudioDone(m_audioOutFileName);
+    }
 }
 
-void CerenceTTS::stop()
+void CerenceTTS::synthesize(const QByteArray &textBytes, int srcOffset, int generation)
 {
-    (*m_ppTtsAudioLayer)->stop();
-    ve_ttsStop(m_hTtsInst);
-    m_ttsFuture.waitForFinished();
+    m_synthesisStartSource = m_silenceTrimmer.sourcePosition();
+    m_srcOffset = srcOffset;
+    m_isCaching = !m_bOutputToFile;
+    m_synthesizedPcm.clear();
+    m_synthesizedMarks.clear();
+
+    processText(textBytes);
+
+    // Audio of the stopped synthesis is incomplete, and stale if the voice parameters changed meanwhile
+    if (m_isCaching && !isStopRequested()) {
+        QMutexLocker locker(&m_wordMarksMutex);
+        if (generation == m_voiceGeneration)
+            m_pcmCache.insert(textBytes, m_synthesizedPcm, m_synthesizedMarks);
+    }
+    m_isCaching = false;
+    m_synthesizedPcm.clear();
+    m_synthesizedMarks.clear();
+}
+
+void CerenceTTS::renderPrompt(const QByteArray &textBytes, const QString &promptDir)
+{
+    const auto fileName = promptFileName(promptDir, textBytes).toStdString();
+    if (!m_promptCache.contains(textBytes) && !m_promptCache.load(fileName.c_str())) {
+        m_isRenderingPrompt = true;
+        m_isCaching = true;
+        m_synthesizedPcm.clear();
+        m_synthesizedMarks.clear();
+
+        processText(textBytes);
+        m_isRenderingPrompt = false;
+        const bool isCached = m_isCaching;
+        m_isCaching = false;
+
+        QMutexLocker locker(&m_wordMarksMutex);
+        // Stopped prompt is incomplete, it's rendered again when synthesis is idle.
+        // Audio is stale if the voice parameters changed meanwhile
+        const bool isStale = m_isPromptStopped || promptDir != m_promptDir;
+        if (isCached && !isStale) {
+            m_promptCache.insert(textBytes, m_synthesizedPcm, m_synthesizedMarks);
+            if (!m_promptCache.save(textBytes, fileName.c_str()))
+                qWarning() << "Can't save prompt audio to" << fileName.c_str();
+        }
+        m_synthesizedPcm.clear();
+        m_synthesizedMarks.clear();
+        if (isStale)
+            return;
+    }
+
+    QMutexLocker locker(&m_wordMarksMutex);
+    if (!m_pendingPrompts.isEmpty() && m_pendingPrompts.first() == textBytes)
+        m_pendingPrompts.removeFirst();
+}
+
+// Runs in the synthesis thread between the utterances, so the parameters don't change while
+// the engine processes text
+void CerenceTTS::applyVoiceParams(int speechRate, int volume)
+{
+    VE_PARAM params[2];
+    NUAN_U16 count = 0;
+    if (speechRate != m_engineRate) {
+        params[count].eID = VE_PARAM_SPEECHRATE;
+        params[count++].uValue.usValue = static_cast<NUAN_U16>(speechRate);
+    }
+    if (volume != m_engineVolume) {
+        params[count].eID = VE_PARAM_VOLUME;
+        params[count++].uValue.usValue = static_cast<NUAN_U16>(volume);
+    }
+    if (count == 0)
+        return;
+
+    auto nErrcode = ve_ttsSetParamList(m_hTtsInst, &params[0], count);
+    if (nErrcode != NUAN_OK) {
+        qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
+        return;
+    }
+    m_engineRate = speechRate;
+    m_engineVolume = volume;
+}
+
+void CerenceTTS::processText(const QByteArray &textBytes)
+{
+    VE_INTEXT inText;
+    inText.eTextFormat = VE_NORM_TEXT;
+    inText.szInText = const_cast<char *>(textBytes.constData());
+    // Caveat: ve_ttsProcessText2Speech expects the number of bytes as cntTextLength
+    inText.cntTextLength = static_cast<NUAN_U32>(textBytes.size());
+    ve_ttsProcessText2Speech(m_hTtsInst, &inText);
+}
+
+// Prompt said before it's rendered in background may be on disk already
+bool CerenceTTS::findPrompt(const QByteArray &textBytes, PcmCache::Hit &hit)
+{
+    if (m_promptCache.findText(textBytes, hit))
+        return true;
+
+    QString promptDir;
+    {
+        QMutexLocker locker(&m_wordMarksMutex);
+        promptDir = m_promptDir;
+    }
+    return !promptDir.isEmpty() && m_promptCache.load(promptFileName(promptDir, textBytes).toStdString().c_str())
+            && m_promptCache.findText(textBytes, hit);
+}
+
+void CerenceTTS::appendCached(const PcmCache::Hit &hit, int srcOffset, float gain)
+{
+    const qint64 sourcePos = m_silenceTrimmer.sourcePosition();
+    if (gain == 1.0f) {
+        appendTrimmed(hit.pcm.constData(), hit.pcm.size());
+    } else {
+        const auto samples = reinterpret_cast<const qint16 *>(hit.pcm.constData());
+        m_scaledPcm.resize(static_cast<size_t>(hit.pcm.size()) / sizeof(qint16));
+        for (size_t i = 0; i < m_scaledPcm.size(); ++i)
+            m_scaledPcm[i] = static_cast<qint16>(std::max(-32768.0f, std::min(32767.0f, samples[i] * gain)));
+        appendTrimmed(reinterpret_cast<const char *>(m_scaledPcm.data()), m_scaledPcm.size() * sizeof(qint16));
+    }
+
+    for (const auto &cachedMark : hit.marks) {
+        VE_MARKINFO mark;
+        memset(&mark, 0, sizeof(mark));
+        mark.eMrkType = VE_MRK_WORD;
+        mark.cntSrcPos = static_cast<NUAN_U32>(cachedMark.srcPos + srcOffset);
+        mark.cntSrcTextLen = static_cast<NUAN_U32>(cachedMark.srcLength);
+        mark.cntDestPos = static_cast<NUAN_U32>(cachedMark.destPos + sourcePos);
+        addWordMark({mark, m_synthesizingUtterance});
+    }
+}
+
+void CerenceTTS::appendTrimmed(const char *pSamples, size_t size)
+{
+    m_trimmedPcm.clear();
+    m_silenceTrimmer.push(reinterpret_cast<const qint16 *>(pSamples), static_cast<int>(size / sizeof(qint16)), m_trimmedPcm);
+    appendTrimmedOutput();
+}
+
+void CerenceTTS::finishTrimmed(int trailingMs)
+{
+    m_trimmedPcm.clear();
+    m_silenceTrimmer.finish(trailingMs, m_trimmedPcm);
+    appendTrimmedOutput();
+    m_trimmedSamples = m_silenceTrimmer.trimmedSamples();
+}
+
+void CerenceTTS::appendTrimmedOutput()
+{
+    if (!m_trimmedPcm.empty()) {
+        appendSamples(reinterpret_cast<const char *>(m_trimmedPcm.data()), m_trimmedPcm.size() * sizeof(qint16));
+        m_synthesizedSamples += static_cast<qint64>(m_trimmedPcm.size());
+    }
+    if (!m_silenceTrimmer.isLeading() && !m_heldMarks.isEmpty()) {
+        const auto heldMarks = m_heldMarks;
+        m_heldMarks.clear();
+        for (const auto &wordMark : heldMarks)
+            addWordMark(wordMark);
+    }
+}
+
+// Mark's cntDestPos comes in samples of the utterance before trimming
+void CerenceTTS::addWordMark(WordMark wordMark)
+{
+    if (m_silenceTrimmer.isLeading()) {
+        m_heldMarks.append(wordMark);
+        return;
+    }
+    wordMark.mark.cntDestPos = static_cast<NUAN_U32>(m_utteranceStartSample
+                                                     + m_silenceTrimmer.outputPosition(wordMark.mark.cntDestPos));
+    if (!m_wordMarks.append(wordMark)) {
+        // The log is cleared by the next say(), the words past it aren't followed till then
+        if (!m_isWordMarksFull)
+            qWarning() << "Word marks log is full, words of utterance" << wordMark.utterance << "aren't followed";
+        m_isWordMarksFull = true;
+        return;
+    }
+    emit wordMarksAdded();
+}
+
+bool CerenceTTS::isStopRequested()
+{
+    QMutexLocker locker(&m_wordMarksMutex);
+    return m_synthesizedUtterances > m_synthesizingUtterance;
 }
 
 void CerenceTTS::bufferDone(size_t sizePcm, size_t sizeMarks)
 {
     if (sizePcm > 0) {
-        auto totalSize = sizePcm;
-        const auto audioBuffSize = static_cast<size_t>((*m_ppTtsAudioLayer)->bufferSize());
-        if (sizePcm < audioBuffSize) {
-            // Fill up to the buffer size with 0s, otherwise it will be not played
-            std::fill(m_ttsBuffer.data() + sizePcm, m_ttsBuffer.data() + audioBuffSize, 0);
-            totalSize = audioBuffSize;
+        // Short chunks are appended right away, only the silence waits for the speech or the utterance end
+        if (!m_isRenderingPrompt)
+            appendTrimmed(m_ttsBuffer.data(), sizePcm);
+
+        if (m_isCaching) {
+            m_synthesizedPcm.append(m_ttsBuffer.constData(), static_cast<int>(sizePcm));
+            // Too long text is not worth caching
+            if (m_synthesizedPcm.size() > PCM_CACHE_SIZE / 4)
+                m_isCaching = false;
         }
-        (*m_ppTtsAudioLayer)->appendSample(m_ttsBuffer.data(), totalSize);
     }
 
     if (sizeMarks > 0) {
         for (size_t i = 0; i < sizeMarks; ++i) {
             const auto &mark = m_ttsMarkBuffer.at(i);
             if (mark.eMrkType == VE_MRK_WORD) {
-                m_wordMarksMutex.lock();
-                m_wordMarks.append(mark);
-                m_wordMarksMutex.unlock();
-
-                emit wordMarksAdded();
+                if (m_isCaching)
+                    m_synthesizedMarks.append({static_cast<int>(mark.cntSrcPos), static_cast<int>(mark.cntSrcTextLen),
+                                               static_cast<qint64>(mark.cntDestPos)});
+                if (m_isRenderingPrompt)
+                    continue;
+
+                WordMark wordMark {mark, m_synthesizingUtterance};
+                wordMark.mark.cntSrcPos += static_cast<NUAN_U32>(m_srcOffset);
+                wordMark.mark.cntDestPos += static_cast<NUAN_U32>(m_synthesisStartSource);
+                addWordMark(wordMark);
             }
         }
     }
@@ -172,12 +549,22 @@ void CerenceTTS::initTTS(const QString &voice)
     m_stResources.fmtVersion = VPLATFORM_CURRENT_VERSION;
     m_stResources.apDataInstall = const_cast<char **>(INSTALL_PATHS);
     m_stResources.u16NbrOfDataInstall = sizeof(INSTALL_PATHS) / sizeof(INSTALL_PATHS[0]);
+    // Engine memory is pooled per voice instead of churning the allocator shared with Qt and OpenCV
+    m_stResources.bFlags = F_POOL_HEAP;
 
+    // Voice data is found by the index of the install paths, after the first engine of the process
+    QElapsedTimer timer;
+    timer.start();
     auto nErrcode = vplatform_GetInterfaces(&m_stInstall, &m_stResources);
     if (nErrcode != NUAN_OK) {
         qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
         return;
     }
+    VPLATFORM_DATA_INDEX_STATS indexStats;
+    if (vplatform_data_GetIndexStats(&indexStats) == NUAN_OK) {
+        qDebug() << "Vocalizer data of" << m_voice << "found in" << timer.elapsed() << "ms, index hits"
+                 << indexStats.cntHits << "misses" << indexStats.cntMisses;
+    }
 
     // Initialize the engine
     nErrcode = ve_ttsInitialize(&m_stInstall, &m_hSpeech);
@@ -211,6 +598,20 @@ void CerenceTTS::initTTS(const QString &voice)
         qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
         return;
     }
+    m_speechRate = m_engineRate = getParam(VE_PARAM_SPEECHRATE);
+    m_volume = m_engineVolume = getParam(VE_PARAM_VOLUME);
+    logHeapStats();
+}
+
+void CerenceTTS::logHeapStats() const
+{
+    VPLATFORM_HEAP_STATS heapStats;
+    if (vplatform_heap_GetStats(m_stInstall.hHeap, &heapStats) != NUAN_OK)
+        return;
+    qDebug() << "Vocalizer heap of" << m_voice << ":" << heapStats.cBytesInUse / 1024 << "KB in use, peak"
+             << heapStats.cBytesPeak / 1024 << "KB, reserved" << heapStats.cBytesReserved / 1024 << "KB, peak"
+             << heapStats.cBytesPeakReserved / 1024 << "KB," << heapStats.cntAlloc << "allocations,"
+             << heapStats.cntLarge << "large";
 }
 
 void CerenceTTS::initAudio() {
@@ -223,7 +624,7 @@ void CerenceTTS::initAudio() {
     // Setup audioOut
     QAudioFormat format;
     // Set up the format, eg.
-    format.setSampleRate(22050);
+    format.setSampleRate(SAMPLE_RATE);
     format.setChannelCount(1);
     format.setSampleSize(16);
     format.setCodec("audio/pcm");
@@ -240,37 +641,46 @@ void CerenceTTS::initAudio() {
     }
 }
 
+// The engine takes the parameters at the next utterance, see applyVoiceParams()
 void CerenceTTS::setSpeechRate(int nRate) {
-    VE_PARAM prm;
-    prm.eID = VE_PARAM_SPEECHRATE;
-    prm.uValue.usValue = nRate;
-    auto nErrcode = ve_ttsSetParamList(m_hTtsInst, &prm, 1);
-    if (nErrcode != NUAN_OK)
-        qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
+    QMutexLocker locker(&m_wordMarksMutex);
+    const int currentRate = m_speechRate;
+    m_speechRate = nRate;
+    if (audioLayer() && !m_bOutputToFile && currentRate > 0) {
+        // Buffered audio plays at the new rate at once, the next utterance is synthesized at it
+        if (m_audioRate == 0)
+            m_audioRate = currentRate;
+        m_pendingRate = nRate;
+        m_isNativeRatePending = true;
+        audioLayer()->setTempo(static_cast<double>(nRate) / m_audioRate);
+    }
+    locker.unlock();
+    clearVoiceCaches();
 }
 
 int CerenceTTS::getSpeechRate() {
-    VE_PARAM prm;
-    prm.eID = VE_PARAM_SPEECHRATE;
-    prm.uValue.usValue = 0;
-    auto nErrcode = ve_ttsGetParamList(m_hTtsInst, &prm, 1);
-    if (nErrcode != NUAN_OK)
-        qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
-    return (int) prm.uValue.usValue;
+    QMutexLocker locker(&m_wordMarksMutex);
+    return m_speechRate;
 }
 
+// Prompts are rendered at PROMPT_VOLUME and scaled as they're played, only the synthesized audio is stale
 void CerenceTTS::setVolume(int nVolume) {
-    VE_PARAM prm;
-    prm.eID = VE_PARAM_VOLUME;
-    prm.uValue.usValue = nVolume;
-    auto nErrcode = ve_ttsSetParamList(m_hTtsInst, &prm, 1);
-    if (nErrcode != NUAN_OK)
-        qWarning() << __func__ << __LINE__ << "error:" << ve_ttsGetErrorString(nErrcode);
+    {
+        QMutexLocker locker(&m_wordMarksMutex);
+        m_volume = nVolume;
+        ++m_voiceGeneration;
+    }
+    m_pcmCache.clear();
 }
 
 int CerenceTTS::getVolume() {
+    QMutexLocker locker(&m_wordMarksMutex);
+    return m_volume;
+}
+
+int CerenceTTS::getParam(VE_PARAMID id) {
     VE_PARAM prm;
-    prm.eID = VE_PARAM_VOLUME;
+    prm.eID = id;
     prm.uValue.usValue = 0;
     auto nErrcode = ve_ttsGetParamList(m_hTtsInst, &prm, 1);
     if (nErrcode != NUAN_OK)
@@ -278,6 +688,19 @@ int CerenceTTS::getVolume() {
     return (int) prm.uValue.usValue;
 }
 
+// Cached audio doesn't match the new voice parameters, prompts are rendered again by prerender().
+// Generation changes before the clear, so audio of the old parameters isn't inserted after it
+void CerenceTTS::clearVoiceCaches() {
+    {
+        QMutexLocker locker(&m_wordMarksMutex);
+        ++m_voiceGeneration;
+        m_promptDir.clear();
+        m_pendingPrompts.clear();
+    }
+    m_pcmCache.clear();
+    m_promptCache.clear();
+}
+
 char *CerenceTTS::buffer() {
     return m_ttsBuffer.data();
 }
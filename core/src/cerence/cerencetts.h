@@ -15,13 +15,16 @@
 #include <QVector>
 #include <QTimer>
 #include <QMap>
+#include <QThreadPool>
 
 #include <ve_ttsapi.h>
 #include <ve_platform.h>
 #include <vplatform.h>
 
 #include "cerencetts_const.h"
+#include "pcmcache.h"
 #include "positionmapper.h"
+#include "silencetrimmer.h"
 #include "../zyrlotts.h"
 
 class QAudioOutput;
@@ -38,7 +41,10 @@ public:
     ~CerenceTTS();
 
     void say(const QString &text, int delayMs = 0);
+    void sayNext(const QString &text);
     void stop();
+    void clearCache();
+    void prerender(const QStringList &texts);
 
     void bufferDone(size_t sizePcm, size_t sizeMarks);
     void setSpeechRate(int nRate); //Range 50 - 400
@@ -52,18 +58,85 @@ public:
     virtual size_t markBufferSize();
 
 signals:
-    void savingAudioDone(QString sfilename);
     void usbKeyInsert(bool bInserted);
 
 private:
     void initTTS(const QString &voice);
     void initAudio();
+    void logHeapStats() const;
+    void appendUtterance(const QString &text);
+    void synthesizeUtterances();
+    void synthesize(const QByteArray &textBytes, int srcOffset, int generation);
+    void renderPrompt(const QByteArray &textBytes, const QString &promptDir);
+    void applyVoiceParams(int speechRate, int volume);
+    void processText(const QByteArray &textBytes);
+    int getParam(VE_PARAMID id);
+    bool findPrompt(const QByteArray &textBytes, PcmCache::Hit &hit);
+    void clearVoiceCaches();
+    void appendCached(const PcmCache::Hit &hit, int srcOffset, float gain = 1.0f);
+    void appendTrimmed(const char *pSamples, size_t size);
+    void finishTrimmed(int trailingMs);
+    void appendTrimmedOutput();
+    void addWordMark(WordMark wordMark);
+    bool isStopRequested();
     //void queryLanguagesVoicesInfo();
 
 private:
     QByteArray              m_ttsBuffer {100 * 1024, 0};
     QVector<VE_MARKINFO>    m_ttsMarkBuffer {100};
 
+    // Own synthesis thread, so engines converting books in parallel don't queue in the global pool
+    QThreadPool             m_synthesisPool;
+    // Synthesis runs while there are queued utterances, guarded by m_wordMarksMutex
+    bool                    m_isSynthesizing {false};
+    int                     m_synthesizedUtterances {0};
+    // Accessed by synthesis thread only
+    int                     m_synthesizingUtterance {0};
+    qint64                  m_synthesizedSamples {0};
+    qint64                  m_synthesisStartSource {0};
+    int                     m_srcOffset {0};
+
+    // Silence around the utterances is trimmed, marks wait till their trimmed positions are known.
+    // Accessed by synthesis thread only
+    SilenceTrimmer          m_silenceTrimmer;
+    std::vector<qint16>     m_trimmedPcm;
+    QVector<WordMark>       m_heldMarks;
+    qint64                  m_utteranceStartSample {0};
+    bool                    m_isWordMarksFull {false};
+
+    // Audio of the synthesized texts, replayed when the same text is said again
+    PcmCache                m_pcmCache;
+    QByteArray              m_synthesizedPcm;
+    QVector<PcmCache::Mark> m_synthesizedMarks;
+    bool                    m_isCaching {false};
+
+    // Prompts are rendered to the cache and disk when there is nothing to say,
+    // guarded by m_wordMarksMutex
+    const QString           m_voice;
+    PcmCache                m_promptCache;
+    QVector<QByteArray>     m_pendingPrompts;
+    QString                 m_promptDir;
+    bool                    m_isPromptStopped {false};
+    // Accessed by synthesis thread only
+    bool                    m_isRenderingPrompt {false};
+    std::vector<qint16>     m_scaledPcm;
+
+    // Rate of the buffered audio, which is time-stretched till the utterance synthesized
+    // at the pending rate starts, guarded by m_wordMarksMutex
+    int                     m_audioRate {0};
+    int                     m_pendingRate {0};
+    bool                    m_isNativeRatePending {false};
+
+    // Voice parameters set by the user, the engine takes them between the utterances.
+    // Generation changes with them, so audio synthesized meanwhile isn't cached.
+    // Guarded by m_wordMarksMutex
+    int                     m_speechRate {0};
+    int                     m_volume {0};
+    int                     m_voiceGeneration {0};
+    // Parameters of the engine, accessed by synthesis thread only
+    int                     m_engineRate {0};
+    int                     m_engineVolume {0};
+
     VE_INSTALL              m_stInstall;
     VPLATFORM_RESOURCES     m_stResources;
     VE_HSPEECH              m_hSpeech;
@@ -68,9 +68,7 @@ void espeaktts::onWordMarksAdded(const espeak_EVENT & ev) {
     mark.cntSrcPos = ev.text_position;
     mark.cntDestPos = ev.audio_position * m_pTtsAudioLayer->format().sampleRate() / 1000;
     mark.cntSrcTextLen = ev.length;
-    m_wordMarksMutex.lock();
-    m_wordMarks.append(mark);
-    m_wordMarksMutex.unlock();
+    m_wordMarks.append({mark, 0});
     emit wordMarksAdded();
 }
 
@@ -113,7 +111,7 @@ void espeaktts::say(const QString &text, int delayMs) {
 }
 
 void espeaktts::stop() {
-    m_pTtsAudioLayer->stop();
+    m_pTtsAudioLayer->stopSpeech();
     espeak_Cancel();
     m_ttsFuture.waitForFinished();
 }
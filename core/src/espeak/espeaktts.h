@@ -41,7 +41,6 @@ public:
 
 
 signals:
-    void savingAudioDone(QString sfilename);
     void usbKeyInsert(bool bInserted);
 
 private:
@@ -12,6 +12,7 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <signal.h>
+#include <vthread.h>
 
 // This is important to receive cv::Mat from another thread
 Q_DECLARE_METATYPE(cv::Mat);
@@ -24,6 +25,7 @@ HWHandler::HWHandler(QObject *parent)
     // This is important to receive cv::Mat from another thread
     qRegisterMetaType<cv::Mat>();
     qRegisterMetaType<Button>();
+    m_cameraPool.setMaxThreadCount(1);
 }
 
 HWHandler::~HWHandler() {
@@ -55,7 +57,7 @@ void HWHandler::start() {
 
     m_stop = false;
     if (!m_future.isRunning())
-        m_future = QtConcurrent::run([this](){ run(); });
+        m_future = QtConcurrent::run(&m_cameraPool, [this](){ run(); });
     if (!m_buttonThread.isRunning())
         m_buttonThread = QtConcurrent::run([this](){ buttonThreadRun(); });
     if (!m_buttonBtThread.isRunning())
@@ -69,6 +71,8 @@ void HWHandler::stop()
 
 void HWHandler::run()
 {
+    // Camera loop yields to speech synthesis
+    vplatform_thread_ApplyRole(VPLATFORM_THREAD_ROLE_BACKGROUND);
     m_zcam.initCamera();
     while(!m_stop) {
         switch(m_zcam.AcquireFrameStep()) {
@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QFuture>
+#include <QThreadPool>
 #include <atomic>
 #include "zyrlocamera.h"
 #include "BaseComm.h"
@@ -83,6 +84,8 @@ signals:
 
 private:
     std::atomic_bool    m_stop {false};
+    // Own camera thread, so the lowered priority of the loop doesn't pass to the work of the global pool
+    QThreadPool         m_cameraPool;
     QFuture<void>       m_future, m_buttonThread, m_buttonBtThread, m_buttonUsbThread;
     ZyrloCamera m_zcam;
     int m_nButtonMask = -1; //0x40;
@@ -21,13 +21,19 @@
 #include "BaseComm.h"
 #include "ZyrloOcr.h"
 #include <regex>
+#include <algorithm>
 #include "tinyxml.h"
 #include <sys/types.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include "ttsaudiolayer.h"
+#include "startupsequence.h"
+#include "bookconverter.h"
+#include "speechscheduler.h"
 #include <pthread.h>
+#include <sched.h>
+#include <vthread.h>
 
 using namespace cv;
 using namespace std;
@@ -48,6 +54,7 @@ using namespace std;
 #define BOOK_AUDIO_DIR "Audio"
 #define BATTERY_TEST_FILE "/home/pi/BaterryTest.txt"
 #define USB_KEY_ROOT "/home/pi/media"
+#define BOOT_PROFILE_FILE "/home/pi/ZyrloBootProfile.txt"
 
 static int getAvailableSinks(vector<int> &vSinkIndxs, int & builtinIndx);
 static bool FindZyrloBooks(vector<string> & vBooks);
@@ -57,6 +64,10 @@ bool file_exists (const char *filename);
 
 constexpr int DELAY_ON_NAVIGATION = 1000; // ms, delay before starting TTS
 constexpr int LONG_PRESS_DELAY = 1500;
+constexpr int BEEPING_DELAY_MS = 2000;      // Beeping while the page is recognized
+constexpr int BEEPING_INTERVAL_MS = 1000;
+constexpr int MAX_PROMPT_LENGTH = 100;      // chars, longer translations (help) are synthesized when said
+constexpr qint64 TTS_ENGINES_MEMORY_BUDGET_KB = 256 * 1024;
 
 typedef enum {
     eCerence = 0,
@@ -165,34 +176,125 @@ int NextEnabledVoiceIndex(int nCurrIndx, const vector<LangVoiceComb> & vLangVoic
     return -1;
 }
 
+static qint64 residentMemoryKb() {
+    long nSize = 0, nResident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if(!fp)
+        return 0;
+    if(fscanf(fp, "%ld %ld", &nSize, &nResident) != 2)
+        nResident = 0;
+    fclose(fp);
+    return static_cast<qint64>(nResident) * sysconf(_SC_PAGESIZE) / 1024;
+}
+
 void MainController::InitTtsEngines() {
-    // Create TTS engines
-    for (const auto &language : LANGUAGES) {
-        switch(language.engine) {
-        case eCerence:
-            {auto ttsEngine = new CerenceTTS(language.voice, this, &m_pTtsAudioLayer);
-            connect(ttsEngine, &CerenceTTS::wordNotify, this, &MainController::setCurrentWord);
-            connect(ttsEngine, &CerenceTTS::sayFinished, this, &MainController::onSpeakingFinished);
-            connect(ttsEngine, &CerenceTTS::savingAudioDone, this, &MainController::onSavingAudioDone);
-            m_ttsEnginesList.append(ttsEngine);}
-            break;
-//        case eEspeak:
-//            {auto ttsEngine = new espeaktts(language.lang, language.voice, this, &m_pTtsAudioLayer);
-//            connect(ttsEngine, &espeaktts::wordNotify, this, &MainController::setCurrentWord);
-//            connect(ttsEngine, &espeaktts::sayFinished, this, &MainController::onSpeakingFinished);
-//            connect(ttsEngine, &espeaktts::savingAudioDone, this, &MainController::onSavingAudioDone);
-//            m_ttsEnginesList.append(ttsEngine);}
-//            break;
-        default:
-            qDebug() << "Unknown tts engine";
+    m_ttsEngines.clear();
+    m_ttsEngines.resize(LANGUAGES.size());
+}
+
+void MainController::ReleaseTtsEngines() {
+    for(auto &slot : m_ttsEngines)
+        delete slot.engine;
+    m_ttsEngines.clear();
+    m_ttsEngine = nullptr;
+}
+
+ZyrloTts *MainController::ttsEngine(int nIndx) {
+    auto &slot = m_ttsEngines[nIndx];
+    slot.lastUsed = ++m_ttsEngineUses;
+    if(!slot.engine)
+        createTtsEngine(nIndx);
+    return slot.engine;
+}
+
+void MainController::createTtsEngine(int nIndx) {
+    const auto &language = LANGUAGES[nIndx];
+    auto &slot = m_ttsEngines[nIndx];
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 nMemoryBeforeKb = residentMemoryKb();
+
+    switch(language.engine) {
+    case eCerence:
+        {auto ttsEngine = new CerenceTTS(language.voice, this, &m_pTtsAudioLayer);
+        connect(ttsEngine, &CerenceTTS::wordNotify, this, &MainController::setCurrentWord);
+        connect(ttsEngine, &CerenceTTS::sayFinished, this, &MainController::onSpeakingFinished);
+        connect(ttsEngine, &CerenceTTS::utteranceStarted, this, &MainController::onUtteranceStarted);
+        slot.engine = ttsEngine;}
+        break;
+//    case eEspeak:
+//        {auto ttsEngine = new espeaktts(language.lang, language.voice, this, &m_pTtsAudioLayer);
+//        connect(ttsEngine, &espeaktts::wordNotify, this, &MainController::setCurrentWord);
+//        connect(ttsEngine, &espeaktts::sayFinished, this, &MainController::onSpeakingFinished);
+//        slot.engine = ttsEngine;}
+//        break;
+    default:
+        qDebug() << "Unknown tts engine";
+        return;
+    }
+
+    setSpeechPauses(slot.engine);
+    slot.initMs = timer.elapsed();
+    slot.memoryKb = std::max<qint64>(0, residentMemoryKb() - nMemoryBeforeKb);
+    qDebug() << "TTS engine" << language.voice << "created in" << slot.initMs << "ms, resident memory"
+             << slot.memoryKb << "KB";
+    evictTtsEngines(nIndx);
+}
+
+// Engines of the current language combination are created ahead, so switching between its voices doesn't wait
+void MainController::prewarmTtsEngines() {
+    if(m_nCurrentLangaugeSettingIndx < 0 || m_nCurrentLangaugeSettingIndx >= (int)g_vLangVoiceSettings.size())
+        return;
+    for(int nIndx : g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs)
+        ttsEngine(nIndx);
+}
+
+// Least recently used voices are released when the engines exceed the memory budget. The current
+// engine and the engines of the current language combination are kept
+void MainController::evictTtsEngines(int nKeepIndx) {
+    qint64 nTotalKb = 0;
+    for(const auto &slot : m_ttsEngines)
+        nTotalKb += slot.engine ? slot.memoryKb : 0;
+
+    while(nTotalKb > TTS_ENGINES_MEMORY_BUDGET_KB) {
+        const vector<int> *pvKeepIndxs = nullptr;
+        if(m_nCurrentLangaugeSettingIndx >= 0 && m_nCurrentLangaugeSettingIndx < (int)g_vLangVoiceSettings.size())
+            pvKeepIndxs = &g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs;
+        int nEvictIndx = -1;
+        for(int i = 0; i < m_ttsEngines.size(); ++i) {
+            const auto &slot = m_ttsEngines[i];
+            if(!slot.engine || slot.engine == m_ttsEngine || i == nKeepIndx)
+                continue;
+            if(pvKeepIndxs && std::find(pvKeepIndxs->begin(), pvKeepIndxs->end(), i) != pvKeepIndxs->end())
+                continue;
+            if(nEvictIndx < 0 || slot.lastUsed < m_ttsEngines[nEvictIndx].lastUsed)
+                nEvictIndx = i;
         }
+        if(nEvictIndx < 0)
+            break;
+
+        auto &slot = m_ttsEngines[nEvictIndx];
+        qDebug() << "TTS engine" << LANGUAGES[nEvictIndx].voice << "released, resident memory" << slot.memoryKb << "KB";
+        delete slot.engine;
+        slot.engine = nullptr;
+        nTotalKb -= slot.memoryKb;
     }
 }
 
-void MainController::ReleaseTtsEngines() {
-    for(auto ttsEngine : m_ttsEnginesList)
-        delete ttsEngine;
-    m_ttsEnginesList.clear();
+void MainController::setSpeechPauses(ZyrloTts *engine) const {
+    SilenceTrimmer::Pauses pauses;
+    pauses.leadingMs = m_nLeadingPauseMs;
+    pauses.wordMs = m_nWordPauseMs;
+    pauses.clauseMs = m_nClausePauseMs;
+    pauses.sentenceMs = m_nSentencePauseMs;
+    engine->setPauses(pauses);
+}
+
+qint64 MainController::trimmedSilenceMs() const {
+    qint64 nTotalMs = 0;
+    for(const auto &slot : m_ttsEngines)
+        nTotalMs += slot.engine ? slot.engine->trimmedSilenceMs() : 0;
+    return nTotalMs;
 }
 
 string changeSubdirInPath(string path, const string & old_subir, const string & new_subir, const string & new_suffix) {
@@ -217,32 +319,90 @@ bool MatchingAudioFileExists(const string & sPath) {
 MainController::MainController()
 {
     m_hwhandler = new HWHandler(this);
-    m_hwhandler->init();
-
-    if(ReadLangVoiceSettings(g_vLangVoiceSettings))
-        FillLanguages(g_vLangVoiceSettings, LANGUAGES);
-    else
-        qDebug() << "Cant find voces.xml";
-    readSettings();
-    vector<int> vSinkIndxs;
-    m_nActiveSink = getAvailableSinks(vSinkIndxs, m_nBuiltInSink);
-    m_hwhandler->setUsingMainAudioSink( m_nActiveSink == m_nBuiltInSink );
-
-    m_nCurrentLangaugeSettingIndx = FirstEnabledVoiceIndex(m_nCurrentLangaugeSettingIndx, g_vLangVoiceSettings);
-
-    connect(&ocr(), &OcrHandler::lineAdded, this, [this]() {
-        emit textUpdated(ocr().textPage()->text());
+    m_startup = new StartupSequence(this);
+    m_speechScheduler = new SpeechScheduler;
+    m_speechClock.start();
+
+    // Book pages are converted on their own engines of the current voice, with its rate and volume
+    m_bookConverter = new BookConverter([this](QObject *parent) -> ZyrloTts * {
+        const auto &language = LANGUAGES[m_currentTTSIndex];
+        if(language.engine != eCerence || !m_ttsEngine)
+            return nullptr;
+        auto ttsEngine = new CerenceTTS(language.voice, parent, nullptr);
+        ttsEngine->setSpeechRate(m_ttsEngine->getSpeechRate());
+        ttsEngine->setVolume(m_ttsEngine->getVolume());
+        setSpeechPauses(ttsEngine);
+        return ttsEngine;
+    }, this);
+    connect(m_bookConverter, &BookConverter::pageConverted, this, &MainController::onPageConverted);
+
+    // Hardware, data files and OCR engine are loaded concurrently with the default voice in GUI thread.
+    // The reader starts when the camera and the default voice are up, other voices are loaded after it
+    m_startup->addStage("hardware", StartupSequence::Thread::Worker, {}, [this]() {
+        m_hwhandler->init();
     });
-
-    connect(&ocr(), &OcrHandler::finished, this, [this]() {
-        if(m_bUsbKeyInserted) {
-            saveScannedText();
-            ProcessNextScannedImg();
-        }
+    m_startup->addStage("settings", StartupSequence::Thread::Worker, {}, [this]() {
+        if(ReadLangVoiceSettings(g_vLangVoiceSettings))
+            FillLanguages(g_vLangVoiceSettings, LANGUAGES);
+        else
+            qDebug() << "Cant find voces.xml";
+        m_settings = readSettings();
+    });
+    m_startup->addStage("apply settings", StartupSequence::Thread::Gui, {"settings"}, [this]() {
+        applySettings(m_settings);
+    });
+    m_startup->addStage("camera settings", StartupSequence::Thread::Gui, {"settings", "hardware"}, [this]() {
+        applyCameraSettings(m_settings);
+    });
+    m_startup->addStage("audio sinks", StartupSequence::Thread::Worker, {}, [this]() {
+        vector<int> vSinkIndxs;
+        m_nActiveSink = getAvailableSinks(vSinkIndxs, m_nBuiltInSink);
+    });
+    m_startup->addStage("ocr engine", StartupSequence::Thread::Worker, {}, []() {
+        OcrHandler::initEngine();
+    });
+    m_startup->addStage("translations", StartupSequence::Thread::Worker, {}, [this]() {
+        m_translator.Init(TRANSLATION_FILE);
+        //m_help.Init(HELP_FILE);
+    });
+    m_startup->addStage("sounds", StartupSequence::Thread::Gui, {}, [this]() {
+        TtsAudioLayer::loadEarcon(Earcon::Shutter, SHUTER_SOUND_WAVE_FILE);
+        TtsAudioLayer::loadEarcon(Earcon::Beep, BEEP_SOUND_WAVE_FILE);
+        TtsAudioLayer::loadEarcon(Earcon::ArmOpen, ARMOPEN_SOUND_FILE);
+        TtsAudioLayer::loadEarcon(Earcon::ArmClosed, ARMCLOSED_SOUND_FILE);
+    });
+    // Direct output is used on the built-in sink only, so the voice waits for the active sink
+    m_startup->addStage("default voice", StartupSequence::Thread::Gui, {"apply settings", "audio sinks"}, [this]() {
+        updateDirectAudioOutput();
+        setupAudioLayer(TtsAudioLayer::instance(this));
+        InitTtsEngines();
+        m_currentTTSIndex = g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs[0];
+        SetTTsEngine(m_currentTTSIndex);
+    });
+    m_startup->addStage("ocr", StartupSequence::Thread::Gui, {"ocr engine"}, [this]() {
+        connectOcr();
+    });
+    m_startup->addStage("ready", StartupSequence::Thread::Gui,
+                        {"camera settings", "audio sinks", "translations", "sounds", "default voice", "ocr"}, [this]() {
+        m_hwhandler->setUsingMainAudioSink( m_nActiveSink == m_nBuiltInSink );
+        m_translator.SetLanguage(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs[0].lang.toStdString().c_str());
+        //m_help.SetLanguage(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs[0].lang.toStdString().c_str());
+        // Buttons, keypad and camera input starts here, when the voice and the audio layer exist
+        m_hwhandler->start();
+        if(!m_hwhandler->kpConfig().empty())
+            strcpy(m_btKbdMac, m_hwhandler->kpConfig().c_str());
+        emit ready();
+    });
+    m_startup->addStage("voices", StartupSequence::Thread::Gui, {"ready"}, [this]() {
+        prewarmTtsEngines();
+        prerenderPrompts();
+    });
+    connect(m_startup, &StartupSequence::finished, this, [this]() {
+        qDebug().noquote() << "Startup profile:\n" << m_startup->report();
+        if(!m_startup->writeReport(BOOT_PROFILE_FILE))
+            qWarning() << "Can't write startup profile to" << BOOT_PROFILE_FILE;
     });
 
-
-    connect(&ocr(), &OcrHandler::lineAdded, this, &MainController::onNewTextExtracted);
     connect(this, &MainController::toggleAudioOutput, this, &MainController::onToggleAudioSink);
     connect(this, &MainController::spellCurrentWord, this, &MainController::onSpellCurrentWord);
     connect(this, &MainController::toggleGestures, this, &MainController::onToggleGestures);
@@ -254,11 +414,11 @@ MainController::MainController()
     connect(m_hwhandler, &HWHandler::imageReceived, this, [this](const Mat &image, bool bPlayShutterSound) {
         if(m_bMenuOpen)
             return;
-        if(bPlayShutterSound)
+        // Click is decoded in advance and mixed into the output, so it starts with the next period
+        if(bPlayShutterSound) {
             m_ttsEngine->stop();
-
-        if(m_shutterSound && bPlayShutterSound)
-            m_shutterSound->play();
+            playEarcon(Earcon::Shutter);
+        }
         if(m_hwhandler->IsUsbKeyInserted()) {
             saveScannedImage(image);
         }
@@ -271,12 +431,6 @@ MainController::MainController()
         qDebug() << "received" << (int)button;
     }, Qt::QueuedConnection);
 
-    m_pTtsAudioLayer = TtsAudioLayer::instance(this);
-    InitTtsEngines();
-
-    m_currentTTSIndex = g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs[0];
-    SetTTsEngine(m_currentTTSIndex);
-
     connect(m_hwhandler, &HWHandler::readerReady, this, &MainController::readerReady, Qt::QueuedConnection);
     connect(m_hwhandler, &HWHandler::targetNotFound, this, &MainController::targetNotFound, Qt::QueuedConnection);
     connect(m_hwhandler, &HWHandler::previewImgUpdate, this, &MainController::previewImgUpdate, Qt::QueuedConnection);
@@ -288,17 +442,38 @@ MainController::MainController()
     connect(m_hwhandler, &HWHandler::usbKpConnect, this, &MainController::onUsbKpConnect, Qt::QueuedConnection);
     connect(m_hwhandler, &HWHandler::onBtKpRegistered, this, &MainController::onBtKpRegistered, Qt::QueuedConnection);
 
-    m_translator.Init(TRANSLATION_FILE);
-    //m_help.Init(HELP_FILE);
-    m_translator.SetLanguage(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs[0].lang.toStdString().c_str());
-    //m_help.SetLanguage(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs[0].lang.toStdString().c_str());
-    m_shutterSound = new QSound(SHUTER_SOUND_WAVE_FILE, this);
-    m_beepSound = new QSound(BEEP_SOUND_WAVE_FILE, this);
-    m_armOpenSound = new QSound(ARMOPEN_SOUND_FILE, this);
-    m_armClosedSound = new QSound(ARMCLOSED_SOUND_FILE, this);
-    m_hwhandler->start();
-    if(!m_hwhandler->kpConfig().empty())
-        strcpy(m_btKbdMac, m_hwhandler->kpConfig().c_str());
+    m_startup->start();
+}
+
+void MainController::connectOcr()
+{
+    connect(&ocr(), &OcrHandler::pageStarted, this, [this]() {
+        m_sentTextLength = 0;
+        emit textReset();
+    });
+
+    connect(&ocr(), &OcrHandler::lineAdded, this, [this]() {
+        const auto page = ocr().textPage();
+        const auto text = page->text();
+        if (text.size() <= m_sentTextLength)
+            return;
+
+        const auto offset = m_sentTextLength;
+        m_sentTextLength = text.size();
+        emit textAppended(offset, text.mid(offset));
+    });
+
+    connect(&ocr(), &OcrHandler::finished, this, [this]() {
+        if(m_bUsbKeyInserted && !m_vScannedImagesQue.empty()) {
+            // Audio is synthesized while OCR extracts the text of the next page
+            saveScannedText();
+            ConvertTextToAudio(m_sCurrentImgPath);
+            m_vScannedImagesQue.pop_front();
+            ProcessNextScannedImg();
+        }
+    });
+
+    connect(&ocr(), &OcrHandler::lineAdded, this, &MainController::onNewTextExtracted);
 }
 
 void MainController::startFile(const QString &filename)
@@ -310,12 +485,22 @@ void MainController::startFile(const QString &filename)
 void MainController::startImage(const Mat &image)
 {
     m_ttsEngine->stop();
+    m_speechScheduler->stop();
+    // Replay cache is for re-reading of the current page only
+    for (const auto &slot : m_ttsEngines) {
+        if (slot.engine)
+            slot.engine->clearCache();
+    }
 
     m_ttsStartPositionInParagraph = 0;
     m_currentParagraphNum = 0;
     m_currentWordPosition.clear();
     m_wordNavigationWithDelay = false;
     m_isContinueAfterSpeakingFinished = true;
+    m_isFirstUtterance = true;
+    m_isFirstWordPending = true;
+    m_pageTimer.start();
+    m_pageTrimmedSilenceMs = trimmedSilenceMs();
     ocr().setForceSingleColumn(m_bForceSingleColumn);
     m_bForceSingleColumn = false;
     ocr().startProcess(image);
@@ -413,7 +598,7 @@ void MainController::backWord()
         sayTranslationTag(TOP_OF_TEXT);
     } else {
         m_wordNavigationWithDelay = m_state == State::SpeakingPage;
-        sayText(prepareTextToSpeak(paragraph().text().mid(position.parPos(), position.length())));
+        sayText(prepareTextToSpeak(paragraph().textView().mid(position.parPos(), position.length()).toString()));
     }
 }
 
@@ -442,7 +627,7 @@ void MainController::nextWord()
     m_ttsStartPositionInParagraph = position.parPos();
 
     m_wordNavigationWithDelay = m_state == State::SpeakingPage;
-    sayText(prepareTextToSpeak(paragraph().text().mid(position.parPos(), position.length())));
+    sayText(prepareTextToSpeak(paragraph().textView().mid(position.parPos(), position.length()).toString()));
 }
 
 void MainController::backSentence()
@@ -483,7 +668,7 @@ void MainController::backSentence()
     if(m_isContinueAfterSpeakingFinished)
         startSpeaking();
     else
-        m_ttsEngine->say(prepareTextToSpeak(paragraph().text().mid(position.parPos(), position.length())));
+        m_ttsEngine->say(prepareTextToSpeak(paragraph().textView().mid(position.parPos(), position.length()).toString()));
 }
 
 void MainController::nextSentence() {
@@ -523,7 +708,7 @@ void MainController::nextSentence() {
     if(m_isContinueAfterSpeakingFinished)
         startSpeaking();
     else
-        m_ttsEngine->say(prepareTextToSpeak(paragraph().text().mid(position.parPos(), position.length())));
+        m_ttsEngine->say(prepareTextToSpeak(paragraph().textView().mid(position.parPos(), position.length()).toString()));
 }
 
 
@@ -642,7 +827,7 @@ void MainController::nextSymbol() {
 
     m_nCurrNavPos = position.parPos();
     m_wordNavigationWithDelay = false;
-    QChar smbl = paragraph().text().at(m_nCurrNavPos);
+    QChar smbl = paragraph().textView().at(m_nCurrNavPos);
     if(smbl != L'\0')
         sayText(GetCharName(smbl));
 }
@@ -690,35 +875,73 @@ void MainController::backSymbol() {
 
     m_nCurrNavPos = position.parPos();
     m_wordNavigationWithDelay = false;
-    QChar smbl = paragraph().text().at(m_nCurrNavPos);
+    QChar smbl = paragraph().textView().at(m_nCurrNavPos);
     if(smbl != L'\0')
         sayText(GetCharName(smbl));
 }
 
 void MainController::sayText(QString text, bool bAfter)
 {
-    SetDefaultTts();
-    if (m_ttsEngine) {
-        if (m_state != State::SpeakingText) {
-            qDebug() << __func__ << "saving current state" << (int)m_state
-                     << "and speaking text:" << text;
-            m_prevState = m_state;
-            m_state = State::SpeakingText;
-        }
-        if(bAfter)
-            m_ttsEngine->sayAfter(text);
-        else
-            m_ttsEngine->say(text);
-    } else {
+    saySpeech(text, SpeechPriority::Feedback, bAfter);
+}
+
+// Queued prompt waits for the current speech, otherwise it interrupts the less important one
+void MainController::saySpeech(const QString &text, SpeechPriority priority, bool bQueued)
+{
+    if (!m_ttsEngine) {
         qWarning() << "TTS engine is not created, can't say text:" << text;
+        return;
+    }
+    // Speech stopped or paused by the user doesn't hold the prompts
+    if (m_ttsEngine->isStoppedSpeaking() || m_ttsEngine->isPaused())
+        m_speechScheduler->stop();
+
+    switch (m_speechScheduler->submit(text, priority, bQueued, m_speechClock.elapsed())) {
+    case SpeechScheduler::Decision::Start:
+        startPrompt(text);
+        break;
+    case SpeechScheduler::Decision::Queue:
+        qDebug() << __func__ << "queued" << m_speechScheduler->queueSize() << "text:" << text;
+        break;
+    case SpeechScheduler::Decision::Drop:
+        qDebug() << __func__ << "already said, dropped text:" << text;
+        break;
     }
 }
 
+void MainController::startPrompt(const QString &text)
+{
+    SetDefaultTts();
+    m_speechQueue.clear();
+    if (m_state != State::SpeakingText) {
+        qDebug() << __func__ << "saving current state" << (int)m_state
+                 << "and speaking text:" << text;
+        m_prevState = m_state;
+        m_state = State::SpeakingText;
+    }
+    m_ttsEngine->say(text);
+}
+
 void MainController::sayTranslationTag(const QString &tag, bool bAfter)
 {
     sayText(translateTag(tag), bAfter);
 }
 
+// Announcements are said by the default engine of the current language setting
+void MainController::prerenderPrompts()
+{
+    if (!m_ttsEngine)
+        return;
+
+    QStringList prompts;
+    for (const auto &text : m_translator.GetStrings()) {
+        const QString prompt(text.c_str());
+        if (prompt.size() <= MAX_PROMPT_LENGTH)
+            prompts.append(prompt);
+    }
+    m_ttsEngine->prerender(prompts);
+}
+
 void MainController::spellText(const QString &text)
 {
     sayText(QStringLiteral(CERENCE_ESC R"(\tn=spell\%1)").arg(text));
@@ -818,28 +1041,23 @@ bool MainController::setAudioSink(int indx) {
     pclose(fp);
     if(!bret)
         return false;
-    if(m_shutterSound) {
-        delete m_shutterSound;
-        m_shutterSound = new QSound(SHUTER_SOUND_WAVE_FILE, this);
-    }
-    if(m_beepSound) {
-        delete m_beepSound;
-        m_beepSound = new QSound(BEEP_SOUND_WAVE_FILE, this);
-    }
-    if(m_armOpenSound) {
-        delete m_armOpenSound;
-        m_armOpenSound = new QSound(ARMOPEN_SOUND_FILE, this);
-    }
-    if(m_armClosedSound) {
-        delete m_armClosedSound;
-        m_armClosedSound = new QSound(ARMOPEN_SOUND_FILE, this);
-    }
-    resetAudio();
     m_nActiveSink = indx;
+    updateDirectAudioOutput();
+    resetAudio();
     m_hwhandler->setUsingMainAudioSink( m_nActiveSink == m_nBuiltInSink );
     return bret;
 }
 
+// Bluetooth sinks are reached through PulseAudio only, so the direct output plays the built-in speaker
+bool MainController::updateDirectAudioOutput() const {
+    AlsaOutput::Config config;
+    config.device = m_sAlsaDevice;
+    config.periodUs = m_nAlsaPeriodUs;
+    config.bufferUs = m_nAlsaBufferUs;
+    config.priority = m_nAlsaThreadPriority;
+    return TtsAudioLayer::setDirectOutput(m_bDirectAudioOutput && m_nActiveSink == m_nBuiltInSink, config);
+}
+
 bool MainController::switchToBuiltInSink() {
     vector<int> vSinkIndxs;
     int builtinIndx = -1;
@@ -862,27 +1080,24 @@ bool MainController::toggleAudioSink() {
 
 void MainController::onToggleAudioSink() {
     toggleAudioSink();
-    m_beepSound->play();
+    playEarcon(Earcon::Beep);
 }
 
 void MainController::readerReady() {
     stopBeeping();
     if(m_bUsbKeyInserted)
-        sayText(translateTag(PLACE_DOC), true);
+        saySpeech(translateTag(PLACE_DOC), SpeechPriority::Alert, true);
     else {
         m_state = State::Paused;
         if (m_ttsEngine->isSpeaking())
             m_ttsEngine->pause();
-        sayTranslationTag(PLACE_DOC);
+        saySpeech(translateTag(PLACE_DOC), SpeechPriority::Alert);
     }
 }
 
 void MainController::targetNotFound()
 {
-    if(m_bUsbKeyInserted)
-        sayText(translateTag(CLEAR_SURF), true);
-    else
-        sayTranslationTag(CLEAR_SURF);
+    saySpeech(translateTag(CLEAR_SURF), SpeechPriority::Alert, m_bUsbKeyInserted);
 }
 
 const OcrHandler &MainController::ocr() const
@@ -898,14 +1113,23 @@ void MainController::startSpeaking(int delayMs)
     while (true) {
         qDebug() << __func__ << "current paragraph" << m_currentParagraphNum
                  << "position in paragraph" << m_ttsStartPositionInParagraph;
-        auto currText = ocr().textPage()->getText(m_currentParagraphNum, m_ttsStartPositionInParagraph);
+        // Only the first utterance starts early, the rest of the page continues from
+        // where it stopped, so no words are said twice or skipped
+        const auto boundary = m_isFirstUtterance ? m_speechStartBoundary : TextPage::Boundary::Line;
+        auto currText = ocr().textPage()->getText(m_currentParagraphNum, m_ttsStartPositionInParagraph, boundary);
 
         if (!currText.second.isEmpty()) {
+            m_isFirstUtterance = false;
             m_currentText = currText.second;
+            m_currentLang = currText.first;
             SetCurrentTts(currText.first);
             // Continue speaking if there is more text in the current paragraph
             //qDebug() << __func__ << m_currentText;
+            m_speechQueue.clear();
+            m_nextUtterance = 1;
+            m_speechScheduler->startPage(m_speechClock.elapsed());
             m_ttsEngine->say(prepareTextToSpeak(m_currentText), delayMs);
+            queueLookAhead();
         } else if (m_currentParagraphNum + 1 <= ocr().processingParagraphNum()) {
             // Advance to the next paragraph if the current one is completed and
             // all text pronounced
@@ -914,7 +1138,9 @@ void MainController::startSpeaking(int delayMs)
             continue;
         } else if (ocr().textPage()->isComplete()) {
             // Page finished
-            qDebug() << "Page finished";
+            qDebug() << "Page finished, trimmed silence"
+                     << std::max<qint64>(0, trimmedSilenceMs() - m_pageTrimmedSilenceMs) / 1000.0 << "s";
+            qDebug() << m_speechScheduler->report();
             m_state = State::Stopped;
             sayTranslationTag(END_OF_TEXT);
             emit finished();
@@ -924,6 +1150,60 @@ void MainController::startSpeaking(int delayMs)
     }
 }
 
+// Queues the text following the current one, so it's synthesized while the
+// current text is played and there is no pause between them
+void MainController::queueLookAhead()
+{
+    if (!isPageValid() || m_state != State::SpeakingPage || !m_isContinueAfterSpeakingFinished || m_wordNavigationWithDelay)
+        return;
+
+    int paragraphNum = m_currentParagraphNum;
+    int position = m_ttsStartPositionInParagraph + m_currentText.size();
+    if (!m_speechQueue.empty()) {
+        paragraphNum = m_speechQueue.back().paragraphNum;
+        position = m_speechQueue.back().position + m_speechQueue.back().text.size();
+    }
+
+    while (static_cast<int>(m_speechQueue.size()) < m_lookAheadUtterances) {
+        const auto nextText = ocr().textPage()->getText(paragraphNum, position);
+        if (nextText.second.isEmpty()) {
+            if (paragraphNum + 1 <= ocr().processingParagraphNum()) {
+                ++paragraphNum;
+                position = 0;
+                continue;
+            }
+            break;
+        }
+
+        // Text in other language is said by other engine after this one finishes
+        if (nextText.first != m_currentLang)
+            break;
+
+        m_speechQueue.push_back({paragraphNum, position, nextText.second, m_nextUtterance++});
+        m_ttsEngine->sayNext(prepareTextToSpeak(nextText.second));
+        position += nextText.second.size();
+    }
+}
+
+void MainController::onUtteranceStarted(int utterance)
+{
+    if (m_state != State::SpeakingPage)
+        return;
+
+    while (!m_speechQueue.empty() && m_speechQueue.front().utterance <= utterance) {
+        const auto &segment = m_speechQueue.front();
+        if (segment.utterance == utterance) {
+            m_currentParagraphNum = segment.paragraphNum;
+            m_ttsStartPositionInParagraph = segment.position;
+            m_currentText = segment.text;
+            qDebug() << __func__ << utterance << "audio underruns" << m_pTtsAudioLayer->underruns();
+        }
+        m_speechQueue.pop_front();
+    }
+
+    queueLookAhead();
+}
+
 const Paragraph &MainController::paragraph() const
 {
     return ocr().textPage()->paragraph(m_currentParagraphNum);
@@ -954,10 +1234,25 @@ void MainController::onNewTextExtracted() {
         qDebug() << __func__ << m_currentParagraphNum;
         // If TTS stopped and there is more text extracted, then continue speaking
         startSpeaking();
+    } else if (m_state == State::SpeakingPage && m_ttsEngine->isSpeaking()) {
+        queueLookAhead();
     }
 }
 
 void MainController::onSpeakingFinished() {
+    QString nextText;
+    if (m_speechScheduler->next(nextText, m_speechClock.elapsed())) {
+        if (m_state == State::SpeakingPage) {
+            // Page segment is finished, the page continues after the prompt with the next word
+            m_currentWordPosition = TextPosition(m_currentWordPosition.parPos() + m_currentWordPosition.length(),
+                                                 m_currentWordPosition.length(),
+                                                 paragraph().paragraphPosition());
+            if (!m_isContinueAfterSpeakingFinished)
+                m_state = State::Paused;
+        }
+        startPrompt(nextText);
+        return;
+    }
     if(m_bUsbKeyInserted) {
         ProcessNextScannedImg();
         return;
@@ -977,6 +1272,8 @@ void MainController::onSpeakingFinished() {
             qDebug() << "advancing text to" << m_currentWordPosition.length();
         }
         qDebug() << __func__ << "position in paragraph" << m_ttsStartPositionInParagraph;
+        if (!m_wordNavigationWithDelay)
+            m_utteranceGapTimer.start();
         startSpeaking(m_wordNavigationWithDelay ? DELAY_ON_NAVIGATION : 0);
     }
 
@@ -997,6 +1294,22 @@ void MainController::setCurrentWord(int wordPosition, int wordLength)
     if(!isPageValid() || m_state == State::SpeakingText || m_currentParagraphNum < 0)
         return;
 
+    if (m_utteranceGapTimer.isValid()) {
+        qInfo() << "Inter-utterance gap" << m_utteranceGapTimer.elapsed() << "ms";
+        m_utteranceGapTimer.invalidate();
+    }
+
+    if (m_isFirstWordPending) {
+        m_isFirstWordPending = false;
+        auto &stats = m_firstWordStats[static_cast<int>(m_speechStartBoundary)];
+        stats.lastMs = m_pageTimer.elapsed();
+        stats.totalMs += stats.lastMs;
+        stats.maxMs = std::max(stats.maxMs, stats.lastMs);
+        ++stats.count;
+        qInfo() << "Time to first word" << stats.lastMs << "ms, boundary" << static_cast<int>(m_speechStartBoundary)
+                << "average" << stats.totalMs / stats.count << "ms, max" << stats.maxMs << "ms";
+    }
+
     TextPosition wordPos{m_ttsStartPositionInParagraph + wordPosition,
                 wordLength,
                 paragraph().paragraphPosition()};
@@ -1008,16 +1321,10 @@ void MainController::previewImgUpdate(const Mat & prevImg) {
     emit previewUpdated(prevImg);
 }
 
+// Beeps are timed by the audio output, the ones that would cut into the speech are skipped
 void MainController::startBeeping() {
-    if(!m_beepSound)
-        return;
-    if (!m_beepingThread.isRunning())
-        m_beepingThread = QtConcurrent::run([this]() {
-            for(m_bKeepBeeping = true, QThread::msleep(2000); m_bKeepBeeping; QThread::msleep(1000)) {
-                if(!m_ttsEngine->isSpeaking())
-                    m_beepSound->play();
-            }
-        });
+    if(m_pTtsAudioLayer)
+        m_pTtsAudioLayer->startRepeating(Earcon::Beep, BEEPING_DELAY_MS, BEEPING_INTERVAL_MS);
 }
 
 void MainController::startLongPressTimer(void (MainController::*action)(void), int nDelay) {
@@ -1041,7 +1348,13 @@ void MainController::stopLongPressTimer() {
 }
 
 void MainController::stopBeeping() {
-    m_bKeepBeeping = false;
+    if(m_pTtsAudioLayer)
+        m_pTtsAudioLayer->stopRepeating();
+}
+
+void MainController::playEarcon(Earcon earcon) {
+    if(m_pTtsAudioLayer)
+        m_pTtsAudioLayer->playEarcon(earcon);
 }
 
 void MainController::SaveImage(int indx) {
@@ -1051,7 +1364,7 @@ void MainController::SaveImage(int indx) {
 
 void MainController::ReadImage(int indx) {
     if(!m_hwhandler->recallSavedImage(indx)) {
-        m_beepSound->play();
+        playEarcon(Earcon::Beep);
         return;
     }
     sayTranslationTag(PAGE_RECALL);
@@ -1091,6 +1404,8 @@ static string getHelpTag(int nButton) {
 void MainController::onBtButton(int nButton, bool bDown) {
     if(nButton < 1 || nButton > 10)
         return;
+    if(bDown && m_pTtsAudioLayer)
+        m_pTtsAudioLayer->markRequest();
     if(bDown) {
         if((1 << KP_BUTTON_HELP) & m_keypadButtonMask) {
             m_keypadButtonMask |= (1 << nButton);
@@ -1107,8 +1422,8 @@ void MainController::onBtButton(int nButton, bool bDown) {
             if(m_bUsbKeyInserted) {
                 if(StartProcessScannedImages())
                     sayText(QString::number(m_nImagesToConvert) + " " + translateTag(USB_FILES_TO_CONVERT));
-                else if(m_beepSound)
-                    m_beepSound->play();
+                else
+                    playEarcon(Earcon::Beep);
                 break;
             }
             pauseResume();
@@ -1240,10 +1555,11 @@ static int findOneOfTheButtons(int nButtons) {
 }
 
 void MainController::onButton(int nButton, bool bDown) {
+    if(bDown && m_pTtsAudioLayer)
+        m_pTtsAudioLayer->markRequest();
     if(bDown) {
         if(SWITCH_FOLDED_MASK & nButton) {
-            if(m_armOpenSound)
-                m_armOpenSound->play();
+            playEarcon(Earcon::ArmOpen);
             m_hwhandler->setCameraArmPosition(true);
             setLed(true);
         }
@@ -1330,8 +1646,7 @@ void MainController::onButton(int nButton, bool bDown) {
         if(SWITCH_FOLDED_MASK & nButton) {
             m_hwhandler->setCameraArmPosition(false);
             setLed(false);
-            if(m_armClosedSound)
-                m_armClosedSound->play();
+            playEarcon(Earcon::ArmClosed);
         }
         if(m_deviceButtonsMask != 0) {
             m_deviceButtonsMask = 0;
@@ -1367,9 +1682,11 @@ static QString buildVoicesString(const vector<LangVoice> & vlangs) {
 }
 
 void MainController::onToggleVoice() {
+    if(!isReady())
+        return;
     if (m_ttsEngine->isSpeaking())
         m_ttsEngine->pause();
-    m_beepSound->play();
+    playEarcon(Earcon::Beep);
 
     //setlocale(LC_ALL, "C");
     int nIndx = NextEnabledVoiceIndex(m_nCurrentLangaugeSettingIndx, g_vLangVoiceSettings);
@@ -1383,6 +1700,8 @@ void MainController::onToggleVoice() {
     //m_help.SetLanguage(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs.front().lang.toStdString());
     m_currentTTSIndex = g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs.front();
     SetTTsEngine(m_currentTTSIndex);
+    prewarmTtsEngines();
+    prerenderPrompts();
     QString sMsg(((g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_ttsEngIndxs.size() > 1) ? m_translator.GetString(VOICE_SET_AUTO) : m_translator.GetString(VOICE_SET_TO)).c_str());
     sayText(sMsg + buildVoicesString(g_vLangVoiceSettings[m_nCurrentLangaugeSettingIndx].m_vlangs));
     writeSettings();
@@ -1391,7 +1710,7 @@ void MainController::onToggleVoice() {
 void MainController::SetTTsEngine(int nIndx) {
     if(m_ttsEngine)
         m_ttsEngine->disconnectFromAudioLayer();
-    m_ttsEngine = m_ttsEnginesList[m_currentTTSIndex];
+    m_ttsEngine = ttsEngine(m_currentTTSIndex);
     m_ttsEngine->connectToAudioLayer();
 }
 
@@ -1424,7 +1743,7 @@ void MainController::onSpellCurrentWord() {
 
     auto position = paragraph().currentWordPosition(m_currentWordPosition.parPos());
     if (position.isValid()) {
-        spellText(paragraph().text().mid(position.parPos(), position.length()));
+        spellText(paragraph().textView().mid(position.parPos(), position.length()).toString());
     }
 }
 
@@ -1436,19 +1755,33 @@ void MainController::resetAudio()
 {
     if(m_ttsEngine)
         m_ttsEngine->disconnectFromAudioLayer();
-    m_pTtsAudioLayer = TtsAudioLayer::reset();
+    setupAudioLayer(TtsAudioLayer::reset());
     m_ttsEngine->connectToAudioLayer();
 }
 
+void MainController::setupAudioLayer(TtsAudioLayer *audioLayer)
+{
+    m_pTtsAudioLayer = audioLayer;
+    m_pTtsAudioLayer->setNotifyPeriod(m_wordNotifyIntervalMs);
+    m_isAudioBusy = m_pTtsAudioLayer->isBusy();
+    connect(m_pTtsAudioLayer, &TtsAudioLayer::busyChanged, this, [this](bool isBusy) {
+        m_isAudioBusy = isBusy;
+    });
+}
+
 void MainController::changeVoiceSpeed(int nStep) {
     if(!m_ttsEngine)
         return;
-    if (m_ttsEngine->isSpeaking())
+    // The page being read changes its tempo at once, which is the feedback itself
+    const bool isReadingPage = m_state == State::SpeakingPage && m_ttsEngine->isSpeaking();
+    if (m_ttsEngine->isSpeaking() && !isReadingPage)
         m_ttsEngine->pause();
     int nCurrRate = m_ttsEngine->getSpeechRate();
     qDebug() << "changeVoiceSpeed" << nCurrRate << Qt::endl;
     m_ttsEngine->setSpeechRate(nCurrRate + nStep);
-    sayTranslationTag((nStep > 0) ? "SPEECH_SPEED_UP" : "SPEECH_SPEED_DN");
+    prerenderPrompts();
+    if (!isReadingPage)
+        sayTranslationTag((nStep > 0) ? "SPEECH_SPEED_UP" : "SPEECH_SPEED_DN");
 }
 
 void MainController::changeVoiceVolume(int nStep) {
@@ -1473,8 +1806,7 @@ QString MainController::prepareTextToSpeak(QString text)
 void MainController::onSayBatteryStatus() {
     int nLevel = m_hwhandler->getMainBatteryPercent();
     if(nLevel < 0) {
-        if(m_beepSound)
-            m_beepSound->play();
+        playEarcon(Earcon::Beep);
         return;
     }
     nLevel = min(nLevel * 10 / 9, 100);
@@ -1488,8 +1820,7 @@ void MainController::onToggleGestures() {
 }
 
 void MainController::onToggleSingleColumn() {
-    if(m_beepSound)
-        m_beepSound->play();
+    playEarcon(Earcon::Beep);
     m_bForceSingleColumn = !m_bForceSingleColumn;
     sayTranslationTag(m_bForceSingleColumn ? READ_THRU_COLUMNS : READ_NORMAL);
 }
@@ -1504,15 +1835,13 @@ void MainController::onGesture(int nGest) {
 }
 
 MainController::~MainController() {
-    writeSettings();
-    if(m_shutterSound)
-        delete m_shutterSound;
-    if(m_beepSound)
-        delete m_beepSound;
-    if(m_armOpenSound)
-        delete m_armOpenSound;
-    if(m_armClosedSound)
-        delete m_armClosedSound;
+    // Settings are not overwritten with defaults if they weren't read yet
+    const bool bSettingsRead = m_startup->isFinished("apply settings") && m_startup->isFinished("camera settings");
+    delete m_startup;
+    m_startup = nullptr;
+    if(bSettingsRead)
+        writeSettings();
+    delete m_speechScheduler;
 }
 
 bool MainController::write_keypad_config(const string & text) {
@@ -1591,7 +1920,7 @@ bool isLastEnabledVoice(int nIndx) {
 
 void MainController::toggleVoiceEnabled(int nIndx) {
     if(isLastEnabledVoice(nIndx)) {
-        m_beepSound->play();
+        playEarcon(Earcon::Beep);
         return;
     }
     m_bVoiceSettingsChanged = true;
@@ -1614,30 +1943,91 @@ void MainController::getListOfAboutItems(QStringList & list) const {
     list.push_back(translateTag(MENU_VERSION) + " " + SW_VERSION + " -- " + QString::number(m_hwhandler->getVersion()));
 }
 
-void MainController::readSettings() {
+template <typename T, typename Stored = T>
+static void readSetting(const FileStorage &file, const char *name, std::optional<T> &value)
+{
+    const FileNode fn = file[name];
+    if(fn.empty())
+        return;
+    Stored stored;
+    fn >> stored;
+    value = static_cast<T>(stored);
+}
+
+// Runs on a worker, so the values are only parsed here and applied in GUI thread
+MainController::Settings MainController::readSettings() {
     FileStorage file(SETTINGS_FILE_PATH,  FileStorage::READ);
-    FileNode fn;
-    fn = file["nCurrentLangaugeSettingIndx"];
-    if (!fn.empty())
-        fn >> m_nCurrentLangaugeSettingIndx;
-//    fn = file["navigationMode"];
-//    if (!fn.empty()) {
-//        int navigationMode;
-//        fn >> navigationMode;
-//        m_navigationMode = (NavigationMode) navigationMode;
-//    }
-    fn = file["bUseCameraFlash"];
-    if (!fn.empty()) {
-        int bUseCameraFlash;
-        fn >> bUseCameraFlash;
-        m_hwhandler->setUseCameraFlash(bUseCameraFlash);
-    }
-    fn = file["fExposureStep"];
-    if(!fn.empty()) {
-        float fExposureStep;
-        fn >> fExposureStep;
-        m_hwhandler->setExposureStep(fExposureStep);
-    }
+    Settings settings;
+    readSetting(file, "nCurrentLangaugeSettingIndx", settings.nCurrentLangaugeSettingIndx);
+    readSetting<bool, int>(file, "bUseCameraFlash", settings.bUseCameraFlash);
+    readSetting(file, "fExposureStep", settings.fExposureStep);
+    readSetting(file, "nLookAheadUtterances", settings.nLookAheadUtterances);
+    readSetting(file, "nConversionWorkers", settings.nConversionWorkers);
+    readSetting(file, "nSpeechThreadNice", settings.nSpeechThreadNice);
+    readSetting(file, "nCameraThreadNice", settings.nCameraThreadNice);
+    readSetting(file, "nLeadingPauseMs", settings.nLeadingPauseMs);
+    readSetting(file, "nWordPauseMs", settings.nWordPauseMs);
+    readSetting(file, "nClausePauseMs", settings.nClausePauseMs);
+    readSetting(file, "nSentencePauseMs", settings.nSentencePauseMs);
+    readSetting<bool, int>(file, "bDirectAudioOutput", settings.bDirectAudioOutput);
+    readSetting(file, "sAlsaDevice", settings.sAlsaDevice);
+    readSetting(file, "nAlsaPeriodUs", settings.nAlsaPeriodUs);
+    readSetting(file, "nAlsaBufferUs", settings.nAlsaBufferUs);
+    readSetting(file, "nAlsaThreadPriority", settings.nAlsaThreadPriority);
+    readSetting(file, "nWordNotifyIntervalMs", settings.nWordNotifyIntervalMs);
+    readSetting(file, "nSpeechStartBoundary", settings.nSpeechStartBoundary);
+    return settings;
+}
+
+void MainController::applySettings(const Settings &settings) {
+    if(settings.nCurrentLangaugeSettingIndx)
+        m_nCurrentLangaugeSettingIndx = *settings.nCurrentLangaugeSettingIndx;
+    m_nCurrentLangaugeSettingIndx = FirstEnabledVoiceIndex(m_nCurrentLangaugeSettingIndx, g_vLangVoiceSettings);
+    if(settings.nLookAheadUtterances)
+        m_lookAheadUtterances = *settings.nLookAheadUtterances;
+    if(settings.nConversionWorkers) {
+        m_nConversionWorkers = *settings.nConversionWorkers;
+        m_bookConverter->setWorkerCount(m_nConversionWorkers);
+    }
+    if(settings.nSpeechThreadNice)
+        m_nSpeechThreadNice = *settings.nSpeechThreadNice;
+    if(settings.nCameraThreadNice)
+        m_nCameraThreadNice = *settings.nCameraThreadNice;
+    setThreadRoles();
+    if(settings.nLeadingPauseMs)
+        m_nLeadingPauseMs = *settings.nLeadingPauseMs;
+    if(settings.nWordPauseMs)
+        m_nWordPauseMs = *settings.nWordPauseMs;
+    if(settings.nClausePauseMs)
+        m_nClausePauseMs = *settings.nClausePauseMs;
+    if(settings.nSentencePauseMs)
+        m_nSentencePauseMs = *settings.nSentencePauseMs;
+    for(const auto &slot : m_ttsEngines) {
+        if(slot.engine)
+            setSpeechPauses(slot.engine);
+    }
+    if(settings.bDirectAudioOutput)
+        m_bDirectAudioOutput = *settings.bDirectAudioOutput;
+    if(settings.sAlsaDevice)
+        m_sAlsaDevice = QString::fromStdString(*settings.sAlsaDevice);
+    if(settings.nAlsaPeriodUs)
+        m_nAlsaPeriodUs = *settings.nAlsaPeriodUs;
+    if(settings.nAlsaBufferUs)
+        m_nAlsaBufferUs = *settings.nAlsaBufferUs;
+    if(settings.nAlsaThreadPriority)
+        m_nAlsaThreadPriority = *settings.nAlsaThreadPriority;
+    if(settings.nWordNotifyIntervalMs)
+        setWordNotifyInterval(*settings.nWordNotifyIntervalMs);
+    if(settings.nSpeechStartBoundary)
+        setSpeechStartBoundary(static_cast<TextPage::Boundary>(*settings.nSpeechStartBoundary));
+}
+
+// Camera settings wait for the hardware init, which they would race otherwise
+void MainController::applyCameraSettings(const Settings &settings) {
+    if(settings.bUseCameraFlash)
+        m_hwhandler->setUseCameraFlash(*settings.bUseCameraFlash);
+    if(settings.fExposureStep)
+        m_hwhandler->setExposureStep(*settings.fExposureStep);
 }
 
 void MainController::writeSettings() const {
@@ -1647,8 +2037,61 @@ void MainController::writeSettings() const {
     //file << "navigationMode" << (int)m_navigationMode;
     file << "bUseCameraFlash" << m_hwhandler->getUseCameraFlash();
     file << "fExposureStep" << m_hwhandler->getExposureStep();
+    file << "nSpeechStartBoundary" << (int)m_speechStartBoundary;
+    file << "nLookAheadUtterances" << m_lookAheadUtterances;
+    file << "nWordNotifyIntervalMs" << m_wordNotifyIntervalMs;
+    file << "nConversionWorkers" << m_nConversionWorkers;
+    file << "nSpeechThreadNice" << m_nSpeechThreadNice;
+    file << "nCameraThreadNice" << m_nCameraThreadNice;
+    file << "nLeadingPauseMs" << m_nLeadingPauseMs;
+    file << "nWordPauseMs" << m_nWordPauseMs;
+    file << "nClausePauseMs" << m_nClausePauseMs;
+    file << "nSentencePauseMs" << m_nSentencePauseMs;
+    file << "bDirectAudioOutput" << (int)m_bDirectAudioOutput;
+    file << "sAlsaDevice" << m_sAlsaDevice.toStdString();
+    file << "nAlsaPeriodUs" << m_nAlsaPeriodUs;
+    file << "nAlsaBufferUs" << m_nAlsaBufferUs;
+    file << "nAlsaThreadPriority" << m_nAlsaThreadPriority;
  }
 
+// Threads of the speech get ahead of the camera loop, the threads apply their roles when they start
+void MainController::setThreadRoles() const
+{
+    VPLATFORM_THREAD_PARAMS params {};
+    params.iPolicy = SCHED_OTHER;
+    params.iNice = m_nSpeechThreadNice;
+    vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_ENGINE, &params);
+    vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_SYNTHESIS, &params);
+    params.iNice = m_nCameraThreadNice;
+    vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_BACKGROUND, &params);
+}
+
+void MainController::setSpeechStartBoundary(TextPage::Boundary boundary)
+{
+    if (boundary < TextPage::Boundary::Sentence || boundary > TextPage::Boundary::Line)
+        return;
+    m_speechStartBoundary = boundary;
+}
+
+TextPage::Boundary MainController::speechStartBoundary() const
+{
+    return m_speechStartBoundary;
+}
+
+const MainController::FirstWordStats &MainController::firstWordStats(TextPage::Boundary boundary) const
+{
+    return m_firstWordStats[static_cast<int>(boundary)];
+}
+
+void MainController::setWordNotifyInterval(int ms)
+{
+    if (ms <= 0)
+        return;
+    m_wordNotifyIntervalMs = ms;
+    if (m_pTtsAudioLayer)
+        m_pTtsAudioLayer->setNotifyPeriod(ms);
+}
+
 
 void MainController::toggleNavigationMode(bool bForward) {
     if (m_state == State::SpeakingPage)
@@ -1730,7 +2173,7 @@ bool MainController::ChangeCameraExposureStep(int delta) {
 }
 
 void MainController::convertTextToAudio(const QString & sText, const QString & sAudioFileName) {
-    m_ttsEnginesList[m_currentTTSIndex]->convertTextToAudio(sText, sAudioFileName);
+    ttsEngine(m_currentTTSIndex)->convertTextToAudio(sText, sAudioFileName);
 }
 
 string RemoveFileNameExtension(const string & sFileName) {
@@ -1747,13 +2190,17 @@ string GetFileNameFromPath(const string & sPath) {
     return RemoveFileNameExtension(sPath.substr(pos + 1));
 }
 
-void MainController::onSavingAudioDone(QString sFileName) {
-    int nImageConverted = m_nImagesToConvert - m_vScannedImagesQue.size() + 1;
-    system("sync");
-    if(m_vScannedImagesQue.size() == 1)
-        sayTranslationTag(USB_CONVERT_COMPLETE);
-    else
-        sayText(translateTag(USB_KEY_CONV_PAGE) + " " + QString::number(nImageConverted));
+void MainController::onPageConverted(const QString &sFileName, bool bOk) {
+    if(!bOk)
+        qWarning() << "Page audio is not saved" << sFileName;
+    if(m_bookConverter->finishedPages() < m_nImagesToConvert) {
+        saySpeech(translateTag(USB_KEY_CONV_PAGE) + " " + QString::number(m_bookConverter->finishedPages()),
+                  SpeechPriority::Background);
+        return;
+    }
+    qDebug() << m_bookConverter->report();
+    // Replaces the progress that isn't said yet
+    saySpeech(translateTag(USB_CONVERT_COMPLETE), SpeechPriority::Background);
 }
 
 bool MainController::setSpeakerSetting(int nSetting) {
@@ -1791,9 +2238,13 @@ void MainController::onUsbKeyInsert(bool bInserted) {
     if(bInserted && IsUpdateDrive())
         return;
     m_bUsbKeyInserted = bInserted;
+    if(!bInserted) {
+        m_bookConverter->stop();
+        m_vScannedImagesQue.clear();
+    }
     int nIndx = 0;
     pause();
-    sayText(translateTag(bInserted ? USB_KEY_INSERTED : USB_KEY_REMOVED), true);
+    saySpeech(translateTag(bInserted ? USB_KEY_INSERTED : USB_KEY_REMOVED), SpeechPriority::Alert, true);
     m_sCurrentBookDir.clear();
     if(bInserted) {
         if(IsUpdateDrive())
@@ -1809,13 +2260,11 @@ void MainController::onUsbKeyInsert(bool bInserted) {
 }
 
 void MainController::onUsbKpConnect(bool bConnected) {
-    if(m_beepSound)
-        m_beepSound->play();
+    playEarcon(Earcon::Beep);
 }
 
 void MainController::onBtKpRegistered() {
-    if(m_beepSound)
-        m_beepSound->play();
+    playEarcon(Earcon::Beep);
 }
 
 static bool GetBookPages(const string & sDir, vector<string> & vPages) {
@@ -1865,18 +2314,8 @@ bool MainController::saveScannedImage(const cv::Mat & img) {
     return true;
 }
 
-bool MainController::isPlayingSound() {
-    if(m_shutterSound && !m_shutterSound->isFinished())
-        return true;
-    if(m_beepSound && !m_beepSound->isFinished())
-        return true;
-    if(m_shutterSound && !m_shutterSound->isFinished())
-        return true;
-    if(m_armOpenSound && !m_armOpenSound->isFinished())
-        return true;
-    if(m_armClosedSound && !m_armClosedSound->isFinished())
-        return true;
-    return false;
+bool MainController::isAudioBusy() {
+    return m_isAudioBusy;
 }
 
 bool MainController::ProcessScannedImage(const string & path) {
@@ -1889,55 +2328,47 @@ bool MainController::ProcessScannedImage(const string & path) {
     return true;
 }
 
+// Only the pages without text are queued, one page is OCRed at a time
 bool MainController::ProcessNextScannedImg() {
     if(!ocr().isIdle())
         return false;
-    bool bTextExists = false, bAudioExists = false;
     while(!m_vScannedImagesQue.empty()) {
-        bTextExists = MatchingTextFileExists(m_vScannedImagesQue.front());
-        bAudioExists = MatchingAudioFileExists(m_vScannedImagesQue.front());
-        if(!bTextExists || !bAudioExists)
-            break;
+        m_sCurrentImgPath = m_vScannedImagesQue.front();
+        if(ProcessScannedImage(m_sCurrentImgPath))
+            return true;
+        // The converter reports the page without text as failed
+        ConvertTextToAudio(m_sCurrentImgPath);
         m_vScannedImagesQue.pop_front();
     }
-    if(m_vScannedImagesQue.empty())
-        return false;
-    m_sCurrentImgPath = m_vScannedImagesQue.front();
-    if(!bTextExists)
-        return ProcessScannedImage(m_sCurrentImgPath);
-    if(!bAudioExists)
-        return ConvertTextToAudio(m_sCurrentImgPath);
     return false;
 }
 
 bool MainController::StartProcessScannedImages() {
     m_vScannedImagesQue.clear();
     vector<string> vBooks;
+    vector<string> vTextPages;
     FindZyrloBooks(vBooks);
     for(auto & i : vBooks) {
         vector<string> vPages;
         GetBookPages(string(ZYRLO_BOOKS_PATH) + '/' + i + '/' + BOOK_IMG_DIR, vPages);
         for(auto & j : vPages) {
             string path(string(ZYRLO_BOOKS_PATH) + '/' + i + '/' + BOOK_IMG_DIR + '/' + j);
-            if(!MatchingTextFileExists(path) || !MatchingAudioFileExists(path) )
+            if(!MatchingTextFileExists(path))
                 m_vScannedImagesQue.push_back(path);
+            else if(!MatchingAudioFileExists(path))
+                vTextPages.push_back(path);
         }
     }
-    m_nImagesToConvert = m_vScannedImagesQue.size();
+    m_nImagesToConvert = m_vScannedImagesQue.size() + vTextPages.size();
+    m_bookConverter->start(m_nImagesToConvert);
+    for(auto & path : vTextPages)
+        ConvertTextToAudio(path);
     return true;
 }
 
 bool MainController::ConvertTextToAudio(const string & sPath) {
-    QFile file(changeSubdirInPath(sPath, BOOK_IMG_DIR, BOOK_TXT_DIR, "txt").c_str());
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return false;
-    QTextStream stream(&file);
-    QString sText;
-    sText.append(stream.readAll());
-    file.close();
-    if(sText.isEmpty())
-        return false;
-    convertTextToAudio(sText, changeSubdirInPath(sPath, BOOK_IMG_DIR, BOOK_AUDIO_DIR, "mp3").c_str());
+    m_bookConverter->addPage(changeSubdirInPath(sPath, BOOK_IMG_DIR, BOOK_TXT_DIR, "txt").c_str(),
+                             changeSubdirInPath(sPath, BOOK_IMG_DIR, BOOK_AUDIO_DIR, "mp3").c_str());
     return true;
 }
 
@@ -1962,6 +2393,15 @@ void MainController::SetLocalLightFreqTest(bool bOn) {
         m_hwhandler->SetLocalLightFreqTest(bOn);
 }
 
+bool MainController::isReady() const {
+    return m_startup->isFinished("ready");
+}
+
+QString MainController::getPageText() const {
+    const auto page = ocr().textPage();
+    return page ? page->text() : QString();
+}
+
 int MainController::getCurrentExposure() const {
     if(!m_hwhandler)
         return -1;
@@ -2009,8 +2449,8 @@ bool MainController::tryProcessScannedImages () {
     if(m_bUsbKeyInserted) {
         if(StartProcessScannedImages())
             sayText(QString::number(m_nImagesToConvert) + " " + translateTag(USB_FILES_TO_CONVERT));
-        else if(m_beepSound)
-            m_beepSound->play();
+        else
+            playEarcon(Earcon::Beep);
         return true;
     }
     return false;
@@ -0,0 +1,156 @@
+#include "mp3encoder.h"
+#include "pcmringbuffer.h"
+
+#include <QDebug>
+#include <QThread>
+#include <QtConcurrent>
+#include <lame/lame.h>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+static constexpr int PCM_CHUNK_SIZE = 8192;
+static constexpr int MP3_CHUNK_SIZE = PCM_CHUNK_SIZE / 2 * 5 / 4 + 7200;   // Worst case by LAME docs
+static constexpr int EMPTY_WAIT_MS = 5;     // Encoder sleep when there is no PCM
+
+Mp3Encoder::Mp3Encoder(int sampleRate, qint64 bufferSize)
+    : m_sampleRate(sampleRate)
+    , m_buffer(new PcmRingBuffer(bufferSize))
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+Mp3Encoder::~Mp3Encoder()
+{
+    abort();
+    delete m_buffer;
+}
+
+bool Mp3Encoder::start(const char *fileName)
+{
+    abort();
+
+    m_fp = fopen(fileName, "wb");
+    if (!m_fp)
+        return false;
+    m_fileName = fileName;
+
+    m_lame = lame_init();
+    lame_set_in_samplerate(m_lame, m_sampleRate);
+    lame_set_VBR(m_lame, vbr_default);
+    lame_set_mode(m_lame, MONO);
+    lame_set_num_channels(m_lame, 1);
+    if (lame_init_params(m_lame) < 0) {
+        close();
+        std::remove(m_fileName.c_str());
+        return false;
+    }
+
+    m_buffer->clearStream();
+    m_isAborted = false;
+    m_isFailed = false;
+    m_stats = Stats();
+    m_timer.start();
+    m_future = QtConcurrent::run(&m_pool, [this]() { encode(); });
+    return true;
+}
+
+void Mp3Encoder::push(const char *pcm, qint64 size)
+{
+    if (m_fp)
+        m_buffer->push(pcm, size);
+}
+
+bool Mp3Encoder::finish()
+{
+    if (!m_fp)
+        return false;
+
+    m_buffer->finish();
+    m_future.waitForFinished();
+
+    bool isOk = !m_isFailed;
+    if (isOk) {
+        unsigned char mp3[MP3_CHUNK_SIZE];
+        const int size = lame_encode_flush(m_lame, mp3, MP3_CHUNK_SIZE);
+        isOk = size >= 0 && fwrite(mp3, 1, size, m_fp) == static_cast<size_t>(size);
+        m_stats.mp3Bytes += std::max(size, 0);
+    }
+    // Only this file is synced, the card may be removed right after the conversion
+    isOk = fflush(m_fp) == 0 && fsync(fileno(m_fp)) == 0 && isOk;
+    m_stats.peakBufferFill = m_buffer->peakFill();
+    m_stats.totalMs = m_timer.elapsed();
+    close();
+
+    const double audioSec = m_stats.pcmBytes / 2.0 / m_sampleRate;
+    qDebug() << "MP3 encoded" << audioSec << "s of audio to" << m_stats.mp3Bytes << "bytes in" << m_stats.encodeMs
+             << "ms of" << m_stats.totalMs << "ms, peak buffer fill" << m_stats.peakBufferFill;
+    return isOk;
+}
+
+void Mp3Encoder::abort()
+{
+    if (!m_fp)
+        return;
+
+    m_isAborted = true;
+    m_buffer->abort();
+    m_future.waitForFinished();
+    close();
+    std::remove(m_fileName.c_str());
+}
+
+bool Mp3Encoder::isActive() const
+{
+    return m_fp != nullptr;
+}
+
+Mp3Encoder::Stats Mp3Encoder::stats() const
+{
+    return m_stats;
+}
+
+// Runs in the encoder thread till the buffer is finished and empty
+void Mp3Encoder::encode()
+{
+    char pcm[PCM_CHUNK_SIZE];
+    unsigned char mp3[MP3_CHUNK_SIZE];
+    QElapsedTimer timer;
+
+    while (!m_isAborted) {
+        const qint64 size = m_buffer->read(pcm, PCM_CHUNK_SIZE);
+        if (size <= 0) {
+            if (m_buffer->isFinished() && m_buffer->fill() == 0)
+                return;
+            QThread::msleep(EMPTY_WAIT_MS);
+            continue;
+        }
+
+        timer.start();
+        // Samples are pushed whole, so the buffer always holds even number of bytes
+        const int written = lame_encode_buffer(m_lame, reinterpret_cast<const short *>(pcm), nullptr,
+                                               static_cast<int>(size / 2), mp3, MP3_CHUNK_SIZE);
+        if (written < 0 || fwrite(mp3, 1, written, m_fp) != static_cast<size_t>(written)) {
+            qWarning() << "Can't write MP3 to" << m_fileName.c_str();
+            m_isFailed = true;
+            // Release the producer, the rest of PCM is dropped
+            m_buffer->abort();
+            return;
+        }
+        m_stats.pcmBytes += size;
+        m_stats.mp3Bytes += written;
+        m_stats.encodeMs += timer.elapsed();
+    }
+}
+
+void Mp3Encoder::close()
+{
+    if (m_lame) {
+        lame_close(m_lame);
+        m_lame = nullptr;
+    }
+    if (m_fp) {
+        fclose(m_fp);
+        m_fp = nullptr;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+class PcmRingBuffer;
+struct lame_global_struct;
+
+/*
+ * Mp3Encoder encodes 16-bit mono PCM to the MP3 file in its own thread while
+ * the text is synthesized. PCM waits for the encoder in a small ring buffer, so
+ * the memory doesn't depend on the text length, and the MP3 frames are written
+ * to the file as soon as they are encoded.
+ *
+ * start(), push(), finish() and abort() are called by one thread at a time.
+ *
+ */
+class Mp3Encoder
+{
+public:
+    static constexpr qint64 DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    struct Stats {
+        qint64  pcmBytes {0};
+        qint64  mp3Bytes {0};
+        qint64  encodeMs {0};       // Encoder thread busy time, without waits for PCM
+        qint64  totalMs {0};        // From start() to finish()
+        qint64  peakBufferFill {0};
+    };
+
+    explicit Mp3Encoder(int sampleRate, qint64 bufferSize = DEFAULT_BUFFER_SIZE);
+    // Aborts unfinished encoding
+    ~Mp3Encoder();
+
+    Mp3Encoder(const Mp3Encoder &) = delete;
+    Mp3Encoder &operator=(const Mp3Encoder &) = delete;
+
+    // Aborts unfinished encoding and starts encoding to the new file
+    bool start(const char *fileName);
+    // Blocks while the buffer is full
+    void push(const char *pcm, qint64 size);
+    // Waits till the pushed PCM is encoded, then flushes and syncs the file
+    bool finish();
+    // Drops the pushed PCM and removes the unfinished file
+    void abort();
+
+    bool isActive() const;
+    // Stats of the last finished encoding
+    Stats stats() const;
+
+private:
+    void encode();
+    void close();
+
+private:
+    const int               m_sampleRate;
+    PcmRingBuffer          *m_buffer {nullptr};
+    lame_global_struct     *m_lame {nullptr};
+    FILE                   *m_fp {nullptr};
+    std::string             m_fileName;
+    // Own thread, so the encoder doesn't wait for the busy global pool while the synthesis waits for it
+    QThreadPool             m_pool;
+    QFuture<void>           m_future;
+    QElapsedTimer           m_timer;
+    std::atomic<bool>       m_isAborted {false};
+    std::atomic<bool>       m_isFailed {false};
+    // Written by the encoder thread, read after it's finished
+    Stats                   m_stats;
+};
@@ -14,6 +14,7 @@
 #include <ZyrloOcr.h>
 #include "textpage.h"
 #include <unistd.h>
+#include <mutex>
 
 constexpr auto DATA_DIR = "/opt/zyrlo/Distrib";
 constexpr int STATUS_MAX_SIZE = 64;
@@ -22,17 +23,12 @@ using namespace std;
 
 OcrHandler *OcrHandler::ocr = NULL;
 
+static std::once_flag engineInitFlag;
+
 OcrHandler::OcrHandler()
 {
     //qDebug() << "OcrHandler constructor";
-    const auto retCode = zyrlo_proc_init(DATA_DIR, m_languageCode);
-    if (retCode != 0) {
-        qWarning() << "Error in zyrlo_proc_init()" << retCode;
-    }
-
-    while (!isIdle()) {
-        QThread::msleep(1);
-    }
+    initEngine();
 
     m_timer.setInterval(10);
     connect(&m_timer, &QTimer::timeout, this, &OcrHandler::checkProcess);
@@ -66,6 +62,7 @@ bool OcrHandler::startProcess(const cv::Mat &image)
     }
     //imwrite(string(getenv("HOME")) + "/OcrImg.bmp", image);
     createTextPage();
+    emit pageStarted();
     const auto retCode = zyrlo_proc_start_with_bayer(image);
     if (retCode == 0) {
         m_timer.start();
@@ -130,7 +127,21 @@ void OcrHandler::checkProcess()
     }
 }
 
-QString OcrHandler::getStatus() const
+void OcrHandler::initEngine()
+{
+    std::call_once(engineInitFlag, []() {
+        const auto retCode = zyrlo_proc_init(DATA_DIR, DEFAULT_LANGUAGE_CODE);
+        if (retCode != 0) {
+            qWarning() << "Error in zyrlo_proc_init()" << retCode;
+        }
+
+        while (getStatus() != QStringLiteral("Idle")) {
+            QThread::msleep(1);
+        }
+    });
+}
+
+QString OcrHandler::getStatus()
 {
     char buffer[STATUS_MAX_SIZE];
     zyrlo_proc_get_status(buffer);
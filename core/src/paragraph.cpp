@@ -6,13 +6,13 @@
  ****************************************************************************/
 
 #include "paragraph.h"
-
-#include <QRegularExpression>
+#include "textscanner.h"
 
 using namespace std;
 
-Paragraph::Paragraph(int id)
+Paragraph::Paragraph(int id, const TextStorage &storage)
     : m_id(id)
+    , m_storage(storage)
 {
 
 }
@@ -29,17 +29,12 @@ void Paragraph::setId(int id)
 
 int Paragraph::paragraphPosition() const
 {
-    return m_paragraphPosition;
-}
-
-void Paragraph::setParagraphPosition(int pos)
-{
-    m_paragraphPosition = pos;
+    return m_offset;
 }
 
 int Paragraph::length() const
 {
-    return text().length();
+    return m_length;
 }
 
 int Paragraph::firstLineNum() const
@@ -54,7 +49,7 @@ void Paragraph::setFirstLineNum(int firstLine)
 
 int Paragraph::numLines() const
 {
-    return m_lines.size();
+    return m_addedNumLines;
 }
 
 void Paragraph::addLine(const QString &line, const QString &lang)
@@ -62,23 +57,51 @@ void Paragraph::addLine(const QString &line, const QString &lang)
     if(m_langTagPos.empty() || lang.compare(prev(m_langTagPos.end())->second) != 0)
         m_langTagPos[length()] = lang;
     auto newLine = line.simplified();
-    if (!newLine.isEmpty() && newLine.back() == '-') {
+    const bool isDashed = !newLine.isEmpty() && newLine.back() == '-';
+    if (isDashed) {
         // Remove last dash '-' as it will be connected to the next line
         newLine.chop(1);
-    } else {
-        // Normally add space between lines
-        newLine.append(' ');
     }
 
-    m_lines.append(newLine);
-    parseChars();
-    parseWords();
-    parseSenteces();
+    ++m_addedNumLines;
+    if (!newLine.isEmpty()) {
+        if (!m_storage)
+            m_storage = TextStorage::create();
+
+        if (m_length == 0) {
+            // The first text of the paragraph, separate it from the previous one
+            if (!m_storage->isEmpty())
+                m_storage->append('\n');
+            m_offset = m_storage->size();
+        } else if (m_isSpacePending) {
+            m_storage->append(' ');
+            ++m_length;
+        }
+
+        // Only the last paragraph of the page can grow
+        Q_ASSERT(m_offset + m_length == m_storage->size());
+        m_storage->append(newLine);
+        m_length += newLine.size();
+    }
+    // Normally add space between lines
+    m_isSpacePending = !isDashed;
+
+    const auto parText = textView();
+    parseWords(parText);
+    parseSenteces(parText);
 }
 
 QString Paragraph::text() const
 {
-    return m_lines.join("").trimmed();
+    return textView().toString();
+}
+
+QStringView Paragraph::textView() const
+{
+    if (!m_storage || m_length == 0)
+        return QStringView();
+
+    return QStringView(m_storage->constData() + m_offset, m_length);
 }
 
 bool Paragraph::isComplete() const
@@ -93,27 +116,40 @@ void Paragraph::setCompleted()
 
 bool Paragraph::hasText() const
 {
-    return !m_lines.isEmpty();
+    return m_addedNumLines > 0;
+}
+
+bool Paragraph::isLastWordComplete() const
+{
+    return m_isSpacePending;
 }
 
 TextPosition Paragraph::prevCharPosition(int pos) const
 {
-    return prevPosition(m_chars, pos);
+    const int index = charIndex(pos);
+    if (index <= 0)
+        return TextPosition{};
+
+    return charPosition(index - 1);
 }
 
 TextPosition Paragraph::nextCharPosition(int pos) const
 {
-    return nextPosition(m_chars, pos);
+    const int index = charIndex(pos);
+    if (index < 0 || index == m_length - 1)
+        return TextPosition{};
+
+    return charPosition(index + 1);
 }
 
 TextPosition Paragraph::firstCharPosition() const
 {
-    return firstPosition(m_chars);
+    return charPosition(0);
 }
 
 TextPosition Paragraph::lastCharPosition() const
 {
-    return lastPosition(m_chars);
+    return charPosition(m_length - 1);
 }
 
 TextPosition Paragraph::prevWordPosition(int pos) const
@@ -166,110 +202,118 @@ TextPosition Paragraph::lastSentencePosition() const
     return lastPosition(m_sentences);
 }
 
-void Paragraph::parseChars()
+void Paragraph::parseWords(QStringView text)
 {
-    const static QRegularExpression re(R"(.|\n)");
-    m_chars = parseToPositions(text(), re);
+    const int from = truncateLastPosition(m_words);
+    TextScanner::scanWords(text, from, m_words);
 }
 
-void Paragraph::parseWords()
+void Paragraph::parseSenteces(QStringView text)
 {
-    const static QRegularExpression re(R"([\w\d']+)");
-    m_words = parseToPositions(text(), re);
-}
+    const int from = truncateLastPosition(m_sentences);
 
-void Paragraph::parseSenteces()
-{
-    const static QRegularExpression re(R"([^\.!?]{3,}[\.!?])");
-    m_sentences = parseToPositions(text(), re);
+    // Sentences don't cross language boundaries, as every language has its own terminators
+    for (auto it = m_langTagPos.cbegin(); it != m_langTagPos.cend(); ++it) {
+        const auto nextIt = next(it);
+        const int langEnd = nextIt == m_langTagPos.cend() ? text.size() : nextIt->first;
+        if (langEnd <= from)
+            continue;
+
+        TextScanner::scanSentences(text.left(langEnd), max(from, it->first),
+                                   TextScanner::sentenceEndMask(it->second), m_sentences);
+    }
 }
 
-Positions Paragraph::parseToPositions(const QString &text, const QRegularExpression &re)
+// Only the last word/sentence can be continued by a new line, so it is removed to
+// be scanned again. Returns the position to start scanning from
+int Paragraph::truncateLastPosition(PositionTable &positions)
 {
-    Positions positions;
+    if (positions.isEmpty())
+        return 0;
 
-    int nextPos = 0;
-
-    while (true) {
-        auto match = re.match(text, nextPos);
-        if (!match.hasMatch()) {
-            break;
-        }
-
-        positions.push_back(TextPosition(match.capturedStart(),
-                                         match.capturedLength(),
-                                         paragraphPosition()));
+    const int last = positions.size() - 1;
+    const int from = positions.start(last);
+    positions.truncate(last);
+    return from;
+}
 
-        nextPos = match.capturedEnd();
-    }
-    if(nextPos < text.length() && QRegularExpression("[^-\\s]").match(text, nextPos).hasMatch())
-        positions.push_back(TextPosition(nextPos,
-                                         text.length() - nextPos,
-                                         paragraphPosition()));
-    return positions;
+TextPosition Paragraph::positionAt(const PositionTable &positions, int index) const
+{
+    return TextPosition(positions.start(index), positions.length(index), paragraphPosition());
 }
 
-TextPosition Paragraph::prevPosition(const Positions &positions, int pos) const
+TextPosition Paragraph::prevPosition(const PositionTable &positions, int pos) const
 {
-    int index = indexByTextPosition(positions, pos);
+    int index = positions.indexOf(pos);
     if (index <= 0)
         return TextPosition{};
 
-    return positions[index - 1];
+    return positionAt(positions, index - 1);
 }
 
-TextPosition Paragraph::nextPosition(const Positions &positions, int pos) const
+TextPosition Paragraph::nextPosition(const PositionTable &positions, int pos) const
 {
-    int index = indexByTextPosition(positions, pos);
+    int index = positions.indexOf(pos);
     if (index < 0 || index == positions.size() - 1)
         return TextPosition{};
 
-    return positions[index + 1];
+    return positionAt(positions, index + 1);
 }
 
-TextPosition Paragraph::currentPosition(const Positions &positions, int pos) const
+TextPosition Paragraph::currentPosition(const PositionTable &positions, int pos) const
 {
-    int index = indexByTextPosition(positions, pos);
+    int index = positions.indexOf(pos);
     if (index < 0)
         return TextPosition{};
 
-    return positions[index];
+    return positionAt(positions, index);
 }
 
-TextPosition Paragraph::firstPosition(const Positions &positions) const
+TextPosition Paragraph::firstPosition(const PositionTable &positions) const
 {
-    if (positions.empty())
+    if (positions.isEmpty())
         return TextPosition{};
 
-    return positions.front();
+    return positionAt(positions, 0);
 }
 
-TextPosition Paragraph::lastPosition(const Positions &positions) const
+TextPosition Paragraph::lastPosition(const PositionTable &positions) const
 {
-    if (positions.empty())
+    if (positions.isEmpty())
         return TextPosition{};
 
-    return positions.back();
+    return positionAt(positions, positions.size() - 1);
 }
 
-// Returns index in the given positions array using the current position. If the
-// current position is less than the first index's position, then it returns -1
-int Paragraph::indexByTextPosition(const Positions &positions, int currentPosition) const
+TextPosition Paragraph::charPosition(int index) const
 {
-    int currentIndex = 0;
-    for (; currentIndex < positions.size(); ++currentIndex) {
-        if (positions[currentIndex].parPos() > currentPosition) {
-            break;
-        }
-    }
+    if (index < 0 || index >= m_length)
+        return TextPosition{};
 
-    return --currentIndex;
+    return TextPosition(index, 1, paragraphPosition());
+}
+
+// Returns index of the character at the current position. Positions after the
+// end of the paragraph map to the last character, and if the current position
+// is before the first character, then it returns -1
+int Paragraph::charIndex(int pos) const
+{
+    if (pos < 0 || m_length == 0)
+        return -1;
+
+    return std::min(pos, m_length - 1);
 }
 
 pair <QString, int> Paragraph::lang(int position) const
 {
-    auto i = m_langTagPos.lower_bound(position);
-    auto j = next(i);
+    if (m_langTagPos.empty())
+        return pair <QString, int>(QString(), -1);
+
+    // Language span containing the position is the last one started at or before it
+    auto j = m_langTagPos.upper_bound(position);
+    auto i = j == m_langTagPos.begin() ? j : prev(j);
+    if (i == j)
+        ++j;
     int  nextPos = (j == m_langTagPos.end()) ? -1 : j->first;
     return pair <QString, int>(i->second, nextPos);
 }
@@ -0,0 +1,240 @@
+#include "pcmcache.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <cstring>
+
+static const char FILE_MAGIC[4] = {'Z', 'P', 'C', 'M'};
+static constexpr qint32 FILE_VERSION = 1;
+
+template<typename T>
+static bool writeValue(FILE *fp, T value)
+{
+    return fwrite(&value, sizeof(value), 1, fp) == 1;
+}
+
+template<typename T>
+static bool readValue(FILE *fp, T &value)
+{
+    return fread(&value, sizeof(value), 1, fp) == 1;
+}
+
+static bool writeBytes(FILE *fp, const QByteArray &bytes)
+{
+    return writeValue<qint32>(fp, bytes.size())
+            && static_cast<int>(fwrite(bytes.constData(), 1, bytes.size(), fp)) == bytes.size();
+}
+
+static bool readBytes(FILE *fp, QByteArray &bytes, qint32 maxSize)
+{
+    qint32 size = 0;
+    if (!readValue(fp, size) || size < 0 || size > maxSize)
+        return false;
+    bytes = QByteArray(size, '\0');
+    return static_cast<int>(fread(bytes.data(), 1, size, fp)) == size;
+}
+
+// Cached audio ends with its last word, so the text has to continue with another one. Bytes of
+// UTF-8 sequences are letters
+static bool isWordEnd(const QByteArray &text, int pos)
+{
+    if (pos >= text.size())
+        return true;
+    const auto c = static_cast<unsigned char>(text[pos]);
+    return c < 0x80 && (std::isspace(c) || std::ispunct(c));
+}
+
+PcmCache::PcmCache(qint64 maxBytes, int bytesPerSample)
+    : m_maxBytes(maxBytes)
+    , m_bytesPerSample(bytesPerSample)
+{
+}
+
+void PcmCache::insert(const QByteArray &text, const QByteArray &pcm, const QVector<Mark> &marks)
+{
+    if (text.isEmpty() || pcm.size() > m_maxBytes)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.push_front({text, pcm, marks});
+    m_size += pcm.size();
+    evict();
+}
+
+bool PcmCache::find(const QByteArray &text, Hit &hit)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto bestEntry = m_entries.end();
+    int bestOffset = 0;
+    int bestLength = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        // The cached audio can start at the text beginning or at any of its words
+        for (int i = -1; i < it->marks.size(); ++i) {
+            const int offset = i < 0 ? 0 : it->marks[i].srcPos;
+            const int tailLength = it->text.size() - offset;
+            if (tailLength > bestLength && tailLength <= text.size() && isWordEnd(text, tailLength)
+                    && std::memcmp(text.constData(), it->text.constData() + offset, tailLength) == 0) {
+                bestEntry = it;
+                bestOffset = offset;
+                bestLength = tailLength;
+            }
+        }
+    }
+
+    if (bestEntry == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    qint64 startSample = 0;
+    hit.marks.clear();
+    for (const auto &mark : bestEntry->marks) {
+        if (mark.srcPos < bestOffset)
+            continue;
+        if (hit.marks.isEmpty() && bestOffset > 0)
+            startSample = mark.destPos;
+        hit.marks.append({mark.srcPos - bestOffset, mark.srcLength, mark.destPos - startSample});
+    }
+    hit.pcm = bestEntry->pcm.mid(static_cast<int>(startSample * m_bytesPerSample));
+    hit.textLength = bestLength;
+
+    m_entries.splice(m_entries.begin(), m_entries, bestEntry);
+    ++m_hits;
+    return true;
+}
+
+bool PcmCache::findText(const QByteArray &text, Hit &hit)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto entry = std::find_if(m_entries.begin(), m_entries.end(), [&text](const Entry &entry) {
+        return entry.text == text;
+    });
+    if (entry == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    hit.pcm = entry->pcm;
+    hit.marks = entry->marks;
+    hit.textLength = entry->text.size();
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+    ++m_hits;
+    return true;
+}
+
+bool PcmCache::contains(const QByteArray &text) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (const auto &entry : m_entries) {
+        if (entry.text == text)
+            return true;
+    }
+    return false;
+}
+
+void PcmCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_size = 0;
+}
+
+bool PcmCache::save(const QByteArray &text, const char *fileName) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto entry = std::find_if(m_entries.begin(), m_entries.end(), [&text](const Entry &entry) {
+        return entry.text == text;
+    });
+    if (entry == m_entries.end())
+        return false;
+
+    // Written to the temporary file first, so a power loss doesn't leave the truncated file
+    const std::string tmpFileName = std::string(fileName) + ".tmp";
+    FILE *fp = fopen(tmpFileName.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool isOk = fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, fp) == 1
+            && writeValue(fp, FILE_VERSION)
+            && writeBytes(fp, entry->text)
+            && writeValue<qint32>(fp, entry->marks.size());
+    for (const auto &mark : entry->marks) {
+        isOk = isOk && writeValue<qint32>(fp, mark.srcPos) && writeValue<qint32>(fp, mark.srcLength)
+                && writeValue<qint64>(fp, mark.destPos);
+    }
+    isOk = isOk && writeBytes(fp, entry->pcm);
+    isOk = fclose(fp) == 0 && isOk;
+
+    if (!isOk || std::rename(tmpFileName.c_str(), fileName) != 0) {
+        std::remove(tmpFileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PcmCache::load(const char *fileName)
+{
+    FILE *fp = fopen(fileName, "rb");
+    if (!fp)
+        return false;
+
+    char magic[sizeof(FILE_MAGIC)];
+    qint32 version = 0;
+    QByteArray text;
+    qint32 numMarks = 0;
+    QVector<Mark> marks;
+    QByteArray pcm;
+    bool isOk = fread(magic, sizeof(magic), 1, fp) == 1
+            && std::memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0
+            && readValue(fp, version) && version == FILE_VERSION
+            && readBytes(fp, text, INT32_MAX)
+            && readValue(fp, numMarks) && numMarks >= 0 && numMarks <= text.size();
+    for (qint32 i = 0; isOk && i < numMarks; ++i) {
+        Mark mark {};
+        qint32 srcPos = 0;
+        qint32 srcLength = 0;
+        isOk = readValue(fp, srcPos) && readValue(fp, srcLength) && readValue(fp, mark.destPos);
+        mark.srcPos = srcPos;
+        mark.srcLength = srcLength;
+        marks.append(mark);
+    }
+    isOk = isOk && readBytes(fp, pcm, static_cast<qint32>(std::min<qint64>(m_maxBytes, INT32_MAX)));
+    fclose(fp);
+
+    if (!isOk)
+        return false;
+
+    insert(text, pcm, marks);
+    return true;
+}
+
+qint64 PcmCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+int PcmCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+int PcmCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+void PcmCache::evict()
+{
+    while (m_size > m_maxBytes && !m_entries.empty()) {
+        m_size -= m_entries.back().pcm.size();
+        m_entries.pop_back();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+#include <list>
+
+/*
+ * PcmCache keeps synthesized audio of recently spoken texts with their word marks,
+ * so the text said again (navigation back, repeat, resume) is played without
+ * synthesis. Cached audio can be played from any word of the cached text.
+ *
+ * Texts are UTF-8 as passed to the engine, so word positions are byte offsets.
+ * Audio depends on the voice and its parameters, so every TTS engine has its
+ * own cache and clears it when the parameters change.
+ *
+ */
+class PcmCache
+{
+public:
+    struct Mark {
+        int     srcPos;     // Position of the word in the text
+        int     srcLength;
+        qint64  destPos;    // Sample the word starts at
+    };
+
+    struct Hit {
+        QByteArray      pcm;
+        QVector<Mark>   marks;
+        int             textLength; // Bytes of the text beginning covered by the audio
+    };
+
+    explicit PcmCache(qint64 maxBytes, int bytesPerSample = 2);
+
+    // Least recently used texts are evicted when the cache exceeds its size
+    void insert(const QByteArray &text, const QByteArray &pcm, const QVector<Mark> &marks);
+    // Finds audio for the longest beginning of the text, which must be the end of
+    // a cached text starting at one of its words. The beginning ends with a word of the text
+    bool find(const QByteArray &text, Hit &hit);
+    // Finds audio of exactly the cached text
+    bool findText(const QByteArray &text, Hit &hit);
+    bool contains(const QByteArray &text) const;
+    void clear();
+
+    // Cached audio of the text is written to the file, so it survives restarts
+    bool save(const QByteArray &text, const char *fileName) const;
+    // Inserts the text audio saved by save()
+    bool load(const char *fileName);
+
+    qint64 size() const;
+    int hits() const;
+    int misses() const;
+
+private:
+    struct Entry {
+        QByteArray      text;
+        QByteArray      pcm;
+        QVector<Mark>   marks;
+    };
+
+    void evict();
+
+    const qint64        m_maxBytes;
+    const int           m_bytesPerSample;
+    mutable QMutex      m_mutex;
+    std::list<Entry>    m_entries;  // Most recently used first
+    qint64              m_size {0};
+    int                 m_hits {0};
+    int                 m_misses {0};
+};
@@ -0,0 +1,182 @@
+#include "pcmringbuffer.h"
+
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+static constexpr int FULL_WAIT_MS = 5;  // Producer sleep when the buffer is full
+
+static qint64 roundUpToPowerOf2(qint64 value)
+{
+    qint64 result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+PcmRingBuffer::PcmRingBuffer(qint64 capacity, QObject *parent)
+    : QIODevice(parent)
+    , m_data(static_cast<int>(roundUpToPowerOf2(capacity)), '\0')
+    , m_mask(m_data.size() - 1)
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 PcmRingBuffer::push(const char *data, qint64 size)
+{
+    qint64 pushed = 0;
+    while (pushed < size && !m_isAborted.load(std::memory_order_relaxed)) {
+        const auto writePos = m_writePos.load(std::memory_order_relaxed);
+        const auto used = writePos - m_readPos.load(std::memory_order_acquire);
+        const auto free = capacity() - used;
+        if (free == 0) {
+            // Back-pressure: the synthesis is ahead of the playback
+            QThread::msleep(FULL_WAIT_MS);
+            continue;
+        }
+
+        const auto chunk = std::min(free, size - pushed);
+        const auto offset = writePos & m_mask;
+        const auto firstPart = std::min(chunk, capacity() - offset);
+        std::memcpy(m_data.data() + offset, data + pushed, firstPart);
+        std::memcpy(m_data.data(), data + pushed + firstPart, chunk - firstPart);
+        m_writePos.store(writePos + chunk, std::memory_order_release);
+        pushed += chunk;
+
+        if (used + chunk > m_peakFill.load(std::memory_order_relaxed))
+            m_peakFill.store(used + chunk, std::memory_order_relaxed);
+    }
+
+    return pushed;
+}
+
+void PcmRingBuffer::finish(qint64 drainSize)
+{
+    m_drainSize = drainSize;
+    m_isFinished = true;
+}
+
+void PcmRingBuffer::reopen()
+{
+    m_isFinished = false;
+}
+
+void PcmRingBuffer::abort()
+{
+    m_isAborted = true;
+}
+
+void PcmRingBuffer::clearStream()
+{
+    m_readPos = 0;
+    m_writePos = 0;
+    m_peakFill = 0;
+    m_underruns = 0;
+    m_isFinished = false;
+    m_isAborted = false;
+    m_drainSize = 0;
+    m_drainedSilence = 0;
+    m_isUnderrun = false;
+    m_isDraining = false;
+    m_drainLeft = 0;
+}
+
+bool PcmRingBuffer::isFinished() const
+{
+    return m_isFinished;
+}
+
+qint64 PcmRingBuffer::capacity() const
+{
+    return m_mask + 1;
+}
+
+qint64 PcmRingBuffer::fill() const
+{
+    return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_acquire);
+}
+
+qint64 PcmRingBuffer::pushed() const
+{
+    return m_writePos.load(std::memory_order_acquire);
+}
+
+qint64 PcmRingBuffer::peakFill() const
+{
+    return m_peakFill;
+}
+
+int PcmRingBuffer::underruns() const
+{
+    return m_underruns;
+}
+
+qint64 PcmRingBuffer::drainedSilence() const
+{
+    return m_drainedSilence;
+}
+
+bool PcmRingBuffer::isSequential() const
+{
+    return true;
+}
+
+qint64 PcmRingBuffer::bytesAvailable() const
+{
+    return (m_isAborted ? 0 : fill()) + QIODevice::bytesAvailable();
+}
+
+qint64 PcmRingBuffer::readData(char *data, qint64 maxSize)
+{
+    if (m_isAborted.load(std::memory_order_relaxed))
+        return 0;
+
+    const auto readPos = m_readPos.load(std::memory_order_relaxed);
+    const auto available = m_writePos.load(std::memory_order_acquire) - readPos;
+    if (available == 0) {
+        if (m_isFinished.load(std::memory_order_acquire))
+            return readDrain(data, maxSize);
+
+        // Count each starvation once, not every poll of the audio output
+        if (!m_isUnderrun) {
+            m_isUnderrun = true;
+            ++m_underruns;
+        }
+        return 0;
+    }
+
+    m_isUnderrun = false;
+    m_isDraining = false;
+    const auto size = std::min(available, maxSize);
+    const auto offset = readPos & m_mask;
+    const auto firstPart = std::min(size, capacity() - offset);
+    std::memcpy(data, m_data.constData() + offset, firstPart);
+    std::memcpy(data + firstPart, m_data.constData(), size - firstPart);
+    m_readPos.store(readPos + size, std::memory_order_release);
+
+    return size;
+}
+
+// Silence after the end of data lets the audio output play out its own buffer
+// before it goes idle and gets stopped
+qint64 PcmRingBuffer::readDrain(char *data, qint64 maxSize)
+{
+    if (!m_isDraining) {
+        m_isDraining = true;
+        m_drainLeft = m_drainSize;
+    }
+
+    const auto size = std::min(m_drainLeft, maxSize);
+    std::memset(data, 0, size);
+    m_drainLeft -= size;
+    m_drainedSilence += size;
+    return size;
+}
+
+qint64 PcmRingBuffer::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    // Data is pushed by the producer with push(), the device is read only
+    return -1;
+}
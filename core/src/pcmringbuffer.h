@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QIODevice>
+#include <QByteArray>
+#include <atomic>
+
+/*
+ * PcmRingBuffer is a fixed size single producer / single consumer ring buffer
+ * of PCM data, read by QAudioOutput in pull mode.
+ *
+ * The synthesis thread pushes samples and waits while the buffer is full. The
+ * audio thread reads without locks. Read and write positions grow monotonically,
+ * their difference is the amount of buffered data.
+ *
+ */
+class PcmRingBuffer : public QIODevice
+{
+public:
+    // Capacity is rounded up to the power of 2
+    explicit PcmRingBuffer(qint64 capacity, QObject *parent = nullptr);
+
+    // Producer side. Blocks while the buffer is full, returns number of bytes
+    // pushed, which is less than size only if the buffer was aborted
+    qint64 push(const char *data, qint64 size);
+    // No more data will be pushed till reopen() or clearStream(), so empty buffer is not
+    // underrun. Consumer reads drainSize bytes of silence after the data
+    void finish(qint64 drainSize = 0);
+    void reopen();
+    // Unblocks producer and drops all pushed data
+    void abort();
+    // Prepares buffer for the new stream, neither producer nor consumer may be active
+    void clearStream();
+
+    bool isFinished() const;
+    qint64 capacity() const;
+    qint64 fill() const;
+    // All data pushed since clearStream()
+    qint64 pushed() const;
+    qint64 peakFill() const;
+    int underruns() const;
+    // Silence read by consumer after finish() and before more data was pushed
+    qint64 drainedSilence() const;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    qint64 readDrain(char *data, qint64 maxSize);
+
+private:
+    QByteArray m_data;
+    const qint64 m_mask;
+    std::atomic<qint64> m_readPos {0};
+    std::atomic<qint64> m_writePos {0};
+    std::atomic<qint64> m_peakFill {0};
+    std::atomic<int> m_underruns {0};
+    std::atomic<bool> m_isFinished {false};
+    std::atomic<bool> m_isAborted {false};
+    std::atomic<qint64> m_drainSize {0};
+    std::atomic<qint64> m_drainedSilence {0};
+    // Accessed by consumer only
+    bool m_isUnderrun {false};
+    bool m_isDraining {false};
+    qint64 m_drainLeft {0};
+};
@@ -0,0 +1,145 @@
+#include "silencetrimmer.h"
+
+#include <algorithm>
+
+static constexpr int FRAME_MS = 5;
+static constexpr float SILENCE_LEVEL = 100;     // RMS amplitude, about -50 dBFS
+
+// Independent sums keep the loop free of dependencies, so the compiler vectorizes it
+static float sumOfSquares(const qint16 *samples, int count)
+{
+    constexpr int LANES = 8;
+    float sums[LANES] = {};
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const float sample = samples[i + lane];
+            sums[lane] += sample * sample;
+        }
+    }
+    float sum = 0;
+    for (int lane = 0; lane < LANES; ++lane)
+        sum += sums[lane];
+    for (; i < count; ++i)
+        sum += static_cast<float>(samples[i]) * samples[i];
+    return sum;
+}
+
+SilenceTrimmer::SilenceTrimmer(int sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_frameSize(std::max(1, sampleRate * FRAME_MS / 1000))
+{
+}
+
+int SilenceTrimmer::pauseAfterMs(const Pauses &pauses, const QString &text)
+{
+    // Closing quotes and brackets don't change the pause
+    static const QString CLOSING = QStringLiteral(")]}\"'»”’");
+    static const QString SENTENCE_END = QStringLiteral(".!?…");
+    static const QString CLAUSE_END = QStringLiteral(",;:-–—");
+
+    int i = text.size() - 1;
+    while (i >= 0 && (text[i].isSpace() || CLOSING.contains(text[i])))
+        --i;
+    if (i < 0)
+        return pauses.wordMs;
+    if (SENTENCE_END.contains(text[i]))
+        return pauses.sentenceMs;
+    if (CLAUSE_END.contains(text[i]))
+        return pauses.clauseMs;
+    return pauses.wordMs;
+}
+
+void SilenceTrimmer::start(int maxLeadingMs)
+{
+    m_maxLeading = samplesForMs(maxLeadingMs);
+    m_isLeading = true;
+    m_frame.clear();
+    m_silence.clear();
+    m_sourcePos = 0;
+    m_leadingTrimmed = 0;
+}
+
+void SilenceTrimmer::push(const qint16 *samples, int count, std::vector<qint16> &output)
+{
+    m_sourcePos += count;
+    int i = 0;
+    if (!m_frame.empty()) {
+        i = std::min(count, m_frameSize - static_cast<int>(m_frame.size()));
+        m_frame.insert(m_frame.end(), samples, samples + i);
+        if (static_cast<int>(m_frame.size()) < m_frameSize)
+            return;
+        processFrame(m_frame.data(), m_frameSize, output);
+        m_frame.clear();
+    }
+    for (; i + m_frameSize <= count; i += m_frameSize)
+        processFrame(samples + i, m_frameSize, output);
+    m_frame.assign(samples + i, samples + count);
+}
+
+void SilenceTrimmer::finish(int maxTrailingMs, std::vector<qint16> &output)
+{
+    if (!m_frame.empty()) {
+        processFrame(m_frame.data(), static_cast<int>(m_frame.size()), output);
+        m_frame.clear();
+    }
+
+    // Silent segment keeps its beginning, as if it was the trailing silence
+    const int maxTrailing = samplesForMs(maxTrailingMs);
+    const auto kept = maxTrailing < 0 ? m_silence.size() : std::min<size_t>(m_silence.size(), maxTrailing);
+    output.insert(output.end(), m_silence.begin(), m_silence.begin() + kept);
+    m_trimmedSamples += m_silence.size() - kept;
+    m_silence.clear();
+    m_isLeading = false;
+}
+
+bool SilenceTrimmer::isLeading() const
+{
+    return m_isLeading;
+}
+
+qint64 SilenceTrimmer::sourcePosition() const
+{
+    return m_sourcePos;
+}
+
+qint64 SilenceTrimmer::outputPosition(qint64 sourcePos) const
+{
+    return std::max<qint64>(0, sourcePos - m_leadingTrimmed);
+}
+
+qint64 SilenceTrimmer::trimmedSamples() const
+{
+    return m_trimmedSamples;
+}
+
+void SilenceTrimmer::processFrame(const qint16 *frame, int count, std::vector<qint16> &output)
+{
+    if (isSilent(frame, count)) {
+        m_silence.insert(m_silence.end(), frame, frame + count);
+        return;
+    }
+
+    auto first = m_silence.begin();
+    if (m_isLeading) {
+        m_isLeading = false;
+        if (m_maxLeading >= 0 && static_cast<int>(m_silence.size()) > m_maxLeading) {
+            m_leadingTrimmed = static_cast<qint64>(m_silence.size()) - m_maxLeading;
+            m_trimmedSamples += m_leadingTrimmed;
+            first = m_silence.end() - m_maxLeading;
+        }
+    }
+    output.insert(output.end(), first, m_silence.end());
+    m_silence.clear();
+    output.insert(output.end(), frame, frame + count);
+}
+
+bool SilenceTrimmer::isSilent(const qint16 *frame, int count) const
+{
+    return sumOfSquares(frame, count) < SILENCE_LEVEL * SILENCE_LEVEL * count;
+}
+
+int SilenceTrimmer::samplesForMs(int ms) const
+{
+    return ms < 0 ? -1 : static_cast<int>(static_cast<qint64>(ms) * m_sampleRate / 1000);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+/*
+ * SilenceTrimmer shortens the silence the engine puts around every synthesized
+ * segment, so the pauses between the segments read one after another don't add up.
+ *
+ * Silence is found by the energy of short frames. Silence inside the segment is
+ * kept, the leading one is cut once the speech starts and the trailing one when
+ * the segment is finished, to the pause that suits the end of its text.
+ *
+ */
+class SilenceTrimmer
+{
+public:
+    // Longest pauses kept, negative keeps the whole silence
+    struct Pauses {
+        int leadingMs {30};
+        int wordMs {80};        // Segment ends within the sentence
+        int clauseMs {200};     // Segment ends with a comma, colon or dash
+        int sentenceMs {400};   // Segment ends the sentence
+    };
+
+    explicit SilenceTrimmer(int sampleRate);
+
+    static int pauseAfterMs(const Pauses &pauses, const QString &text);
+
+    // Starts the segment, its positions count from 0
+    void start(int maxLeadingMs);
+    // Appends the samples to the output, except the silence that may be trimmed yet
+    void push(const qint16 *samples, int count, std::vector<qint16> &output);
+    // Appends the rest of the segment with the trailing silence trimmed
+    void finish(int maxTrailingMs, std::vector<qint16> &output);
+
+    // Output positions of the samples aren't known till the speech starts
+    bool isLeading() const;
+    qint64 sourcePosition() const;
+    qint64 outputPosition(qint64 sourcePos) const;
+    // Samples trimmed since construction
+    qint64 trimmedSamples() const;
+
+private:
+    void processFrame(const qint16 *frame, int count, std::vector<qint16> &output);
+    bool isSilent(const qint16 *frame, int count) const;
+    int samplesForMs(int ms) const;
+
+private:
+    const int               m_sampleRate;
+    const int               m_frameSize;
+    int                     m_maxLeading {0};
+    bool                    m_isLeading {true};
+    std::vector<qint16>     m_frame;        // Samples of the incomplete frame
+    std::vector<qint16>     m_silence;      // Silence since the last speech frame
+    qint64                  m_sourcePos {0};
+    qint64                  m_leadingTrimmed {0};
+    qint64                  m_trimmedSamples {0};
+};
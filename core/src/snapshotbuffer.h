@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * SnapshotBuffer passes the latest value from one thread to another without
+ * locks (triple buffering). The writer fills the back value and publishes it,
+ * the reader takes the latest published one. Neither waits for the other, the
+ * values published in between are skipped.
+ *
+ * The values are reused, so the writer overwrites the whole back value, and
+ * keeps its capacity when it's a container.
+ *
+ */
+template<typename T>
+class SnapshotBuffer
+{
+public:
+    SnapshotBuffer() = default;
+    SnapshotBuffer(const SnapshotBuffer &) = delete;
+    SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+
+    // Writer side, the value to publish next
+    T &back()
+    {
+        return m_values[m_back];
+    }
+
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side, stays valid till the next call
+    const T &latest()
+    {
+        if (m_middle.load(std::memory_order_relaxed) & FRESH)
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        return m_values[m_front];
+    }
+
+private:
+    static constexpr int INDEX = 3;
+    static constexpr int FRESH = 4;
+
+    T                   m_values[3];
+    int                 m_back {0};
+    std::atomic<int>    m_middle {1};   // Published value, FRESH till the reader takes it
+    int                 m_front {2};
+};
+
+template<typename T>
+constexpr int SnapshotBuffer<T>::INDEX;
+template<typename T>
+constexpr int SnapshotBuffer<T>::FRESH;
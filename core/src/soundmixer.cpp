@@ -0,0 +1,274 @@
+#include "soundmixer.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr int DUCK_RAMP_MS = 10;
+static constexpr int SPAN_HISTORY_MS = 5000;
+
+static quint32 readLe(const char *data, int size)
+{
+    quint32 value = 0;
+    for (int i = size - 1; i >= 0; --i)
+        value = (value << 8) | static_cast<quint8>(data[i]);
+    return value;
+}
+
+SoundMixer::SoundMixer(int sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_rampSamples(std::max(1, sampleRate * DUCK_RAMP_MS / 1000))
+{
+}
+
+SoundMixer::Sound SoundMixer::decodeWav(const QByteArray &data, int sampleRate)
+{
+    if (data.size() < 12 || std::memcmp(data.constData(), "RIFF", 4) != 0
+            || std::memcmp(data.constData() + 8, "WAVE", 4) != 0)
+        return nullptr;
+
+    int format = 0;
+    int channels = 0;
+    int fileRate = 0;
+    int bits = 0;
+    const char *samples = nullptr;
+    int size = 0;
+    for (int pos = 12; pos + 8 <= data.size();) {
+        const char *chunk = data.constData() + pos;
+        const int chunkSize = static_cast<int>(std::min<quint32>(readLe(chunk + 4, 4), data.size() - pos - 8));
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+            format = static_cast<int>(readLe(chunk + 8, 2));
+            channels = static_cast<int>(readLe(chunk + 10, 2));
+            fileRate = static_cast<int>(readLe(chunk + 12, 4));
+            bits = static_cast<int>(readLe(chunk + 22, 2));
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            samples = chunk + 8;
+            size = chunkSize;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    if (format != 1 || channels < 1 || channels > 2 || fileRate <= 0 || (bits != 8 && bits != 16) || !samples)
+        return nullptr;
+
+    // Channels are averaged, 8-bit samples are unsigned
+    const int frameBytes = channels * bits / 8;
+    const int frames = size / frameBytes;
+    std::vector<float> mono(static_cast<size_t>(frames));
+    for (int i = 0; i < frames; ++i) {
+        float sum = 0;
+        for (int channel = 0; channel < channels; ++channel) {
+            const char *sample = samples + i * frameBytes + channel * bits / 8;
+            sum += bits == 16 ? static_cast<qint16>(readLe(sample, 2)) : (static_cast<quint8>(*sample) - 128) * 256;
+        }
+        mono[static_cast<size_t>(i)] = sum / channels;
+    }
+
+    // Linear interpolation is enough for the clicks and beeps
+    const auto count = static_cast<size_t>(static_cast<qint64>(frames) * sampleRate / fileRate);
+    auto sound = std::make_shared<std::vector<qint16>>(count);
+    for (size_t i = 0; i < count; ++i) {
+        const double source = static_cast<double>(i) * fileRate / sampleRate;
+        const auto first = static_cast<size_t>(source);
+        const auto second = std::min(first + 1, mono.size() - 1);
+        const auto fraction = static_cast<float>(source - first);
+        (*sound)[i] = static_cast<qint16>(mono[first] + (mono[second] - mono[first]) * fraction);
+    }
+    return sound;
+}
+
+void SoundMixer::setDuckGain(float gain)
+{
+    m_duckGain = std::min(1.0f, std::max(0.0f, gain));
+}
+
+void SoundMixer::setTail(int samples)
+{
+    m_tailSamples = std::max(0, samples);
+}
+
+void SoundMixer::restart()
+{
+    m_repeatNext = std::max<qint64>(0, m_repeatNext - m_clock);
+    m_soundEnd = std::max<qint64>(0, m_soundEnd - m_clock);
+    m_clock = 0;
+    m_spans.clear();
+}
+
+void SoundMixer::play(const Sound &sound)
+{
+    if (sound && !sound->empty())
+        m_voices.push_back({sound, 0, 0, 0});
+}
+
+void SoundMixer::startRepeating(const Sound &sound, int delayMs, int intervalMs)
+{
+    if (!sound || sound->empty() || intervalMs <= 0)
+        return;
+    m_repeated = sound;
+    m_repeatNext = m_clock + static_cast<qint64>(delayMs) * m_sampleRate / 1000;
+    m_repeatInterval = std::max<qint64>(1, static_cast<qint64>(intervalMs) * m_sampleRate / 1000);
+}
+
+void SoundMixer::stopRepeating()
+{
+    m_repeated.reset();
+}
+
+int SoundMixer::read(qint16 *output, int maxCount, const SpeechSource &speech)
+{
+    int count = 0;
+    if (speech) {
+        count = speech(output, maxCount);
+        if (count <= 0)
+            return 0;
+    } else {
+        // The repeated sound keeps the clock running with silence between the repeats
+        if (!m_voices.empty())
+            m_soundEnd = std::max(m_soundEnd, m_clock + longestVoice() + m_tailSamples);
+        count = m_repeated ? maxCount : static_cast<int>(std::min<qint64>(maxCount, m_soundEnd - m_clock));
+        if (count <= 0)
+            return 0;
+        std::fill(output, output + count, 0);
+    }
+
+    // Beeps that would cut into the speech are skipped
+    startRepeated(count, !speech);
+    m_mix.assign(static_cast<size_t>(count), 0.0f);
+    m_bounds.assign({0, count});
+    mixVoices(count);
+
+    // Speech is ducked where a sound plays, the bounds split the read to the parts with and without it
+    std::sort(m_bounds.begin(), m_bounds.end());
+    m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()), m_bounds.end());
+    for (size_t i = 0; i + 1 < m_bounds.size(); ++i) {
+        const int start = m_bounds[i];
+        const int end = m_bounds[i + 1];
+        const bool isSound = std::any_of(m_voices.begin(), m_voices.end(), [start, end](const Voice &voice) {
+            return voice.offset <= start && voice.offset + voice.length >= end;
+        });
+        applyGain(output, start, end, isSound ? m_duckGain : 1.0f);
+    }
+    m_voices.erase(std::remove_if(m_voices.begin(), m_voices.end(), [](const Voice &voice) {
+        return voice.pos >= voice.sound->size();
+    }), m_voices.end());
+    for (auto &voice : m_voices)
+        voice.offset = 0;
+
+    addSpan(count, static_cast<bool>(speech));
+    m_clock += count;
+    return count;
+}
+
+void SoundMixer::resetSpeech()
+{
+    m_speechPos = 0;
+    m_spans.clear();
+}
+
+bool SoundMixer::isPlaying() const
+{
+    return !m_voices.empty() || m_repeated;
+}
+
+qint64 SoundMixer::clock() const
+{
+    return m_clock;
+}
+
+template<typename Spans>
+static qint64 mapToSpeech(const Spans &spans, qint64 speechPos, qint64 outputPos)
+{
+    if (spans.empty())
+        return speechPos;
+    if (outputPos < spans.front().outputPos)
+        return spans.front().speechPos;
+    const auto span = std::upper_bound(spans.begin(), spans.end(), outputPos,
+                                       [](qint64 pos, const SoundMixer::Span &span) {
+        return pos < span.outputPos;
+    }) - 1;
+    if (!span->isSpeech)
+        return span->speechPos;
+    return span->speechPos + std::min(outputPos - span->outputPos, span->length);
+}
+
+qint64 SoundMixer::speechPosition(qint64 outputPos) const
+{
+    return mapToSpeech(m_spans, m_speechPos, outputPos);
+}
+
+void SoundMixer::copySpeechMap(SpeechMap &map) const
+{
+    map.spans.assign(m_spans.begin(), m_spans.end());
+    map.speechPos = m_speechPos;
+}
+
+qint64 SoundMixer::SpeechMap::speechPosition(qint64 outputPos) const
+{
+    return mapToSpeech(spans, speechPos, outputPos);
+}
+
+int SoundMixer::longestVoice() const
+{
+    int longest = 0;
+    for (const auto &voice : m_voices)
+        longest = std::max(longest, voice.offset + static_cast<int>(voice.sound->size() - voice.pos));
+    return longest;
+}
+
+void SoundMixer::startRepeated(int count, bool isFired)
+{
+    if (!m_repeated)
+        return;
+    for (; m_repeatNext < m_clock + count; m_repeatNext += m_repeatInterval) {
+        if (isFired)
+            m_voices.push_back({m_repeated, 0, static_cast<int>(std::max<qint64>(0, m_repeatNext - m_clock)), 0});
+    }
+}
+
+void SoundMixer::mixVoices(int count)
+{
+    float *mix = m_mix.data();
+    for (auto &voice : m_voices) {
+        const qint16 *sound = voice.sound->data() + voice.pos;
+        voice.length = std::max(0, std::min(count - voice.offset, static_cast<int>(voice.sound->size() - voice.pos)));
+        float *target = mix + voice.offset;
+        for (int i = 0; i < voice.length; ++i)
+            target[i] += sound[i];
+        voice.pos += static_cast<size_t>(voice.length);
+        m_bounds.push_back(voice.offset);
+        m_bounds.push_back(voice.offset + voice.length);
+    }
+}
+
+// Gain ramps to the target without clicks. No dependencies between the samples let the compiler
+// vectorize the loop
+void SoundMixer::applyGain(qint16 *output, int start, int end, float target)
+{
+    const float step = (target < m_gain ? -1.0f : 1.0f) * (1.0f - m_duckGain) / m_rampSamples;
+    const float low = std::min(m_gain, target);
+    const float high = std::max(m_gain, target);
+    const float first = m_gain;
+    const float *mix = m_mix.data();
+    for (int i = start; i < end; ++i) {
+        const float gain = std::min(high, std::max(low, first + step * (i - start + 1)));
+        const float value = output[i] * gain + mix[i];
+        output[i] = static_cast<qint16>(std::min(32767.0f, std::max(-32768.0f, value)));
+    }
+    m_gain = std::min(high, std::max(low, first + step * (end - start)));
+}
+
+// Spans map the output back to the speech, so the marks of the words stay in place around the sounds
+void SoundMixer::addSpan(int count, bool isSpeech)
+{
+    if (!m_spans.empty() && m_spans.back().isSpeech == isSpeech
+            && m_spans.back().outputPos + m_spans.back().length == m_clock) {
+        m_spans.back().length += count;
+    } else {
+        m_spans.push_back({m_clock, m_speechPos, count, isSpeech});
+    }
+    if (isSpeech)
+        m_speechPos += count;
+
+    const qint64 historyStart = m_clock - static_cast<qint64>(SPAN_HISTORY_MS) * m_sampleRate / 1000;
+    while (m_spans.size() > 1 && m_spans[1].outputPos < historyStart)
+        m_spans.pop_front();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+ * SoundMixer mixes the short sounds, like the shutter click and the beep, into the
+ * speech stream of the audio output, so they share one device and may overlap.
+ *
+ * Sounds are decoded to PCM of the output once and start at the exact frame of the
+ * output clock. Speech is ducked while a sound plays. Speech that runs dry stalls
+ * the output, so the output goes idle at the end of the speech as without the mixer.
+ *
+ */
+class SoundMixer
+{
+public:
+    using Sound = std::shared_ptr<const std::vector<qint16>>;
+    // Reads up to maxCount speech samples, 0 when none is buffered
+    using SpeechSource = std::function<int(qint16 *samples, int maxCount)>;
+    // Output span that was speech or only the sounds
+    struct Span {
+        qint64  outputPos;
+        qint64  speechPos;
+        qint64  length;
+        bool    isSpeech;
+    };
+    // Copy of the speech positions, for the threads that don't own the mixer
+    struct SpeechMap {
+        std::vector<Span>   spans;
+        qint64              speechPos {0};  // Past the spans
+        qint64 speechPosition(qint64 outputPos) const;
+    };
+
+    explicit SoundMixer(int sampleRate);
+
+    // 8 or 16-bit PCM WAV, mono or stereo of any rate, converted to mono of the sample rate
+    static Sound decodeWav(const QByteArray &data, int sampleRate);
+
+    // Gain of the speech while a sound plays
+    void setDuckGain(float gain);
+    // Silence after the sounds played alone, so the device plays them out before it goes idle
+    void setTail(int samples);
+    // Output clock starts from 0 with the device, the repeated sound keeps its phase
+    void restart();
+    void play(const Sound &sound);
+    // Repeats the sound on the output clock while no speech is read
+    void startRepeating(const Sound &sound, int delayMs, int intervalMs);
+    void stopRepeating();
+
+    // Mixes the sounds into the speech, or plays them alone when there is no speech source
+    int read(qint16 *output, int maxCount, const SpeechSource &speech);
+    // Speech positions count from 0 again
+    void resetSpeech();
+
+    bool isPlaying() const;     // A sound plays or repeats
+    qint64 clock() const;
+    // Speech samples played by the output position of the clock
+    qint64 speechPosition(qint64 outputPos) const;
+    // Reuses the memory of the map, so the copies don't allocate once it's grown
+    void copySpeechMap(SpeechMap &map) const;
+
+private:
+    struct Voice {
+        Sound   sound;
+        size_t  pos;
+        int     offset;     // Start in the current read
+        int     length;     // Mixed in the current read
+    };
+    int longestVoice() const;
+    void startRepeated(int count, bool isFired);
+    void mixVoices(int count);
+    void applyGain(qint16 *output, int start, int end, float target);
+    void addSpan(int count, bool isSpeech);
+
+private:
+    const int           m_sampleRate;
+    const int           m_rampSamples;
+    float               m_duckGain {0.3f};
+    float               m_gain {1.0f};
+    int                 m_tailSamples {0};
+    qint64              m_clock {0};
+    qint64              m_soundEnd {0};     // Clock till which the sounds alone are output
+    std::vector<Voice>  m_voices;
+    std::vector<float>  m_mix;
+    std::vector<int>    m_bounds;       // Starts and ends of the sounds in the current read
+    Sound               m_repeated;
+    qint64              m_repeatNext {0};
+    qint64              m_repeatInterval {0};
+    qint64              m_speechPos {0};
+    std::deque<Span>    m_spans;
+};
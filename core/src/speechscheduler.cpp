@@ -0,0 +1,155 @@
+#include "speechscheduler.h"
+
+#include <algorithm>
+
+static const char *PRIORITY_NAMES[] = {"alert", "feedback", "page", "background"};
+
+SpeechScheduler::Decision SpeechScheduler::submit(const QString &text, SpeechPriority priority, bool isQueued,
+                                                  qint64 nowMs)
+{
+    ++statsOf(priority).submitted;
+    const Item item {text, priority, nowMs};
+
+    // Button pressed again says its feedback again, the rest isn't repeated while it's said
+    const bool isRepeatable = !isQueued && priority == SpeechPriority::Feedback;
+    if (m_hasCurrent && m_current.priority != SpeechPriority::Page && m_current.text == text && !isRepeatable) {
+        ++statsOf(priority).dropped;
+        return Decision::Drop;
+    }
+
+    // Background never interrupts, other speech interrupts the less important one. The newer
+    // feedback replaces the older, as it answers the last button
+    const bool isPreempting = !m_hasCurrent
+            || (!isQueued && priority != SpeechPriority::Background
+                && (priority < m_current.priority
+                    || (priority == SpeechPriority::Feedback && m_current.priority == SpeechPriority::Feedback)));
+    if (isPreempting) {
+        if (m_hasCurrent)
+            ++statsOf(m_current.priority).preempted;
+        start(item, nowMs);
+        return Decision::Start;
+    }
+
+    if (isTextQueued(text)) {
+        ++statsOf(priority).dropped;
+        return Decision::Drop;
+    }
+    enqueue(item);
+    return Decision::Queue;
+}
+
+void SpeechScheduler::startPage(qint64 nowMs)
+{
+    ++statsOf(SpeechPriority::Page).submitted;
+    if (m_hasCurrent && m_current.priority != SpeechPriority::Page)
+        ++statsOf(m_current.priority).preempted;
+    start({QString(), SpeechPriority::Page, nowMs}, nowMs);
+}
+
+bool SpeechScheduler::next(QString &text, qint64 nowMs)
+{
+    m_hasCurrent = false;
+    if (m_queue.empty())
+        return false;
+
+    const Item item = m_queue.front();
+    m_queue.pop_front();
+    start(item, nowMs);
+    text = item.text;
+    return true;
+}
+
+void SpeechScheduler::stop()
+{
+    for (const auto &item : m_queue)
+        ++statsOf(item.priority).dropped;
+    m_queue.clear();
+    m_hasCurrent = false;
+}
+
+bool SpeechScheduler::isIdle() const
+{
+    return !m_hasCurrent && m_queue.empty();
+}
+
+bool SpeechScheduler::hasCurrent() const
+{
+    return m_hasCurrent;
+}
+
+SpeechPriority SpeechScheduler::currentPriority() const
+{
+    return m_current.priority;
+}
+
+int SpeechScheduler::queueSize() const
+{
+    return static_cast<int>(m_queue.size());
+}
+
+SpeechScheduler::Stats SpeechScheduler::stats(SpeechPriority priority) const
+{
+    return m_stats[static_cast<size_t>(priority)];
+}
+
+QString SpeechScheduler::report() const
+{
+    QString result = "Speech queue:";
+    for (size_t i = 0; i < m_stats.size(); ++i) {
+        const auto &stats = m_stats[i];
+        if (stats.submitted == 0)
+            continue;
+        result += QString(" %1 %2 started, %3 preempted, %4 dropped, latency avg %5 max %6 ms;")
+                .arg(PRIORITY_NAMES[i])
+                .arg(stats.started)
+                .arg(stats.preempted)
+                .arg(stats.dropped)
+                .arg(stats.started > 0 ? stats.totalLatencyMs / stats.started : 0)
+                .arg(stats.maxLatencyMs);
+    }
+    return result;
+}
+
+void SpeechScheduler::start(const Item &item, qint64 nowMs)
+{
+    m_current = item;
+    m_hasCurrent = true;
+    auto &stats = statsOf(item.priority);
+    const qint64 latencyMs = std::max<qint64>(0, nowMs - item.submittedMs);
+    ++stats.started;
+    stats.totalLatencyMs += latencyMs;
+    stats.maxLatencyMs = std::max(stats.maxLatencyMs, latencyMs);
+}
+
+// Queue is ordered by the priority, the same priority in the order of arrival
+void SpeechScheduler::enqueue(const Item &item)
+{
+    if (item.priority == SpeechPriority::Background) {
+        const auto queued = std::find_if(m_queue.begin(), m_queue.end(), [](const Item &queuedItem) {
+            return queuedItem.priority == SpeechPriority::Background;
+        });
+        if (queued != m_queue.end()) {
+            // Older progress is outdated, it's replaced in its place
+            ++statsOf(SpeechPriority::Background).dropped;
+            queued->text = item.text;
+            return;
+        }
+    }
+
+    const auto position = std::upper_bound(m_queue.begin(), m_queue.end(), item, [](const Item &a, const Item &b) {
+        return a.priority < b.priority;
+    });
+    m_queue.insert(position, item);
+}
+
+bool SpeechScheduler::isTextQueued(const QString &text) const
+{
+    return std::any_of(m_queue.begin(), m_queue.end(), [&text](const Item &item) {
+        return item.text == text;
+    });
+}
+
+SpeechScheduler::Stats &SpeechScheduler::statsOf(SpeechPriority priority)
+{
+    return m_stats[static_cast<size_t>(priority)];
+}
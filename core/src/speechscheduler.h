@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QString>
+#include <array>
+#include <deque>
+
+// More important speech comes first
+enum class SpeechPriority {
+    Alert,          // State changes the user must hear, not cut by the feedback
+    Feedback,       // Answers to the buttons, the newer one replaces the older
+    Page,           // Page reading, resumes at the current word after the prompts
+    Background,     // Progress of the book conversion, only the latest is kept
+};
+
+/*
+ * SpeechScheduler decides which of the prompts and the page reading is said.
+ *
+ * A prompt starts at once when it's more important than the current speech, the
+ * rest wait in the queue till the current speech finishes. The same prompt isn't
+ * restarted or queued twice, so repeated events don't synthesize it again.
+ *
+ * The scheduler only orders the speech, the caller says it. Times are passed in,
+ * so the queue latency is measured on the caller's clock.
+ *
+ */
+class SpeechScheduler
+{
+public:
+    enum class Decision {
+        Start,      // Say now, the current speech is stopped
+        Queue,      // Said after the current speech by next()
+        Drop,       // Same text is said or queued already
+    };
+
+    struct Stats {
+        int     submitted {0};
+        int     started {0};
+        int     preempted {0};      // Stopped by the more important speech
+        int     dropped {0};
+        qint64  totalLatencyMs {0};
+        qint64  maxLatencyMs {0};
+    };
+
+    Decision submit(const QString &text, SpeechPriority priority, bool isQueued, qint64 nowMs);
+    // Page reading started, the queued prompts wait for it
+    void startPage(qint64 nowMs);
+    // Current speech finished. Returns the queued prompt that becomes current
+    bool next(QString &text, qint64 nowMs);
+    // Speech was stopped by the user, the queued prompts are dropped
+    void stop();
+
+    bool isIdle() const;
+    bool hasCurrent() const;
+    SpeechPriority currentPriority() const;
+    int queueSize() const;
+    Stats stats(SpeechPriority priority) const;
+    QString report() const;
+
+private:
+    struct Item {
+        QString         text;
+        SpeechPriority  priority;
+        qint64          submittedMs;
+    };
+
+    void start(const Item &item, qint64 nowMs);
+    void enqueue(const Item &item);
+    bool isTextQueued(const QString &text) const;
+    Stats &statsOf(SpeechPriority priority);
+
+private:
+    bool                m_hasCurrent {false};
+    Item                m_current {};
+    std::deque<Item>    m_queue;
+    std::array<Stats, 4> m_stats;
+};
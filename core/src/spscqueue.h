@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/*
+ * SpscQueue is a bounded queue from one thread to another without locks.
+ * Capacity is a power of 2, push() fails when the queue is full. Values are
+ * moved out by pop(), so the slots don't keep them alive.
+ *
+ */
+template<typename T, unsigned Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side
+    bool push(const T &value)
+    {
+        const unsigned writePos = m_writePos.load(std::memory_order_relaxed);
+        if (writePos - m_readPos.load(std::memory_order_acquire) == Capacity)
+            return false;
+        m_values[writePos % Capacity] = value;
+        m_writePos.store(writePos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &value)
+    {
+        const unsigned readPos = m_readPos.load(std::memory_order_relaxed);
+        if (readPos == m_writePos.load(std::memory_order_acquire))
+            return false;
+        value = std::move(m_values[readPos % Capacity]);
+        m_values[readPos % Capacity] = T();
+        m_readPos.store(readPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushed values not popped yet, exact on either side
+    unsigned size() const
+    {
+        return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_acquire);
+    }
+
+private:
+    T                       m_values[Capacity];
+    std::atomic<unsigned>   m_writePos {0};
+    std::atomic<unsigned>   m_readPos {0};
+};
@@ -0,0 +1,131 @@
+#include "startupsequence.h"
+
+#include <QDebug>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdio>
+
+StartupSequence::StartupSequence(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StartupSequence::~StartupSequence()
+{
+    for (auto &future : m_futures)
+        future.waitForFinished();
+}
+
+void StartupSequence::addStage(const QString &name, Thread thread, const QStringList &dependencies,
+                               std::function<void()> function)
+{
+    Stage stage;
+    stage.name = name;
+    stage.thread = thread;
+    stage.function = std::move(function);
+    for (const auto &dependency : dependencies) {
+        const auto stageNum = indexOf(dependency);
+        if (stageNum < 0)
+            qWarning() << "Startup stage" << name << "depends on unknown stage" << dependency;
+        else
+            stage.dependencies.append(stageNum);
+    }
+    m_stages.append(stage);
+}
+
+void StartupSequence::start()
+{
+    m_timer.start();
+    startReadyStages();
+}
+
+bool StartupSequence::isFinished(const QString &name) const
+{
+    const auto stageNum = indexOf(name);
+    return stageNum >= 0 && m_stages[stageNum].state == State::Finished;
+}
+
+bool StartupSequence::isFinished() const
+{
+    return m_finishOrder.size() == m_stages.size();
+}
+
+QString StartupSequence::report() const
+{
+    QString report;
+    for (const auto stageNum : m_finishOrder) {
+        const auto &stage = m_stages[stageNum];
+        report += QString("%1: started at %2 ms, took %3 ms (%4)\n")
+                .arg(stage.name)
+                .arg(stage.startMs)
+                .arg(stage.endMs - stage.startMs)
+                .arg(stage.thread == Thread::Gui ? "gui" : "worker");
+    }
+    if (isFinished())
+        report += QString("Total: %1 ms\n").arg(m_stages.isEmpty() ? 0 : m_stages[m_finishOrder.last()].endMs);
+    return report;
+}
+
+bool StartupSequence::writeReport(const char *fileName) const
+{
+    FILE *fp = fopen(fileName, "w");
+    if (!fp)
+        return false;
+    const auto report = this->report().toUtf8();
+    const bool isOk = fwrite(report.constData(), 1, report.size(), fp) == static_cast<size_t>(report.size());
+    return fclose(fp) == 0 && isOk;
+}
+
+void StartupSequence::startReadyStages()
+{
+    for (int i = 0; i < m_stages.size(); ++i) {
+        auto &stage = m_stages[i];
+        if (stage.state != State::Pending)
+            continue;
+        const bool isReady = std::all_of(stage.dependencies.begin(), stage.dependencies.end(), [this](int dependency) {
+            return m_stages[dependency].state == State::Finished;
+        });
+        if (!isReady)
+            continue;
+
+        stage.state = State::Running;
+        stage.startMs = m_timer.elapsed();
+        const auto function = stage.function;
+        if (stage.thread == Thread::Worker) {
+            m_futures.append(QtConcurrent::run([this, i, function]() {
+                function();
+                QMetaObject::invokeMethod(this, [this, i]() { onStageDone(i); }, Qt::QueuedConnection);
+            }));
+        } else {
+            // Queued, so the stages started together run concurrently with the GUI stage
+            QMetaObject::invokeMethod(this, [this, i, function]() {
+                function();
+                onStageDone(i);
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void StartupSequence::onStageDone(int stageNum)
+{
+    auto &stage = m_stages[stageNum];
+    stage.state = State::Finished;
+    stage.endMs = m_timer.elapsed();
+    m_finishOrder.append(stageNum);
+    qDebug() << "Startup stage" << stage.name << "took" << stage.endMs - stage.startMs << "ms, finished at"
+             << stage.endMs << "ms";
+    emit stageFinished(stage.name);
+
+    startReadyStages();
+    if (isFinished())
+        emit finished();
+}
+
+int StartupSequence::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_stages.size(); ++i) {
+        if (m_stages[i].name == name)
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+/*
+ * StartupSequence runs initialization stages as soon as the stages they depend
+ * on are finished. Worker stages run concurrently in the thread pool, GUI stages
+ * run one by one in the thread of the sequence object, which owns QObjects.
+ *
+ * Start and duration of every stage are collected to the timing report.
+ *
+ */
+class StartupSequence : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Thread {
+        Gui,
+        Worker,
+    };
+
+    explicit StartupSequence(QObject *parent = nullptr);
+    // Waits for the running worker stages
+    ~StartupSequence();
+
+    // Dependencies must be added before the stage
+    void addStage(const QString &name, Thread thread, const QStringList &dependencies,
+                  std::function<void()> function);
+    void start();
+
+    bool isFinished(const QString &name) const;
+    bool isFinished() const;
+    // Stages in the order they finished, times are ms since start()
+    QString report() const;
+    bool writeReport(const char *fileName) const;
+
+signals:
+    void stageFinished(const QString &name);
+    void finished();
+
+private:
+    enum class State {
+        Pending,
+        Running,
+        Finished,
+    };
+
+    struct Stage {
+        QString                 name;
+        Thread                  thread;
+        QVector<int>            dependencies;
+        std::function<void()>   function;
+        State                   state {State::Pending};
+        qint64                  startMs {0};
+        qint64                  endMs {0};
+    };
+
+    void startReadyStages();
+    void onStageDone(int stageNum);
+    int indexOf(const QString &name) const;
+
+private:
+    QVector<Stage>          m_stages;
+    QVector<int>            m_finishOrder;
+    QVector<QFuture<void>>  m_futures;
+    QElapsedTimer           m_timer;
+};
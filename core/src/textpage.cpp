@@ -6,15 +6,15 @@
  ****************************************************************************/
 
 #include "textpage.h"
+#include "textscanner.h"
 
-#include <QRegularExpression>
 #include <QDebug>
 
 using namespace std;
 
 int TextPage::numParagraphs() const
 {
-    return m_paragraphs.size();
+    return static_cast<int>(m_paragraphs.size());
 }
 
 const Paragraph &TextPage::paragraph(int num) const
@@ -22,45 +22,60 @@ const Paragraph &TextPage::paragraph(int num) const
     return m_paragraphs[num];
 }
 
+// Paragraphs are already stored joined by newlines, so the page text is
+// returned as a shallow copy of the storage
 QString TextPage::text() const
 {
-    QString allText;
-    for (const auto &paragraph : m_paragraphs) {
-        const auto parText = paragraph.text();
-        if (!parText.isEmpty()) {
-            if (!allText.isEmpty()) {
-                allText.append('\n');
-            }
-            allText.append(paragraph.text());
-        }
+    return *m_storage;
+}
+
+// Returns position of the last character to say from the text of incomplete paragraph
+// without sentence terminators, or -1 if nothing can be said yet
+static int lastBoundaryPos(const Paragraph &paragraph, QStringView text, TextPage::Boundary boundary)
+{
+    switch (boundary) {
+    case TextPage::Boundary::Sentence:
+        return -1;
+    case TextPage::Boundary::Clause:
+        return TextScanner::lastIndexOf(text, TextScanner::ClauseEnd);
+    case TextPage::Boundary::Line:
+        if (paragraph.isLastWordComplete())
+            return text.size() - 1;
+        // Last word is hyphenated, stop before it
+        return TextScanner::lastIndexOf(text, TextScanner::Space) - 1;
     }
 
-    return allText;
+    return -1;
 }
 
-pair<QString, QString> TextPage::getText(int paragraphNum, int position) const
+pair<QString, QString> TextPage::getText(int paragraphNum, int position, Boundary boundary) const
 {
-    if (paragraphNum >= m_paragraphs.size())
+    if (paragraphNum >= numParagraphs())
         return pair<QString, QString>(QString(), QString());
-    pair <QString, int> lng = m_paragraphs[paragraphNum].lang(position);
+    const auto &paragraph = m_paragraphs[paragraphNum];
+    pair <QString, int> lng = paragraph.lang(position);
     lng.second -= position;
-    auto paragraphText = m_paragraphs[paragraphNum].text().mid(position);
-    if (!m_paragraphs[paragraphNum].isComplete() || lng.second >= 0) {
-        static const QRegularExpression sentenceRe(R"([\.!?])");
-        auto sentenceBoundaryPos = paragraphText.lastIndexOf(sentenceRe);
+    auto paragraphText = paragraph.textView().mid(qBound(0, position, paragraph.length()));
+    if (!paragraph.isComplete() || lng.second >= 0) {
+        auto sentenceBoundaryPos = TextScanner::lastIndexOf(paragraphText, TextScanner::sentenceEndMask(lng.first));
+        if (sentenceBoundaryPos < 0 && !paragraph.isComplete())
+            sentenceBoundaryPos = lastBoundaryPos(paragraph, paragraphText, boundary);
         if(lng.second >= 0 && sentenceBoundaryPos > lng.second)
             sentenceBoundaryPos = lng.second;
         if (sentenceBoundaryPos >= 0) {
-            paragraphText.chop(paragraphText.size() - sentenceBoundaryPos - 1);
+            paragraphText = paragraphText.left(sentenceBoundaryPos + 1);
+        } else if (!paragraph.isComplete()) {
+            // Wait for more text
+            paragraphText = QStringView();
         }
     }
-    return pair<QString, QString>(lng.first, paragraphText);
+    return pair<QString, QString>(lng.first, paragraphText.toString());
 }
 
 void TextPage::addParagraph()
 {
-    const auto paragraphNum = m_paragraphs.size();
-    m_paragraphs.push_back(Paragraph(paragraphNum));
+    const auto paragraphNum = numParagraphs();
+    m_paragraphs.emplace_back(paragraphNum, m_storage);
 
     if (paragraphNum > 0) {
         // As new paragraph added, the previous paragraph we set as completed
@@ -75,23 +90,8 @@ void TextPage::addParagraphLine(const QString &text, const QString &lang)
         return;
     }
 
-    const auto paragraphNum = m_paragraphs.size() - 1;
-
-    // Order is important:
-    // First set paragraph's position in the page if it was not yet initialized
-    if (m_paragraphs[paragraphNum].paragraphPosition() < 0) {
-        if (paragraphNum == 0) {
-            m_paragraphs[paragraphNum].setParagraphPosition(0);
-        } else {
-            const auto &prevParagraph = m_paragraphs[paragraphNum - 1];
-            // Added 1 to the length due to newline character between paragraphs
-            m_paragraphs[paragraphNum].setParagraphPosition(
-                prevParagraph.paragraphPosition() + prevParagraph.length() + 1);
-        }
-    }
-
-    // Then add the line
-     m_paragraphs[paragraphNum].addLine(text, lang);
+    // Paragraph's position in the page is defined by its offset in the storage
+    m_paragraphs.back().addLine(text, lang);
 }
 
 bool TextPage::isComplete() const
@@ -104,7 +104,7 @@ void TextPage::setCompleted()
     m_isComplete = true;
 
     // Set last paragraph as complete
-    if (!m_paragraphs.isEmpty())
+    if (!m_paragraphs.empty())
         m_paragraphs.back().setCompleted();
 }
 
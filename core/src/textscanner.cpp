@@ -0,0 +1,270 @@
+#include "textscanner.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace TextScanner {
+
+namespace {
+
+constexpr quint8 latin1Class(int c)
+{
+    if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '\'')
+        return Word;
+    if (c == ' ' || (c >= 0x09 && c <= 0x0D) || c == 0x85 || c == 0xA0)
+        return Space;
+    if (c == '-' || c == 0xAD)
+        return Dash;
+    if (c == '.' || c == '!' || c == '?')
+        return SentenceEnd;
+    if (c == ';')
+        return ClauseEnd | GreekQuestion;
+    if (c == ',' || c == ':')
+        return ClauseEnd;
+    // ª ² ³ µ ¹ º ¼ ½ ¾ and accented letters except × and ÷
+    if (c == 0xAA || c == 0xB2 || c == 0xB3 || c == 0xB5 || c == 0xB9 || c == 0xBA
+            || (c >= 0xBC && c <= 0xBE) || (c >= 0xC0 && c != 0xD7 && c != 0xF7))
+        return Word;
+    return Other;
+}
+
+struct Latin1Table {
+    quint8 cls[256];
+};
+
+constexpr Latin1Table makeLatin1Table()
+{
+    Latin1Table table {};
+    for (int c = 0; c < 256; ++c)
+        table.cls[c] = latin1Class(c);
+    return table;
+}
+
+constexpr Latin1Table LATIN1 = makeLatin1Table();
+
+struct CharRange {
+    char16_t first;
+    char16_t last;
+    quint8 cls;
+};
+
+// Punctuation and ideographs outside of Latin-1, sorted by code
+constexpr CharRange RANGES[] = {
+    {0x037E, 0x037E, SentenceEnd},  // Greek question mark
+    {0x0387, 0x0387, ClauseEnd},    // Greek ano teleia
+    {0x0589, 0x0589, SentenceEnd},  // Armenian full stop
+    {0x05BE, 0x05BE, Dash},         // Hebrew maqaf
+    {0x05C3, 0x05C3, SentenceEnd},  // Hebrew sof pasuq
+    {0x060C, 0x060C, ClauseEnd},    // Arabic comma
+    {0x061B, 0x061B, ClauseEnd},    // Arabic semicolon
+    {0x061F, 0x061F, SentenceEnd},  // Arabic question mark
+    {0x06D4, 0x06D4, SentenceEnd},  // Arabic full stop
+    {0x2010, 0x2015, Dash},         // Hyphens and dashes
+    {0x2019, 0x2019, Word},         // Right single quotation mark used as apostrophe
+    {0x2026, 0x2026, SentenceEnd},  // Horizontal ellipsis
+    {0x203C, 0x203C, SentenceEnd},  // Double exclamation mark
+    {0x2047, 0x2049, SentenceEnd},  // Double question marks
+    {0x3000, 0x3000, Space},        // Ideographic space
+    {0x3001, 0x3001, ClauseEnd},    // Ideographic comma
+    {0x3002, 0x3002, SentenceEnd},  // Ideographic full stop
+    {0x3040, 0x30FF, Ideograph},    // Hiragana and Katakana
+    {0x3400, 0x4DBF, Ideograph},    // CJK unified ideographs extension A
+    {0x4E00, 0x9FFF, Ideograph},    // CJK unified ideographs
+    {0xF900, 0xFAFF, Ideograph},    // CJK compatibility ideographs
+    {0xFF01, 0xFF01, SentenceEnd},  // Fullwidth exclamation mark
+    {0xFF0C, 0xFF0C, ClauseEnd},    // Fullwidth comma
+    {0xFF0E, 0xFF0E, SentenceEnd},  // Fullwidth full stop
+    {0xFF1A, 0xFF1B, ClauseEnd},    // Fullwidth colon and semicolon
+    {0xFF1F, 0xFF1F, SentenceEnd},  // Fullwidth question mark
+    {0xFF61, 0xFF61, SentenceEnd},  // Halfwidth ideographic full stop
+    {0xFF64, 0xFF64, ClauseEnd},    // Halfwidth ideographic comma
+};
+
+constexpr bool isSorted(const CharRange *ranges, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (ranges[i].first > ranges[i].last)
+            return false;
+        if (i > 0 && ranges[i - 1].last >= ranges[i].first)
+            return false;
+    }
+    return true;
+}
+
+static_assert(isSorted(RANGES, sizeof(RANGES) / sizeof(RANGES[0])), "RANGES must be sorted and not overlapping");
+
+quint8 otherClass(char16_t c)
+{
+    size_t low = 0;
+    size_t high = sizeof(RANGES) / sizeof(RANGES[0]);
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        if (c > RANGES[middle].last)
+            low = middle + 1;
+        else if (c < RANGES[middle].first)
+            high = middle;
+        else
+            return RANGES[middle].cls;
+    }
+
+    const QChar qc(c);
+    if (qc.isLetterOrNumber() || qc.isMark())
+        return Word;
+    if (qc.isSpace())
+        return Space;
+    return Other;
+}
+
+inline quint8 classOf(char16_t c)
+{
+    return c < 256 ? LATIN1.cls[c] : otherClass(c);
+}
+
+inline bool isWordChar(quint8 cls)
+{
+    return cls & (Word | Ideograph);
+}
+
+// SWAR (SIMD within a register) helpers: 4 UTF-16 characters in a 64-bit word
+constexpr quint64 LANES_ONE = 0x0001000100010001ULL;
+constexpr quint64 LANES_HIGH = 0x8000800080008000ULL;
+constexpr quint64 LANES_NON_ASCII = 0xFF80FF80FF80FF80ULL;
+
+inline bool hasZeroLane(quint64 v)
+{
+    return ((v - LANES_ONE) & ~v & LANES_HIGH) != 0;
+}
+
+inline bool hasLane(quint64 v, char16_t c)
+{
+    return hasZeroLane(v ^ (LANES_ONE * c));
+}
+
+// Fast path for ASCII text: returns true if none of the 4 characters at the given
+// position can end a sentence, so they can be skipped without classifying them
+inline bool isAsciiWithoutEnd(const void *data, bool isGreek)
+{
+    quint64 chunk;
+    std::memcpy(&chunk, data, sizeof(chunk));
+    if (chunk & LANES_NON_ASCII)
+        return false;
+    if (hasLane(chunk, '.') || hasLane(chunk, '!') || hasLane(chunk, '?'))
+        return false;
+    return !(isGreek && hasLane(chunk, ';'));
+}
+
+// Returns position of the first sentence terminator at or after the given position,
+// or the text size if there is none
+int findSentenceEnd(QStringView text, int from, quint8 endMask)
+{
+    const auto *data = text.utf16();
+    const int size = text.size();
+    const bool isGreek = endMask & GreekQuestion;
+
+    int i = from;
+    while (i < size) {
+        if (i + 4 <= size && isAsciiWithoutEnd(data + i, isGreek)) {
+            i += 4;
+            continue;
+        }
+
+        const int chunkEnd = std::min(i + 4, size);
+        for (; i < chunkEnd; ++i) {
+            if (classOf(data[i]) & endMask)
+                return i;
+        }
+    }
+
+    return size;
+}
+
+}
+
+quint8 charClass(QChar c)
+{
+    return classOf(c.unicode());
+}
+
+quint8 sentenceEndMask(const QString &lang)
+{
+    if (lang == QLatin1String("ell"))
+        return SentenceEnd | GreekQuestion;
+
+    return SentenceEnd;
+}
+
+void scanWords(QStringView text, int from, PositionTable &words)
+{
+    const auto *data = text.utf16();
+    const int size = text.size();
+
+    int nextPos = from;
+    int i = from;
+    while (i < size) {
+        // Skip to the beginning of the word
+        for (; i < size && !isWordChar(classOf(data[i])); ++i) {}
+        if (i == size)
+            break;
+
+        const int start = i;
+        if (classOf(data[i]) & Ideograph) {
+            ++i;
+        } else {
+            for (; i < size && (classOf(data[i]) & Word); ++i) {}
+        }
+
+        words.append(start, i - start);
+        nextPos = i;
+    }
+
+    if (nextPos < size && hasText(text.mid(nextPos)))
+        words.append(nextPos, size - nextPos);
+}
+
+void scanSentences(QStringView text, int from, quint8 endMask, PositionTable &sentences)
+{
+    constexpr int MIN_SENTENCE_LENGTH = 3;
+
+    const int size = text.size();
+
+    int nextPos = from;
+    int runStart = from;
+    while (runStart < size) {
+        const int end = findSentenceEnd(text, runStart, endMask);
+        if (end == size)
+            break;
+
+        if (end - runStart >= MIN_SENTENCE_LENGTH) {
+            sentences.append(runStart, end - runStart + 1);
+            nextPos = end + 1;
+        }
+        runStart = end + 1;
+    }
+
+    if (nextPos < size && hasText(text.mid(nextPos)))
+        sentences.append(nextPos, size - nextPos);
+}
+
+int lastIndexOf(QStringView text, quint8 classMask)
+{
+    const auto *data = text.utf16();
+    for (int i = text.size() - 1; i >= 0; --i) {
+        if (classOf(data[i]) & classMask)
+            return i;
+    }
+
+    return -1;
+}
+
+bool hasText(QStringView text)
+{
+    const auto *data = text.utf16();
+    for (int i = 0; i < text.size(); ++i) {
+        if (!(classOf(data[i]) & (Space | Dash)))
+            return true;
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+#include "positiontable.h"
+
+/*
+ * TextScanner finds words and sentences boundaries without regular expressions.
+ *
+ * Characters are classified by a table generated at compile time for Latin-1
+ * and by a table of ranges for the other scripts of the OCR languages (Greek,
+ * Cyrillic, Hebrew, Arabic, CJK). Letters of the scripts not listed in the
+ * ranges are classified by Qt's Unicode tables.
+ *
+ */
+namespace TextScanner {
+
+enum CharClass : quint8 {
+    Other           = 0,
+    Word            = 1 << 0,   // Letters, digits, marks, underscore and apostrophe
+    Ideograph       = 1 << 1,   // CJK characters, every one of them is a word
+    Space           = 1 << 2,
+    Dash            = 1 << 3,
+    SentenceEnd     = 1 << 4,   // . ! ? and their equivalents in other scripts
+    GreekQuestion   = 1 << 5,   // ';' is a question mark in Greek text
+    ClauseEnd       = 1 << 6,   // , ; : and their equivalents in other scripts
+};
+
+quint8 charClass(QChar c);
+
+// Returns CharClass bits ending a sentence in the given OCR language ("eng", "ell", ...)
+quint8 sentenceEndMask(const QString &lang);
+
+// Appends words found in the text starting from the given position. A trailing
+// fragment without words (punctuation etc.) is appended as a separate item
+void scanWords(QStringView text, int from, PositionTable &words);
+
+// Appends sentences found in the text starting from the given position. Sentence
+// is at least 3 characters followed by a terminator, the trailing fragment
+// without terminator is appended as a separate item
+void scanSentences(QStringView text, int from, quint8 endMask, PositionTable &sentences);
+
+// Returns position of the last character of the given classes or -1 if there is none
+int lastIndexOf(QStringView text, quint8 classMask);
+
+// Returns true if there is anything besides spaces and dashes in the text
+bool hasText(QStringView text);
+
+}
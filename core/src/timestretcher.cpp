@@ -0,0 +1,279 @@
+#include "timestretcher.h"
+
+#include <QElapsedTimer>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr int HOP_MS = 10;           // Frames of 20 ms overlap by half
+static constexpr int SEEK_MS = 6;           // Covers the pitch period of the lowest voices
+static constexpr int MAP_HISTORY_S = 5;     // Audio output reports positions well behind this
+static constexpr double MIN_TEMPO = 0.5;
+static constexpr double MAX_TEMPO = 2.0;
+static constexpr double NATIVE_TEMPO_DELTA = 0.001;
+
+// Independent sums keep the loop free of dependencies, so the compiler vectorizes it
+static float dotProduct(const float *a, const float *b, int count)
+{
+    constexpr int LANES = 8;
+    float sums[LANES] = {};
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane)
+            sums[lane] += a[i + lane] * b[i + lane];
+    }
+    float sum = 0;
+    for (int lane = 0; lane < LANES; ++lane)
+        sum += sums[lane];
+    for (; i < count; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+TimeStretcher::TimeStretcher(int sampleRate)
+    : m_hop(std::max(8, sampleRate * HOP_MS / 1000))
+    , m_seek(std::max(1, sampleRate * SEEK_MS / 1000))
+    , m_rise(m_hop)
+    , m_nativeFrom(std::numeric_limits<qint64>::max())
+    , m_tail(m_hop)
+    , m_mapHistory(static_cast<qint64>(sampleRate) * MAP_HISTORY_S)
+{
+    // Squared sine and cosine halves sum to 1, so overlapped copies of the same signal are unchanged
+    for (int i = 0; i < m_hop; ++i) {
+        const double s = std::sin(M_PI * (i + 0.5) / (2 * m_hop));
+        m_rise[i] = static_cast<float>(s * s);
+    }
+}
+
+void TimeStretcher::setTempo(double tempo)
+{
+    m_tempo = std::min(MAX_TEMPO, std::max(MIN_TEMPO, tempo));
+    m_nativeFrom = std::numeric_limits<qint64>::max();
+}
+
+double TimeStretcher::tempo() const
+{
+    return m_tempo;
+}
+
+void TimeStretcher::setNativeFrom(qint64 sourcePos)
+{
+    m_nativeFrom = sourcePos;
+}
+
+void TimeStretcher::reset()
+{
+    m_tempo = 1;
+    m_nativeFrom = std::numeric_limits<qint64>::max();
+    m_input.clear();
+    m_inputPos = 0;
+    m_sourcePos = 0;
+    m_isStretching = false;
+    m_output.clear();
+    m_outputRead = 0;
+    m_producedPos = 0;
+    m_outputPos = 0;
+    m_map.clear();
+    m_stats = {};
+}
+
+void TimeStretcher::push(const qint16 *samples, int count)
+{
+    m_input.insert(m_input.end(), samples, samples + count);
+}
+
+int TimeStretcher::pull(qint16 *samples, int maxCount)
+{
+    int count = 0;
+    while (count < maxCount) {
+        if (m_outputRead == m_output.size()) {
+            m_output.clear();
+            m_outputRead = 0;
+            if (!produce())
+                break;
+        }
+        const int chunk = static_cast<int>(std::min<size_t>(maxCount - count, m_output.size() - m_outputRead));
+        std::copy_n(m_output.begin() + m_outputRead, chunk, samples + count);
+        m_outputRead += chunk;
+        count += chunk;
+    }
+    m_outputPos += count;
+
+    // Keep the part of the map the audio output may still ask about
+    while (m_map.size() > 1 && m_map[1].output <= m_outputPos - m_mapHistory)
+        m_map.pop_front();
+    return count;
+}
+
+qint64 TimeStretcher::outputPosition() const
+{
+    return m_outputPos;
+}
+
+template<typename Points>
+static qint64 mapToSource(const Points &points, double slope, qint64 outputPos)
+{
+    if (points.empty())
+        return outputPos;
+
+    const auto next = std::upper_bound(points.begin(), points.end(), outputPos,
+                                       [](qint64 pos, const TimeStretcher::MapPoint &point) {
+        return pos < point.output;
+    });
+    if (next == points.begin())
+        return next->source - (next->output - outputPos);
+    const auto &point = *(next - 1);
+    if (next == points.end())
+        return point.source + std::llround((outputPos - point.output) * slope);
+    return point.source + (outputPos - point.output) * (next->source - point.source) / (next->output - point.output);
+}
+
+qint64 TimeStretcher::sourcePosition(qint64 outputPos) const
+{
+    return mapToSource(m_map, m_isStretching ? m_tempo : 1, outputPos);
+}
+
+void TimeStretcher::copyPositionMap(PositionMap &map) const
+{
+    map.points.assign(m_map.begin(), m_map.end());
+    map.slope = m_isStretching ? m_tempo : 1;
+}
+
+qint64 TimeStretcher::PositionMap::sourcePosition(qint64 outputPos) const
+{
+    return mapToSource(points, slope, outputPos);
+}
+
+TimeStretcher::Stats TimeStretcher::stats() const
+{
+    return m_stats;
+}
+
+bool TimeStretcher::isStretchWanted(double sourcePos) const
+{
+    return std::abs(m_tempo - 1) > NATIVE_TEMPO_DELTA && sourcePos < m_nativeFrom;
+}
+
+// Queues the next output samples, returns false when more input is needed
+bool TimeStretcher::produce()
+{
+    if (m_isStretching)
+        return produceFrame();
+
+    if (isStretchWanted(m_sourcePos)) {
+        if (inputEnd() < m_sourcePos + m_hop)
+            return false;
+        // The source before this position is the first frame, its second half fades out
+        // while the next frame fades in
+        const float *input = inputAt(m_sourcePos);
+        for (int i = 0; i < m_hop; ++i)
+            m_tail[i] = (1 - m_rise[i]) * input[i];
+        m_frame = m_sourcePos - m_hop;
+        m_nominal = static_cast<double>(m_frame);
+        m_isStretching = true;
+        addMapPoint(m_sourcePos);
+        return produceFrame();
+    }
+
+    const qint64 count = inputEnd() - m_sourcePos;
+    if (count <= 0)
+        return false;
+    const float *input = inputAt(m_sourcePos);
+    m_output.assign(input, input + count);
+    m_sourcePos += count;
+    m_producedPos += count;
+    // History lets the stretch search before the position where it starts
+    dropInput(m_sourcePos - m_hop - m_seek);
+    return true;
+}
+
+bool TimeStretcher::produceFrame()
+{
+    const double nominal = m_nominal + m_hop * m_tempo;
+    const qint64 continuation = m_frame + m_hop;
+    if (!isStretchWanted(nominal)) {
+        // The tail fades out the source that continues right after it, so the plain source follows
+        m_isStretching = false;
+        m_sourcePos = continuation;
+        m_nativeFrom = std::min(m_nativeFrom, m_sourcePos);
+        addMapPoint(m_sourcePos);
+        return produce();
+    }
+
+    const qint64 first = std::max<qint64>(m_inputPos, std::llround(nominal) - m_seek);
+    const qint64 last = std::llround(nominal) + m_seek;
+    if (inputEnd() < std::max(last, continuation) + 2 * m_hop)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_frame = bestFrame(first, last, inputAt(continuation));
+    const float *frame = inputAt(m_frame);
+    m_output.resize(m_hop);
+    for (int i = 0; i < m_hop; ++i) {
+        const float sample = m_tail[i] + m_rise[i] * frame[i];
+        m_output[i] = static_cast<qint16>(std::lrint(std::min(32767.0f, std::max(-32768.0f, sample))));
+        m_tail[i] = (1 - m_rise[i]) * frame[m_hop + i];
+    }
+    addMapPoint(std::llround(m_nominal) + m_hop);
+    m_nominal = nominal;
+    m_producedPos += m_hop;
+    dropInput(std::min<qint64>(m_frame + m_hop, std::llround(m_nominal + m_hop * MIN_TEMPO) - m_seek));
+
+    m_stats.stretchedSamples += m_hop;
+    m_stats.stretchNs += timer.nsecsElapsed();
+    return true;
+}
+
+// Frame whose beginning is the most similar to the natural continuation of the last frame
+qint64 TimeStretcher::bestFrame(qint64 first, qint64 last, const float *reference) const
+{
+    const float *input = inputAt(first);
+    float energy = dotProduct(input, input, m_hop);
+    float bestScore = -std::numeric_limits<float>::max();
+    qint64 best = first;
+    for (qint64 pos = first; pos <= last; ++pos) {
+        const float *frame = inputAt(pos);
+        const float correlation = dotProduct(reference, frame, m_hop);
+        // Normalized by the frame energy only, the reference energy is the same for all frames
+        const float score = correlation / std::sqrt(std::max(energy, 1.0f));
+        if (score > bestScore) {
+            bestScore = score;
+            best = pos;
+        }
+        energy += frame[m_hop] * frame[m_hop] - frame[0] * frame[0];
+    }
+    return best;
+}
+
+const float *TimeStretcher::inputAt(qint64 sourcePos) const
+{
+    return m_input.data() + (sourcePos - m_inputPos);
+}
+
+qint64 TimeStretcher::inputEnd() const
+{
+    return m_inputPos + static_cast<qint64>(m_input.size());
+}
+
+void TimeStretcher::dropInput(qint64 sourcePos)
+{
+    const qint64 count = std::min(sourcePos, inputEnd()) - m_inputPos;
+    if (count <= 0)
+        return;
+    m_input.erase(m_input.begin(), m_input.begin() + count);
+    m_inputPos += count;
+}
+
+void TimeStretcher::addMapPoint(qint64 sourcePos)
+{
+    // Frames may start a little before the nominal position, the reported position doesn't go back
+    if (!m_map.empty())
+        sourcePos = std::max(sourcePos, m_map.back().source);
+    if (!m_map.empty() && m_map.back().output == m_producedPos)
+        m_map.back().source = sourcePos;
+    else
+        m_map.push_back({m_producedPos, sourcePos});
+}
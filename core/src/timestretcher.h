@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QtGlobal>
+#include <deque>
+#include <vector>
+
+/*
+ * TimeStretcher changes the tempo of 16-bit mono PCM without changing its pitch
+ * (WSOLA). Frames of the source are overlap-added at a fixed output hop, each one
+ * taken near its nominal source position where its waveform continues the previous
+ * frame best.
+ *
+ * At tempo 1 the samples are passed through. Output positions are mapped back to
+ * the source ones, so the sample marks of the source follow the stretched playback.
+ *
+ */
+class TimeStretcher
+{
+public:
+    struct Stats {
+        qint64  stretchedSamples {0};   // Output samples made of overlapped frames
+        qint64  stretchNs {0};          // Time spent making them
+    };
+    struct MapPoint {
+        qint64  output;
+        qint64  source;
+    };
+    // Copy of the position mapping, for the threads that don't own the stretcher
+    struct PositionMap {
+        std::vector<MapPoint>   points;
+        double                  slope {1};  // Past the last point
+        qint64 sourcePosition(qint64 outputPos) const;
+    };
+
+    explicit TimeStretcher(int sampleRate);
+
+    // Tempo above 1 plays faster. It's applied from the next frame to all the source,
+    // till setNativeFrom() limits it
+    void setTempo(double tempo);
+    double tempo() const;
+    // Source from this position on is played at tempo 1, whatever the tempo
+    void setNativeFrom(qint64 sourcePos);
+    // Drops all samples and stats, positions start from 0 at tempo 1
+    void reset();
+
+    void push(const qint16 *samples, int count);
+    // Returns less than maxCount samples when more source is needed
+    int pull(qint16 *samples, int maxCount);
+
+    qint64 outputPosition() const;
+    qint64 sourcePosition(qint64 outputPos) const;
+    // Reuses the memory of the map, so the copies don't allocate once it's grown
+    void copyPositionMap(PositionMap &map) const;
+    Stats stats() const;
+
+private:
+    bool isStretchWanted(double sourcePos) const;
+    bool produce();
+    bool produceFrame();
+    qint64 bestFrame(qint64 first, qint64 last, const float *reference) const;
+    const float *inputAt(qint64 sourcePos) const;
+    qint64 inputEnd() const;
+    void dropInput(qint64 sourcePos);
+    void addMapPoint(qint64 sourcePos);
+
+private:
+    const int           m_hop;          // Output hop, half of the frame
+    const int           m_seek;         // Frame search range around the nominal position
+    std::vector<float>  m_rise;         // Rising half of the window, the falling one is 1 - rise
+    double              m_tempo {1};
+    qint64              m_nativeFrom;
+
+    std::vector<float>  m_input;
+    qint64              m_inputPos {0};     // Source position of m_input[0]
+    qint64              m_sourcePos {0};    // Next source sample to pass through
+
+    bool                m_isStretching {false};
+    qint64              m_frame {0};        // Source position of the last frame
+    double              m_nominal {0};      // Its nominal position
+    std::vector<float>  m_tail;             // Faded second half of the last frame
+
+    std::vector<qint16> m_output;
+    size_t              m_outputRead {0};
+    qint64              m_producedPos {0};
+    qint64              m_outputPos {0};
+
+    const qint64        m_mapHistory;
+    std::deque<MapPoint> m_map;         // Output positions where the frames started
+    Stats               m_stats;
+};
@@ -45,3 +45,9 @@ string Translator::GetString(const string & sTag) const {
     return j->second;
 }
 
+vector<string> Translator::GetStrings() const {
+    vector<string> vStrings;
+    for(const_iterator i = begin(); i != end(); ++i)
+        vStrings.push_back(GetString(i->first));
+    return vStrings;
+}
@@ -3,9 +3,353 @@
 #include <QAudioDeviceInfo>
 #include <QDebug>
 #include "zyrlotts.h"
-#include <lame/lame.h>
+#include "pcmringbuffer.h"
+#include "timestretcher.h"
+#include "soundmixer.h"
+#include "snapshotbuffer.h"
+#include "spscqueue.h"
+#include <QFile>
+#include <QMutex>
+#include <algorithm>
+#include <array>
+#include <limits>
+
+static constexpr int SAMPLE_RATE = 22050;
+static constexpr qint64 RING_BUFFER_SIZE = 128 * 1024;  // About 3 seconds of 22kHz 16-bit mono
+static constexpr int START_THRESHOLD_POLL_MS = 5;
+static constexpr int STRETCH_CHUNK_SAMPLES = 1024;
+static constexpr unsigned EARCON_QUEUE_SIZE = 16;
+
+// Reads the ring buffer through the time stretcher, which passes the samples through at tempo 1.
+// The playback thread doesn't wait for the other threads: the control is applied at the next read
+// and the position map is published after each one
+class StretchedAudio : public QIODevice
+{
+public:
+    StretchedAudio(PcmRingBuffer *source, int sampleRate, QObject *parent)
+        : QIODevice(parent)
+        , m_source(source)
+        , m_stretcher(sampleRate)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    void setTempo(double tempo) {
+        QMutexLocker locker(&m_controlMutex);
+        m_control.tempo = tempo;
+        m_control.nativeFrom = std::numeric_limits<qint64>::max();
+        publishControl();
+    }
+
+    void setNativeFrom(qint64 sourcePos) {
+        QMutexLocker locker(&m_controlMutex);
+        m_control.nativeFrom = sourcePos;
+        publishControl();
+    }
+
+    // Positions start from 0 at once, the stretcher drops its samples with the next read
+    void clearStream() {
+        unsigned resets = 0;
+        {
+            QMutexLocker locker(&m_controlMutex);
+            m_control = Control {m_control.resets + 1};
+            resets = m_control.resets;
+            publishControl();
+        }
+        QMutexLocker locker(&m_snapshotMutex);
+        m_readerResets = resets;
+    }
+
+    qint64 sourcePosition(qint64 outputPos) const {
+        QMutexLocker locker(&m_snapshotMutex);
+        return latestSnapshot().map.sourcePosition(outputPos);
+    }
+
+    TimeStretcher::Stats stats() const {
+        QMutexLocker locker(&m_snapshotMutex);
+        return latestSnapshot().stats;
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_source->bytesAvailable() + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        applyControl();
+        auto samples = reinterpret_cast<qint16 *>(data);
+        const int maxCount = static_cast<int>(maxSize / sizeof(qint16));
+        int count = m_stretcher.pull(samples, maxCount);
+        while (count < maxCount) {
+            const qint64 size = m_source->read(reinterpret_cast<char *>(m_chunk), sizeof(m_chunk));
+            if (size <= 0)
+                break;
+            m_stretcher.push(m_chunk, static_cast<int>(size / sizeof(qint16)));
+            count += m_stretcher.pull(samples + count, maxCount - count);
+        }
+
+        auto &snapshot = m_snapshots.back();
+        snapshot.resets = m_resets;
+        m_stretcher.copyPositionMap(snapshot.map);
+        snapshot.stats = m_stretcher.stats();
+        m_snapshots.publish();
+        return count * static_cast<qint64>(sizeof(qint16));
+    }
+
+    qint64 writeData(const char *, qint64) override {
+        return -1;
+    }
+
+private:
+    // State the other threads want, the playback thread applies the latest one
+    struct Control {
+        unsigned    resets {0};
+        double      tempo {1};
+        qint64      nativeFrom {std::numeric_limits<qint64>::max()};
+    };
+    struct Snapshot {
+        unsigned                    resets {0};
+        TimeStretcher::PositionMap  map;
+        TimeStretcher::Stats        stats;
+    };
+
+    void publishControl() {
+        m_controls.back() = m_control;
+        m_controls.publish();
+    }
+
+    // The tempo resets the native position, which is set again
+    void applyControl() {
+        const auto &control = m_controls.latest();
+        if (control.resets != m_resets) {
+            m_stretcher.reset();
+            m_resets = control.resets;
+        }
+        m_stretcher.setTempo(control.tempo);
+        m_stretcher.setNativeFrom(control.nativeFrom);
+    }
+
+    // Till the playback thread reads after the reset, positions are mapped as by a reset stretcher
+    const Snapshot &latestSnapshot() const {
+        const auto &snapshot = m_snapshots.latest();
+        return snapshot.resets == m_readerResets ? snapshot : m_emptySnapshot;
+    }
+
+private:
+    PcmRingBuffer *m_source;
+    TimeStretcher m_stretcher;
+    qint16 m_chunk[STRETCH_CHUNK_SAMPLES];
+    unsigned m_resets {0};      // Accessed by the playback thread only
+
+    QMutex m_controlMutex;      // Serializes the threads that control the playback, never taken by it
+    Control m_control;
+    SnapshotBuffer<Control> m_controls;
+
+    mutable QMutex m_snapshotMutex;     // Serializes the threads that read the positions
+    mutable SnapshotBuffer<Snapshot> m_snapshots;
+    unsigned m_readerResets {0};
+    const Snapshot m_emptySnapshot {};
+};
+
+// Mixes the earcons into the speech, the speech is read only while it plays. As with the stretched
+// audio, the playback thread doesn't wait: the control and the earcons are taken at the next read
+// and the speech positions are published after each one
+class MixedAudio : public QIODevice
+{
+public:
+    MixedAudio(int sampleRate, QObject *parent)
+        : QIODevice(parent)
+        , m_mixer(sampleRate)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    // Speech positions count from the speech set, nullptr removes it
+    void setSpeech(QIODevice *speech) {
+        QMutexLocker locker(&m_mutex);
+        m_control.speech = speech;
+        m_control.isSpeechPaused = false;
+        if(speech)
+            ++m_control.speechResets;
+        publishControl();
+    }
+
+    void setSpeechPaused(bool isPaused) {
+        QMutexLocker locker(&m_mutex);
+        m_control.isSpeechPaused = isPaused;
+        publishControl();
+    }
+
+    void restart(int tailSamples) {
+        QMutexLocker locker(&m_mutex);
+        ++m_control.restarts;
+        m_control.tailSamples = tailSamples;
+        publishControl();
+    }
+
+    void play(const SoundMixer::Sound &sound) {
+        QMutexLocker locker(&m_mutex);
+        if(!m_sounds.push(sound)) {
+            qWarning() << "Earcon queue is full, the earcon is dropped";
+            return;
+        }
+        ++m_plays;
+    }
+
+    void startRepeating(const SoundMixer::Sound &sound, int delayMs, int intervalMs) {
+        QMutexLocker locker(&m_mutex);
+        m_control.repeated = sound;
+        m_control.repeatDelayMs = delayMs;
+        m_control.repeatIntervalMs = intervalMs;
+        ++m_control.repeats;
+        publishControl();
+    }
+
+    void stopRepeating() {
+        QMutexLocker locker(&m_mutex);
+        m_control.repeated.reset();
+        ++m_control.repeats;
+        publishControl();
+    }
+
+    // Earcons not taken by the playback thread yet play too
+    bool isPlaying() const {
+        QMutexLocker locker(&m_mutex);
+        const auto &snapshot = m_snapshots.latest();
+        return snapshot.isPlaying || snapshot.plays != m_plays || m_control.repeated;
+    }
+
+    // Till the playback thread reads after the change, positions are mapped as by the changed mixer
+    qint64 speechPosition(qint64 outputPos) const {
+        QMutexLocker locker(&m_mutex);
+        const auto &snapshot = m_snapshots.latest();
+        if(snapshot.speechResets != m_control.speechResets)
+            return 0;
+        if(snapshot.restarts != m_control.restarts)
+            return snapshot.map.speechPos;
+        return snapshot.map.speechPosition(outputPos);
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override {
+        QMutexLocker locker(&m_mutex);
+        const qint64 speech = m_control.speech && !m_control.isSpeechPaused ? m_control.speech->bytesAvailable() : 0;
+        return speech + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        applyControl();
+        SoundMixer::SpeechSource speech;
+        if(m_speech) {
+            speech = [this](qint16 *samples, int maxCount) {
+                return static_cast<int>(m_speech->read(reinterpret_cast<char *>(samples),
+                                                       maxCount * static_cast<qint64>(sizeof(qint16))) / sizeof(qint16));
+            };
+        }
+        const int count = m_mixer.read(reinterpret_cast<qint16 *>(data), static_cast<int>(maxSize / sizeof(qint16)), speech);
+
+        auto &snapshot = m_snapshots.back();
+        snapshot.speechResets = m_applied.speechResets;
+        snapshot.restarts = m_applied.restarts;
+        snapshot.plays = m_appliedPlays;
+        snapshot.isPlaying = m_mixer.isPlaying();
+        m_mixer.copySpeechMap(snapshot.map);
+        m_snapshots.publish();
+        return count * static_cast<qint64>(sizeof(qint16));
+    }
+
+    qint64 writeData(const char *, qint64) override {
+        return -1;
+    }
+
+private:
+    // State the other threads want, the counters tell the playback thread what to apply again
+    struct Control {
+        QIODevice               *speech {nullptr};
+        bool                    isSpeechPaused {false};
+        unsigned                speechResets {0};
+        unsigned                restarts {0};
+        int                     tailSamples {0};
+        SoundMixer::Sound       repeated;
+        int                     repeatDelayMs {0};
+        int                     repeatIntervalMs {0};
+        unsigned                repeats {0};
+    };
+    struct Applied {
+        unsigned    speechResets {0};
+        unsigned    restarts {0};
+        unsigned    repeats {0};
+    };
+    struct Snapshot {
+        unsigned                speechResets {0};
+        unsigned                restarts {0};
+        unsigned                plays {0};
+        bool                    isPlaying {false};
+        SoundMixer::SpeechMap   map;
+    };
+
+    void publishControl() {
+        m_controls.back() = m_control;
+        m_controls.publish();
+    }
+
+    // The restart goes first, so the earcons requested after it start at the new clock
+    void applyControl() {
+        const auto &control = m_controls.latest();
+        if(control.restarts != m_applied.restarts) {
+            m_mixer.setTail(control.tailSamples);
+            m_mixer.restart();
+        }
+        if(control.repeats != m_applied.repeats) {
+            if(control.repeated)
+                m_mixer.startRepeating(control.repeated, control.repeatDelayMs, control.repeatIntervalMs);
+            else
+                m_mixer.stopRepeating();
+        }
+        if(control.speechResets != m_applied.speechResets)
+            m_mixer.resetSpeech();
+        m_applied = {control.speechResets, control.restarts, control.repeats};
+        m_speech = control.isSpeechPaused ? nullptr : control.speech;
+
+        SoundMixer::Sound sound;
+        while(m_sounds.pop(sound)) {
+            m_mixer.play(sound);
+            ++m_appliedPlays;
+        }
+    }
+
+private:
+    SoundMixer m_mixer;
+    // Accessed by the playback thread only
+    Applied m_applied;
+    unsigned m_appliedPlays {0};
+    QIODevice *m_speech {nullptr};
+
+    mutable QMutex m_mutex;     // Serializes the other threads, never taken by the playback thread
+    Control m_control;
+    SnapshotBuffer<Control> m_controls;
+    SpscQueue<SoundMixer::Sound, EARCON_QUEUE_SIZE> m_sounds;
+    unsigned m_plays {0};
+    mutable SnapshotBuffer<Snapshot> m_snapshots;
+};
 
 TtsAudioLayer *TtsAudioLayer::m_pTtsAudioLayer = NULL;
+bool TtsAudioLayer::m_isDirectOutput = false;
+AlsaOutput::Config TtsAudioLayer::m_directConfig;
+static std::array<SoundMixer::Sound, static_cast<size_t>(Earcon::Count)> earcons;
+
+static QAudio::State audioState(AlsaOutput::State state) {
+    switch(state) {
+    case AlsaOutput::State::Active:
+        return QAudio::ActiveState;
+    case AlsaOutput::State::Idle:
+        return QAudio::IdleState;
+    case AlsaOutput::State::Suspended:
+        return QAudio::SuspendedState;
+    default:
+        return QAudio::StoppedState;
+    }
+}
 
 TtsAudioLayer *TtsAudioLayer::instance(QObject *parent) {
     if(!m_pTtsAudioLayer) {
@@ -14,7 +358,7 @@ TtsAudioLayer *TtsAudioLayer::instance(QObject *parent) {
          // Setup audioOut
         QAudioFormat format;
         // Set up the format, eg.
-        format.setSampleRate(22050);
+        format.setSampleRate(SAMPLE_RATE);
         format.setChannelCount(1);
         format.setSampleSize(16);
         format.setCodec("audio/pcm");
@@ -38,34 +382,398 @@ TtsAudioLayer::TtsAudioLayer(const QAudioFormat &format, QObject *parent)
     : QAudioOutput(format, parent)
 {
     setBufferSize(4096 * 4); // Give some buffer to remove stutter
-    setNotifyInterval(50);
-    m_audioIO = new QBuffer(this);
-    m_audioIO->open(QIODevice::ReadOnly);
+    setNotifyPeriod(50);
+    m_audioIO = new PcmRingBuffer(RING_BUFFER_SIZE, this);
+    // The stretcher and the mixer work on 16-bit mono only, other formats play the speech alone
+    // at the native tempo
+    if(format.sampleSize() == 16 && format.channelCount() == 1 && format.sampleType() == QAudioFormat::SignedInt) {
+        m_stretchedIO = new StretchedAudio(m_audioIO, format.sampleRate(), this);
+        if(format.sampleRate() == SAMPLE_RATE)
+            m_mixedIO = new MixedAudio(format.sampleRate(), this);
+    }
+
+    // QAudioOutput is the fallback when the device is taken or the format isn't 16-bit
+    if(m_isDirectOutput && format.sampleSize() == 16 && format.sampleType() == QAudioFormat::SignedInt) {
+        m_alsa = new AlsaOutput(m_directConfig, format.sampleRate(), format.channelCount());
+        if(!m_alsa->open()) {
+            qWarning() << "Direct audio output is not available, using QAudioOutput";
+            delete m_alsa;
+            m_alsa = nullptr;
+        }
+    }
+    if(m_alsa) {
+        m_alsa->setStateHandler([this](AlsaOutput::State state) {
+            const int run = m_alsaRun;
+            QMetaObject::invokeMethod(this, [this, run, state]() {
+                if(run != m_alsaRun)
+                    return;
+                if(state == AlsaOutput::State::Error)
+                    m_alsaError = QAudio::IOError;
+                setAlsaState(audioState(state));
+            }, Qt::QueuedConnection);
+        });
+    }
+    m_notifyTimer.setInterval(notifyInterval());
+    connect(&m_notifyTimer, &QTimer::timeout, this, &QAudioOutput::notify);
+    connect(this, &QAudioOutput::notify, this, &TtsAudioLayer::measureRequestLatency);
+    connect(this, &QAudioOutput::stateChanged, this, &TtsAudioLayer::onDeviceStateChanged);
 
     m_speakingStartTimer.setSingleShot(true);
-    connect(&m_speakingStartTimer, &QTimer::timeout, this, [this](){
-            start(m_audioIO);
+    connect(&m_speakingStartTimer, &QTimer::timeout, this, &TtsAudioLayer::startWhenBuffered);
+
+    m_startThresholdTimer.setInterval(START_THRESHOLD_POLL_MS);
+    connect(&m_startThresholdTimer, &QTimer::timeout, this, &TtsAudioLayer::startWhenBuffered);
+}
+
+// Jitter buffer: starting with a few buffered milliseconds keeps the first
+// chunks of synthesis from underrunning the audio device
+void TtsAudioLayer::startWhenBuffered() {
+    const qint64 threshold = format().bytesForDuration(m_startThresholdMs * 1000);
+    if(m_audioIO->fill() < threshold && !m_audioIO->isFinished()) {
+        if(!m_startThresholdTimer.isActive())
+            m_startThresholdTimer.start();
+        return;
+    }
+    m_startThresholdTimer.stop();
+    m_isRequestStarted = m_requestTimer.isValid();
+    m_isSpeechStarted = true;
+    m_isSpeechSuspended = false;
+    if(m_mixedIO)
+        m_mixedIO->setSpeech(speechSource());
+    runDevice();
+    updateSpeechState();
+}
+
+QIODevice *TtsAudioLayer::speechSource() const {
+    return m_stretchedIO ? static_cast<QIODevice *>(m_stretchedIO) : m_audioIO;
+}
+
+QAudio::State TtsAudioLayer::deviceState() const {
+    return m_alsa ? m_alsaState.load() : state();
+}
+
+// Earcons are followed by the silence of the device buffer, as the speech by finishSamples()
+void TtsAudioLayer::startDevice() {
+    if(m_mixedIO)
+        m_mixedIO->restart(outputBufferSize() / format().bytesPerFrame());
+    if(m_alsa)
+        startDirect();
+    else
+        start(m_mixedIO ? static_cast<QIODevice *>(m_mixedIO) : speechSource());
+}
+
+void TtsAudioLayer::stopDevice() {
+    if(m_alsa) {
+        m_alsa->stop();
+        ++m_alsaRun;
+        setAlsaState(QAudio::StoppedState);
+    } else {
+        stop();
+    }
+}
+
+void TtsAudioLayer::suspendDevice() {
+    if(!m_alsa) {
+        suspend();
+        return;
+    }
+    m_alsa->suspend();
+    if(m_alsa->state() == AlsaOutput::State::Suspended)
+        setAlsaState(QAudio::SuspendedState);
+}
+
+void TtsAudioLayer::resumeDevice() {
+    if(!m_alsa) {
+        resume();
+        return;
+    }
+    m_alsa->resume();
+    if(m_alsa->state() == AlsaOutput::State::Active)
+        setAlsaState(QAudio::ActiveState);
+}
+
+// Device suspended with the speech is resumed for the speech. An earcon played during the pause
+// restarts it, so the buffered speech isn't heard with it
+void TtsAudioLayer::runDevice() {
+    switch(deviceState()) {
+    case QAudio::StoppedState:
+        startDevice();
+        break;
+    case QAudio::SuspendedState:
+        if(m_isSpeechSuspended) {
+            stopDevice();
+            startDevice();
+        } else {
+            resumeDevice();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TtsAudioLayer::startDirect() {
+    QIODevice *source = m_mixedIO ? static_cast<QIODevice *>(m_mixedIO) : speechSource();
+    m_alsa->stop();
+    ++m_alsaRun;
+    m_alsaError = QAudio::NoError;
+    m_alsa->start([source](char *data, qint64 maxSize) {
+        return source->read(data, maxSize);
     });
+    setAlsaState(QAudio::ActiveState);
+}
+
+void TtsAudioLayer::setAlsaState(QAudio::State state) {
+    if(state == m_alsaState)
+        return;
+    m_alsaState = state;
+    if(state == QAudio::ActiveState)
+        m_notifyTimer.start();
+    else
+        m_notifyTimer.stop();
+    emit stateChanged(state);
+}
+
+// Device is stopped when it ran dry of both the speech and the earcons. Speech running dry is
+// left to ZyrloTts, which stops it when the synthesis is finished
+void TtsAudioLayer::onDeviceStateChanged(QAudio::State state) {
+    const bool isSpeechPlaying = m_isSpeechStarted && !m_isSpeechSuspended;
+    if(state == QAudio::IdleState && !isSpeechPlaying && !(m_mixedIO && m_mixedIO->isPlaying()))
+        stopDevice();
+    updateSpeechState();
+    updateBusy();
+}
+
+// Stopping the device above changes the state again, so the latest one is taken
+void TtsAudioLayer::updateBusy() {
+    const QAudio::State state = deviceState();
+    const bool isBusy = state == QAudio::ActiveState || state == QAudio::IdleState;
+    if(isBusy == m_isBusy)
+        return;
+    m_isBusy = isBusy;
+    emit busyChanged(isBusy);
+}
+
+void TtsAudioLayer::updateSpeechState() {
+    QAudio::State state = QAudio::StoppedState;
+    if(m_isSpeechStarted)
+        state = m_isSpeechSuspended ? QAudio::SuspendedState : deviceState();
+    if(state == m_speechState)
+        return;
+    m_speechState = state;
+    emit speechStateChanged(state);
+}
+
+// The sound started as long ago as the output has played, so the notify interval doesn't add to it
+void TtsAudioLayer::measureRequestLatency() {
+    if(!m_isRequestStarted)
+        return;
+    const qint64 playedMs = playedSamples() * 1000 / format().sampleRate();
+    if(playedMs <= 0)
+        return;
+    const qint64 latencyMs = m_requestTimer.elapsed() - playedMs;
+    m_isRequestStarted = false;
+    m_requestTimer.invalidate();
+    ++m_requestCount;
+    m_requestLatencyTotalMs += latencyMs;
+    m_requestLatencyMaxMs = std::max(m_requestLatencyMaxMs, latencyMs);
+    qInfo() << "Request to sound" << latencyMs << "ms through" << (m_alsa ? "ALSA" : "QAudioOutput")
+            << "avg" << m_requestLatencyTotalMs / m_requestCount << "max" << m_requestLatencyMaxMs << "ms";
+}
+
+bool TtsAudioLayer::setDirectOutput(bool isDirect, const AlsaOutput::Config &config) {
+    const bool isChanged = isDirect != m_isDirectOutput
+            || (isDirect && (config.device != m_directConfig.device || config.periodUs != m_directConfig.periodUs
+                             || config.bufferUs != m_directConfig.bufferUs
+                             || config.priority != m_directConfig.priority));
+    m_isDirectOutput = isDirect;
+    m_directConfig = config;
+    return isChanged;
+}
+
+bool TtsAudioLayer::isDirect() const {
+    return m_alsa != nullptr;
+}
+
+bool TtsAudioLayer::loadEarcon(Earcon earcon, const QString &fileName) {
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Can't open earcon" << fileName;
+        return false;
+    }
+    const auto sound = SoundMixer::decodeWav(file.readAll(), SAMPLE_RATE);
+    if(!sound) {
+        qWarning() << "Earcon" << fileName << "isn't 8 or 16-bit PCM WAV";
+        return false;
+    }
+    earcons[static_cast<size_t>(earcon)] = sound;
+    return true;
+}
+
+QAudio::State TtsAudioLayer::speechState() const {
+    return m_speechState;
+}
+
+QAudio::Error TtsAudioLayer::outputError() const {
+    return m_alsa ? m_alsaError : error();
+}
+
+// Earcons keep playing while the speech is paused
+void TtsAudioLayer::suspendSpeech() {
+    if(!m_isSpeechStarted || m_isSpeechSuspended)
+        return;
+    m_isSpeechSuspended = true;
+    if(m_mixedIO)
+        m_mixedIO->setSpeechPaused(true);
+    if(!m_mixedIO || !m_mixedIO->isPlaying())
+        suspendDevice();
+    updateSpeechState();
+}
+
+void TtsAudioLayer::resumeSpeech() {
+    if(!m_isSpeechSuspended)
+        return;
+    m_isSpeechSuspended = false;
+    if(m_mixedIO)
+        m_mixedIO->setSpeechPaused(false);
+    runDevice();
+    updateSpeechState();
+}
+
+qint64 TtsAudioLayer::playedUSecs() const {
+    if(!m_alsa)
+        return processedUSecs();
+    return m_alsa->playedFrames() * 1'000'000 / format().sampleRate();
+}
+
+int TtsAudioLayer::outputBufferSize() const {
+    if(!m_alsa)
+        return bufferSize();
+    return m_alsa->bufferFrames() * format().bytesPerFrame();
+}
+
+void TtsAudioLayer::setNotifyPeriod(int ms) {
+    setNotifyInterval(ms);
+    m_notifyTimer.setInterval(ms);
+}
+
+bool TtsAudioLayer::isStartPending() const {
+    return m_speakingStartTimer.isActive() || m_startThresholdTimer.isActive();
 }
 
 void TtsAudioLayer::clear() {
-    m_audioIO->buffer().clear();
-    m_audioIO->reset();
+    m_audioIO->clearStream();
+    if(m_stretchedIO)
+        m_stretchedIO->clearStream();
 }
 
 void TtsAudioLayer::startTimer(int delayMs) {\
-    if(m_bOutputToFile)
-        return;
     m_speakingStartTimer.start(delayMs);
 }
 
-void TtsAudioLayer::stop() {
+void TtsAudioLayer::stopSpeech() {
     m_speakingStartTimer.stop();
-    QAudioOutput::stop();
+    m_startThresholdTimer.stop();
+    // Stopping drops the speech queued in the device, the earcons still playing start it again.
+    // Earcons played alone aren't touched
+    if(m_isSpeechStarted || !m_mixedIO) {
+        m_isSpeechStarted = false;
+        m_isSpeechSuspended = false;
+        if(m_mixedIO)
+            m_mixedIO->setSpeech(nullptr);
+        stopDevice();
+        if(m_mixedIO && m_mixedIO->isPlaying())
+            startDevice();
+        updateSpeechState();
+    }
+    // Release the synthesis thread if it waits for free space
+    m_audioIO->abort();
+    if(m_audioIO->underruns() > 0)
+        qDebug() << "Audio underruns" << m_audioIO->underruns() << "peak buffer fill" << m_audioIO->peakFill();
+    if(m_alsa && m_alsa->underruns() > 0)
+        qDebug() << "ALSA device underruns" << m_alsa->underruns();
+    const auto stats = m_stretchedIO ? m_stretchedIO->stats() : TimeStretcher::Stats();
+    if(stats.stretchedSamples > 0)
+        qDebug() << "Time stretch of" << stats.stretchedSamples * 1000 / format().sampleRate() << "ms of audio took"
+                 << stats.stretchNs / 1000 << "us";
 }
 
 void TtsAudioLayer::appendSample(const char *pSample, size_t size) {
-    m_audioIO->buffer().append(pSample, size);
+    m_audioIO->push(pSample, size);
+}
+
+void TtsAudioLayer::finishSamples() {
+    // The output goes idle as soon as the buffer is empty and then it's stopped, dropping
+    // the samples still queued in the device. Trailing silence lets the speech drain out
+    m_audioIO->finish(outputBufferSize());
+}
+
+void TtsAudioLayer::reopenSamples() {
+    m_audioIO->reopen();
+}
+
+void TtsAudioLayer::setTempo(double tempo) {
+    if(m_stretchedIO)
+        m_stretchedIO->setTempo(tempo);
+}
+
+void TtsAudioLayer::markNativeRate() {
+    // The stretcher counts the drained silence too, as it reads it from the ring buffer
+    if(m_stretchedIO)
+        m_stretchedIO->setNativeFrom((m_audioIO->pushed() + m_audioIO->drainedSilence()) / format().bytesPerFrame());
+}
+
+qint64 TtsAudioLayer::playedSamples() const {
+    qint64 samples = playedUSecs() * format().sampleRate() / 1'000'000;
+    // Output has the earcons played without the speech too
+    if(m_mixedIO)
+        samples = m_mixedIO->speechPosition(samples);
+    // Word marks are in the samples of the synthesis, not the stretched ones
+    if(m_stretchedIO)
+        samples = m_stretchedIO->sourcePosition(samples);
+    return samples - m_audioIO->drainedSilence() / format().bytesPerFrame();
+}
+
+int TtsAudioLayer::underruns() const {
+    return m_audioIO->underruns();
+}
+
+qint64 TtsAudioLayer::bufferFill() const {
+    return m_audioIO->fill();
+}
+
+qint64 TtsAudioLayer::peakBufferFill() const {
+    return m_audioIO->peakFill();
+}
+
+void TtsAudioLayer::markRequest() {
+    m_requestTimer.start();
+    m_isRequestStarted = false;
+}
+
+void TtsAudioLayer::playEarcon(Earcon earcon) {
+    const auto &sound = earcons[static_cast<size_t>(earcon)];
+    if(!m_mixedIO || !sound)
+        return;
+    m_mixedIO->play(sound);
+    runDevice();
+}
+
+void TtsAudioLayer::startRepeating(Earcon earcon, int delayMs, int intervalMs) {
+    const auto &sound = earcons[static_cast<size_t>(earcon)];
+    if(!m_mixedIO || !sound)
+        return;
+    m_mixedIO->startRepeating(sound, delayMs, intervalMs);
+    runDevice();
+}
+
+void TtsAudioLayer::stopRepeating() {
+    if(m_mixedIO)
+        m_mixedIO->stopRepeating();
+}
+
+bool TtsAudioLayer::isBusy() const {
+    return m_isBusy;
 }
 
 TtsAudioLayer *TtsAudioLayer::reset() {
@@ -77,75 +785,14 @@ TtsAudioLayer *TtsAudioLayer::reset() {
 }
 
 TtsAudioLayer::~TtsAudioLayer() {
+    // QAudioOutput reports its state while it's destroyed, after the layer is gone
+    disconnect(this, &QAudioOutput::stateChanged, this, &TtsAudioLayer::onDeviceStateChanged);
+    // Playback thread reads the buffers till it's stopped
+    delete m_alsa;
+    if(m_mixedIO)
+        delete m_mixedIO;
+    if(m_stretchedIO)
+        delete m_stretchedIO;
     if(m_audioIO)
         delete m_audioIO;
 }
-
-void WriteWaveHeader(FILE *fp, int nSampleRate, int nBitsPerSample, int nChannels, int nBuffSize) {
-    fwrite("RIFF", 1, 4, fp);
-    int nBiteRate = nSampleRate * nBitsPerSample / 8 * nChannels;
-    int nSubchunk2Size = nBuffSize;
-    int nChunksize = nSubchunk2Size + 36;
-    fwrite(&nChunksize, 4, 1, fp);
-    fwrite("WAVE", 1, 4, fp);
-    char sTmp[4] = "fmt";
-    sTmp[3] = 0x20;
-    fwrite(sTmp, 1, 4, fp);
-    sTmp[0] = 16;
-    memset(sTmp + 1, 0, 3);
-    fwrite(sTmp, 1, 4, fp);
-    sTmp[0] = 1;
-    sTmp[1] = sTmp[3] = 0;
-    sTmp[2] = nChannels;
-    fwrite(sTmp, 1, 4, fp);
-    fwrite(&nSampleRate, 4 , 1, fp);
-    fwrite(&nBiteRate, 4, 1, fp);
-    sTmp[0] = 4;
-    sTmp[1] = 0;
-    sTmp[2] = nBitsPerSample;
-    sTmp[3] = 0;
-    fwrite(sTmp, 1, 4, fp);
-    fwrite("data", 1, 4, fp);
-    fwrite(&nSubchunk2Size, 4, 1, fp);
-}
-
-bool TtsAudioLayer::writeToWave(const char *sFileName) {
-    int nBuffSize = m_audioIO->buffer().size();
-    if(nBuffSize < 1)
-        return false;
-    FILE *fp = fopen(sFileName, "wb");
-    if(!fp)
-        return false;
-    WriteWaveHeader(fp, 22050, 16, 1, nBuffSize);
-    int nWritten = fwrite(m_audioIO->buffer().constData(), 2, nBuffSize, fp);
-    fclose(fp);
-    return nWritten == nBuffSize;
-}
-
-bool TtsAudioLayer::writeToMp3(const char *sFileName) {
-    int nBuffSize = m_audioIO->buffer().size();
-    if(nBuffSize < 1)
-        return false;
-    FILE *fp = fopen(sFileName, "wb");
-    if(!fp)
-        return false;
-    const int PCM_SIZE = 8192;
-    const int MP3_SIZE = 1.25 * PCM_SIZE * 0.5  + 7200;
-    unsigned char mp3_buffer[MP3_SIZE];
-    lame_t lame = lame_init();
-    lame_set_in_samplerate(lame, 22050);
-    lame_set_VBR(lame, vbr_default);
-    lame_set_mode(lame, MONO);
-    lame_set_num_channels(lame, 1);
-    lame_init_params(lame);
-    int nWritten = 0;
-    for(int i = 0, chunk = std::min(PCM_SIZE, nBuffSize); chunk > 0; nBuffSize -=  PCM_SIZE, chunk = std::min(PCM_SIZE, nBuffSize), ++i) {
-        nWritten = lame_encode_buffer(lame, (short int*)(m_audioIO->buffer().constData() + i * PCM_SIZE), NULL, chunk / 2, mp3_buffer, MP3_SIZE);
-        fwrite(mp3_buffer, nWritten, 1, fp);
-    }
-    nWritten = lame_encode_flush(lame, mp3_buffer, MP3_SIZE);
-    fwrite(mp3_buffer, nWritten, 1, fp);
-    lame_close(lame);
-    fclose(fp);
-    return true;
-}
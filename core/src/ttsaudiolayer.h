@@ -2,33 +2,126 @@
 #define TTSAUDIOLAYER_H
 
 #include <QAudioOutput>
-#include <QBuffer>
 #include <QTimer>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include "alsaoutput.h"
+
+class PcmRingBuffer;
+class StretchedAudio;
+class MixedAudio;
+
+// Short sounds played by the audio layer over the speech
+enum class Earcon { Shutter, Beep, ArmOpen, ArmClosed, Count };
 
 class TtsAudioLayer : public QAudioOutput {
+    Q_OBJECT
+
+    PcmRingBuffer *m_audioIO {nullptr};
+    // Plays m_audioIO at the tempo of the speech rate change, till the synthesis catches up
+    StretchedAudio *m_stretchedIO {nullptr};
+    // Mixes the earcons into the speech. The device plays while there is either of them
+    MixedAudio *m_mixedIO {nullptr};
+    bool m_isSpeechStarted {false};
+    bool m_isSpeechSuspended {false};
+    QAudio::State m_speechState {QAudio::StoppedState};
+    std::atomic<bool> m_isBusy {false};     // Follows the device state, for the other threads
 
-    QBuffer *m_audioIO {nullptr};
+    // Plays the stream instead of QAudioOutput when the direct output is used
+    AlsaOutput *m_alsa {nullptr};
+    std::atomic<QAudio::State> m_alsaState {QAudio::StoppedState};
+    QAudio::Error m_alsaError {QAudio::NoError};
+    std::atomic<int> m_alsaRun {0};     // State changes of the stopped runs are dropped
+    QTimer m_notifyTimer;
 
     QTimer m_speakingStartTimer;
+    QTimer m_startThresholdTimer;   // Polls the buffer till there is enough audio to start
+    int m_startThresholdMs {100};
 
-    static TtsAudioLayer *m_pTtsAudioLayer;
+    // Time from the request, like the button press, till its answer is heard
+    QElapsedTimer m_requestTimer;
+    bool m_isRequestStarted {false};
+    int m_requestCount {0};
+    qint64 m_requestLatencyTotalMs {0};
+    qint64 m_requestLatencyMaxMs {0};
 
-    bool m_bOutputToFile =false;
+    static TtsAudioLayer *m_pTtsAudioLayer;
+    static bool m_isDirectOutput;
+    static AlsaOutput::Config m_directConfig;
 
     TtsAudioLayer(const QAudioFormat &format, QObject *parent);
+    void startWhenBuffered();
+    QIODevice *speechSource() const;
+    QAudio::State deviceState() const;
+    void startDevice();
+    void stopDevice();
+    void suspendDevice();
+    void resumeDevice();
+    // Starts the device for the speech or the earcons, if it isn't playing
+    void runDevice();
+    void startDirect();
+    void setAlsaState(QAudio::State state);
+    void onDeviceStateChanged(QAudio::State state);
+    void updateSpeechState();
+    void updateBusy();
+    void measureRequestLatency();
 
 public:
     virtual ~TtsAudioLayer();
     static TtsAudioLayer *instance(QObject *parent = NULL);
     static TtsAudioLayer *reset();
+    // Direct output is used by the layers created from now on, returns true if the setting changed
+    static bool setDirectOutput(bool isDirect, const AlsaOutput::Config &config);
+    bool isDirect() const;
+    // Decodes the WAV file once, the earcons are shared by the layers
+    static bool loadEarcon(Earcon earcon, const QString &fileName);
+
+    // Counterparts of the QAudioOutput methods, which control the speech on the direct output too.
+    // Speech state doesn't change with the earcons
+    QAudio::State speechState() const;
+    QAudio::Error outputError() const;
+    void suspendSpeech();
+    void resumeSpeech();
+    qint64 playedUSecs() const;
+    int outputBufferSize() const;
+    void setNotifyPeriod(int ms);
+
     void clear();
     void startTimer(int delayMs);
-    void stop();
+    // Playback starts when this much audio is buffered or the synthesis is finished
+    void setStartThreshold(int thresholdMs) { m_startThresholdMs = thresholdMs; }
+    bool isStartPending() const;
+    void stopSpeech();
+    // Called from the synthesis thread, blocks while the playback buffer is full
     void appendSample(const char *pSample, size_t size);
-    bool writeToWave(const char *sFileName);
-    bool writeToMp3(const char *sFileName);
-    void setOutputToFile(bool bOutputToFile) { m_bOutputToFile = bOutputToFile; }
+    void finishSamples();
+    // More samples of the same stream will be appended after finishSamples()
+    void reopenSamples();
+    // Buffered speech plays at the tempo at once, without the change of pitch
+    void setTempo(double tempo);
+    // Called from the synthesis thread, the samples appended from now on are synthesized
+    // at the new rate and play at tempo 1
+    void markNativeRate();
+    // Samples of the stream played since start, without the silence added by the audio layer
+    qint64 playedSamples() const;
+    int underruns() const;
+    qint64 bufferFill() const;
+    qint64 peakBufferFill() const;
+    // The next sound answers the request made now
+    void markRequest();
+
+    // Earcon starts with the next frame of the output, over the speech if it plays
+    void playEarcon(Earcon earcon);
+    // Earcon repeats on the clock of the output, skipping the repeats while the speech plays
+    void startRepeating(Earcon earcon, int delayMs, int intervalMs);
+    void stopRepeating();
+    // Speech or an earcon is playing, safe to call from other threads
+    bool isBusy() const;
+
+signals:
+    // State of the speech only, ZyrloTts follows it instead of stateChanged()
+    void speechStateChanged(QAudio::State state);
+    void busyChanged(bool isBusy);
  };
 
 #endif // TTSAUDIOLAYER_H
@@ -1,6 +1,8 @@
 #include "zyrlotts.h"
 #include "ttsaudiolayer.h"
 
+static constexpr int TTS_SAMPLE_RATE = 22050;
+
 ZyrloTts::ZyrloTts(QObject *parent, TtsAudioLayer **ppTtsAudioLayer)
     : QObject(parent)
     , m_ppTtsAudioLayer(ppTtsAudioLayer)
@@ -8,24 +10,28 @@ ZyrloTts::ZyrloTts(QObject *parent, TtsAudioLayer **ppTtsAudioLayer)
 
 }
 
+ZyrloTts::~ZyrloTts() {
+    delete m_mp3Encoder;
+}
+
 void ZyrloTts::pause() {
-    (*m_ppTtsAudioLayer)->suspend();
+    (*m_ppTtsAudioLayer)->suspendSpeech();
 }
 
 void ZyrloTts::resume() {
-   (*m_ppTtsAudioLayer)->resume();
+   (*m_ppTtsAudioLayer)->resumeSpeech();
 }
 
 bool ZyrloTts::isSpeaking() const {
-    return (*m_ppTtsAudioLayer)->state() == QAudio::ActiveState;
+    return (*m_ppTtsAudioLayer)->speechState() == QAudio::ActiveState;
 }
 
 bool ZyrloTts::isPaused() const {
-    return (*m_ppTtsAudioLayer)->state() == QAudio::SuspendedState;
+    return (*m_ppTtsAudioLayer)->speechState() == QAudio::SuspendedState;
 }
 
 bool ZyrloTts::isStoppedSpeaking() const {
-    return (*m_ppTtsAudioLayer)->state() == QAudio::StoppedState;
+    return (*m_ppTtsAudioLayer)->speechState() == QAudio::StoppedState && !(*m_ppTtsAudioLayer)->isStartPending();
 }
 
 void ZyrloTts::disconnectFromAudioLayer() {
@@ -33,41 +39,41 @@ void ZyrloTts::disconnectFromAudioLayer() {
     disconnect(m_connectChanged);
 }
 
-void ZyrloTts::sayAfter(const QString &text) {
-    m_messageQueMutex.lock();
-    if(isSpeaking() || !m_messageQue.empty())
-        m_messageQue.push_back(text);
-    else
-        say(text);
-    m_messageQueMutex.unlock();
+// Engines without look-ahead ignore the queued text, it's said by the next say()
+void ZyrloTts::sayNext(const QString &text) {
+    Q_UNUSED(text)
+}
+
+void ZyrloTts::clearCache() {
+}
+
+void ZyrloTts::prerender(const QStringList &texts) {
+    Q_UNUSED(texts)
 }
 
 void ZyrloTts::connectToAudioLayer() {
     m_connectNotify = connect((*m_ppTtsAudioLayer), &TtsAudioLayer::notify, this, [this](){
-        const auto elapsedSamples = (*m_ppTtsAudioLayer)->processedUSecs() *
-                (*m_ppTtsAudioLayer)->format().sampleRate() / 1'000'000;
-        auto newCurrentWord = m_currentWord;
-
-        {
-            // Searching if the new word pronouncing
-            QMutexLocker locker(&m_wordMarksMutex);
-            for (int i = m_currentWord + 1; i < m_wordMarks.size(); ++i) {
-                if (elapsedSamples >= static_cast<qint64>(m_wordMarks[i].cntDestPos)) {
-                    newCurrentWord = i;
-                } else {
-                    break;
-                }
-            }
-        }
-
+        // Output notifies while it plays the earcons alone too
+        if ((*m_ppTtsAudioLayer)->speechState() == QAudio::StoppedState)
+            return;
+        const auto elapsedSamples = (*m_ppTtsAudioLayer)->playedSamples();
+        // The last word started at the played sample
+        const int newCurrentWord = m_wordMarks.partitionPoint(m_currentWord + 1, [elapsedSamples](const WordMark &wordMark) {
+            return static_cast<qint64>(wordMark.mark.cntDestPos) <= elapsedSamples;
+        }) - 1;
         if (newCurrentWord > m_currentWord) {
+            const auto wordMark = m_wordMarks[newCurrentWord];
+            const int wordPosition = m_utterances[wordMark.utterance].positionMapper.position(wordMark.mark.cntSrcPos);
             m_currentWord = newCurrentWord;
-            emit wordNotify(m_positionMapper.position(m_wordMarks[m_currentWord].cntSrcPos),
-                            m_wordMarks[m_currentWord].cntSrcTextLen);
+            if (wordMark.utterance != m_currentUtterance) {
+                m_currentUtterance = wordMark.utterance;
+                emit utteranceStarted(m_currentUtterance);
+            }
+            emit wordNotify(wordPosition, wordMark.mark.cntSrcTextLen);
         }
     });
 
-    m_connectChanged = connect((*m_ppTtsAudioLayer), &QAudioOutput::stateChanged, this, [this](QAudio::State state) {
+    m_connectChanged = connect((*m_ppTtsAudioLayer), &TtsAudioLayer::speechStateChanged, this, [this](QAudio::State state) {
         //qDebug() << "state" << state;
         switch (state) {
         case QAudio::ActiveState:
@@ -75,27 +81,16 @@ void ZyrloTts::connectToAudioLayer() {
             break;
 
         case QAudio::StoppedState:
-            if ((*m_ppTtsAudioLayer)->error() != QAudio::NoError) {
+            if ((*m_ppTtsAudioLayer)->outputError() != QAudio::NoError) {
                 // Error handling
-                qWarning() << __func__ << __LINE__ << (*m_ppTtsAudioLayer)->error();
+                qWarning() << __func__ << __LINE__ << (*m_ppTtsAudioLayer)->outputError();
             }
             break;
 
         case QAudio::IdleState:
             if (m_ttsFuture.isFinished()) {
-                (*m_ppTtsAudioLayer)->stop();
+                (*m_ppTtsAudioLayer)->stopSpeech();
                 emit sayFinished();
-                m_messageQueMutex.lock();
-                if(m_messageQue.empty()) {
-                    m_messageQueMutex.unlock();
-                }
-                else {
-                    QString text = m_messageQue.front();
-                    m_messageQue.pop_front();
-                    m_messageQueMutex.unlock();
-                    say(text);
-                }
-
             }
             break;
 
@@ -105,23 +100,45 @@ void ZyrloTts::connectToAudioLayer() {
     });
 }
 
-bool ZyrloTts::writeToWave(const char *sFileName) {
-    bool bret = (*m_ppTtsAudioLayer)->writeToWave(sFileName);
-    (*m_ppTtsAudioLayer)->setOutputToFile(false);
+bool ZyrloTts::finishAudioFile() {
     m_bOutputToFile = false;
-    return bret;
+    return m_mp3Encoder->finish();
 }
 
-bool ZyrloTts::writeToMp3(const char *sFileName) {
-    bool bret = (*m_ppTtsAudioLayer)->writeToMp3(sFileName);
-    (*m_ppTtsAudioLayer)->setOutputToFile(false);
+void ZyrloTts::abortAudioFile() {
     m_bOutputToFile = false;
-    return bret;
+    m_mp3Encoder->abort();
+}
+
+void ZyrloTts::setPauses(const SilenceTrimmer::Pauses &pauses) {
+    QMutexLocker locker(&m_wordMarksMutex);
+    m_pauses = pauses;
+}
+
+qint64 ZyrloTts::trimmedSilenceMs() const {
+    return m_trimmedSamples * 1000 / TTS_SAMPLE_RATE;
+}
+
+Mp3Encoder::Stats ZyrloTts::audioFileStats() const {
+    return m_mp3Encoder ? m_mp3Encoder->stats() : Mp3Encoder::Stats();
+}
+
+void ZyrloTts::appendSamples(const char *pSamples, size_t size) {
+    if(m_bOutputToFile)
+        m_mp3Encoder->push(pSamples, size);
+    else
+        (*m_ppTtsAudioLayer)->appendSample(pSamples, size);
 }
 
 void ZyrloTts::convertTextToAudio(const QString & sText, const QString & sAudioFileName) {
-    m_bOutputToFile = true;
-    (*m_ppTtsAudioLayer)->setOutputToFile(true);
+    // The previous conversion is stopped before the new file is started
+    stop();
+    if(!m_mp3Encoder)
+        m_mp3Encoder = new Mp3Encoder(TTS_SAMPLE_RATE);
     m_audioOutFileName = sAudioFileName;
+    // Text isn't played even if the file can't be written
+    m_bOutputToFile = true;
+    if(!m_mp3Encoder->start(sAudioFileName.toStdString().c_str()))
+        qWarning() << "Can't write audio to" << sAudioFileName;
     say(sText);
 }
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QByteArray>
 #include <QBuffer>
 #include <QFuture>
@@ -11,11 +12,14 @@
 #include <QMap>
 #include <QAudioOutput>
 #include <QMetaObject>
-#include <deque>
+#include <atomic>
 
 #include <ve_ttsapi.h>
 
 #include "cerence/positionmapper.h"
+#include "appendlog.h"
+#include "mp3encoder.h"
+#include "silencetrimmer.h"
 
 class TtsAudioLayer;
 
@@ -28,11 +32,18 @@ protected:
     QString m_audioOutFileName;
 
 public:
+    // Engine without the audio layer only converts texts to files
     ZyrloTts(QObject *parent = nullptr, TtsAudioLayer **ppTtsAudioLayer = nullptr);
+    virtual ~ZyrloTts();
 
     virtual void say(const QString &text, int delayMs = 0) = 0;
-    virtual void sayAfter(const QString &text);
+    // Queues the text to be synthesized and played right after the current one
+    virtual void sayNext(const QString &text);
     virtual void stop() = 0;
+    // Drops audio kept for replay of the already said texts
+    virtual void clearCache();
+    // Renders audio of the texts in background, so they are said without synthesis
+    virtual void prerender(const QStringList &texts);
     virtual void pause();
     virtual void resume();
 
@@ -43,13 +54,20 @@ public:
     virtual void setSpeechRate(int nRate) = 0; //Range 50 - 400
     virtual int getSpeechRate() = 0;
 
-    virtual bool writeToWave(const char *sFileName);
     virtual bool outputToFile() const { return m_bOutputToFile; }
     virtual void convertTextToAudio(const QString & sText, const QString & sAudioFileName);
     virtual const QString & getAudioOutFileName() const { return m_audioOutFileName; }
-    virtual bool writeToMp3(const char *sFileName);
+    // Completes the file when the whole text is converted, or drops it when the conversion is stopped
+    virtual bool finishAudioFile();
+    virtual void abortAudioFile();
+    // Encoding stats of the last finished file
+    Mp3Encoder::Stats audioFileStats() const;
     virtual void setVolume(int nVolume) = 0;
     virtual int getVolume() = 0;
+    // Silence around the said texts is trimmed to these pauses
+    void setPauses(const SilenceTrimmer::Pauses &pauses);
+    // Silence trimmed since the engine was created
+    qint64 trimmedSilenceMs() const;
     virtual void connectToAudioLayer();
     virtual void disconnectFromAudioLayer();
 
@@ -57,19 +75,41 @@ signals:
     void sayStarted();
     void sayFinished();
     void wordMarksAdded();
+    // Texts are numbered from 0 by say() and sayNext() calls since the last say()
+    void utteranceStarted(int utterance);
     void wordNotify(int wordPosition, int wordLength);
+    void savingAudioDone(QString sfilename);
 
 protected:
+    // Synthesized samples go to the file or to the audio layer
+    void appendSamples(const char *pSamples, size_t size);
+    TtsAudioLayer *audioLayer() const { return m_ppTtsAudioLayer ? *m_ppTtsAudioLayer : nullptr; }
+
+    struct Utterance {
+        QString         text;
+        PositionMapper  positionMapper;
+    };
+
+    // Mark's cntDestPos counts samples from the beginning of the first utterance
+    struct WordMark {
+        VE_MARKINFO     mark;
+        int             utterance;
+    };
+
     QFuture<void>           m_ttsFuture;
 
-    QVector<VE_MARKINFO>    m_wordMarks;
+    // Utterances are appended in GUI thread only, so it reads them without lock
+    QVector<Utterance>      m_utterances;
+    // Appended by synthesis thread, read by GUI thread on audio notify
+    AppendLog<WordMark>     m_wordMarks;
     int                     m_currentWord {-1};
+    int                     m_currentUtterance {-1};
 
-    QMutex                  m_wordMarksMutex;
-    PositionMapper          m_positionMapper;
-    QMutex m_messageQueMutex;
-    std::deque<QString> m_messageQue;
+    QMutex                  m_wordMarksMutex;   // Guards m_utterances and synthesis state
+    SilenceTrimmer::Pauses  m_pauses;           // Guarded by m_wordMarksMutex
+    std::atomic<qint64>     m_trimmedSamples {0};
     TtsAudioLayer **m_ppTtsAudioLayer {nullptr};
+    Mp3Encoder *m_mp3Encoder {nullptr};     // Created by the first conversion to the file
     QMetaObject::Connection m_connectNotify, m_connectChanged;
 };
 
@@ -0,0 +1,86 @@
+#include <doctest.h>
+#include "alsaoutput.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const int SAMPLE_RATE = 22050;
+
+// The null device plays without the sound card, ZYRLO_ALSA_TEST_DEVICE selects another one, like hw:Loopback,0
+static AlsaOutput::Config testConfig()
+{
+    AlsaOutput::Config config;
+    const char *device = std::getenv("ZYRLO_ALSA_TEST_DEVICE");
+    config.device = device ? device : "null";
+    config.priority = 0;
+    return config;
+}
+
+static bool waitForState(const AlsaOutput &output, AlsaOutput::State state, int timeoutMs)
+{
+    for (int ms = 0; ms < timeoutMs; ++ms) {
+        if (output.state() == state)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return output.state() == state;
+}
+
+TEST_CASE("AlsaOutput")
+{
+    AlsaOutput output(testConfig(), SAMPLE_RATE, 1);
+    if (!output.open()) {
+        MESSAGE("ALSA device is not available, skipped");
+        return;
+    }
+    CHECK_GT(output.periodFrames(), 0);
+    CHECK_GE(output.bufferFrames(), output.periodFrames());
+
+    std::atomic<int> idleCount {0};
+    output.setStateHandler([&idleCount](AlsaOutput::State state) {
+        if (state == AlsaOutput::State::Idle)
+            ++idleCount;
+    });
+
+    DOCTEST_SUBCASE("plays the source out and goes idle") {
+        const std::vector<qint16> samples(SAMPLE_RATE / 5, 1000);
+        size_t readPos = 0;
+        output.start([&samples, &readPos](char *data, qint64 maxSize) -> qint64 {
+            const auto size = std::min<size_t>(static_cast<size_t>(maxSize), (samples.size() - readPos) * 2);
+            std::memcpy(data, reinterpret_cast<const char *>(samples.data()) + readPos * 2, size);
+            readPos += size / 2;
+            return static_cast<qint64>(size);
+        });
+        REQUIRE(waitForState(output, AlsaOutput::State::Idle, 2000));
+        CHECK_EQ(output.playedFrames(), static_cast<qint64>(samples.size()));
+        CHECK_EQ(output.underruns(), 0);
+        CHECK_EQ(idleCount, 1);
+        output.stop();
+        CHECK_EQ(output.state(), AlsaOutput::State::Stopped);
+    }
+
+    DOCTEST_SUBCASE("suspended output keeps its position") {
+        output.start([](char *data, qint64 maxSize) -> qint64 {
+            std::memset(data, 0, static_cast<size_t>(maxSize));
+            return maxSize;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        output.suspend();
+        CHECK_EQ(output.state(), AlsaOutput::State::Suspended);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const qint64 suspendedAt = output.playedFrames();
+        CHECK_GT(suspendedAt, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_EQ(output.playedFrames(), suspendedAt);
+        output.resume();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_GT(output.playedFrames(), suspendedAt);
+        output.stop();
+        CHECK_EQ(idleCount, 0);
+    }
+}
@@ -0,0 +1,61 @@
+#include <doctest.h>
+#include "appendlog.h"
+
+#include <thread>
+
+TEST_CASE("AppendLog")
+{
+    AppendLog<int> log;
+    CHECK(log.isEmpty());
+
+    DOCTEST_SUBCASE("append across chunks") {
+        for (int i = 0; i < AppendLog<int>::CHUNK_SIZE * 3 + 1; ++i)
+            REQUIRE(log.append(i * 10));
+        REQUIRE_EQ(log.size(), AppendLog<int>::CHUNK_SIZE * 3 + 1);
+        CHECK_EQ(log[0], 0);
+        CHECK_EQ(log[AppendLog<int>::CHUNK_SIZE], AppendLog<int>::CHUNK_SIZE * 10);
+        CHECK_EQ(log[log.size() - 1], (log.size() - 1) * 10);
+    }
+
+    DOCTEST_SUBCASE("partition point") {
+        for (int i = 0; i < 1000; ++i)
+            log.append(i * 10);
+        const auto isNotAfter = [](int samples) {
+            return [samples](int value) { return value <= samples; };
+        };
+        CHECK_EQ(log.partitionPoint(0, isNotAfter(-1)), 0);
+        CHECK_EQ(log.partitionPoint(0, isNotAfter(0)), 1);
+        CHECK_EQ(log.partitionPoint(0, isNotAfter(555)), 56);
+        CHECK_EQ(log.partitionPoint(0, isNotAfter(100000)), 1000);
+        CHECK_EQ(log.partitionPoint(100, isNotAfter(555)), 100);
+        CHECK_EQ(log.partitionPoint(2000, isNotAfter(555)), 2000);
+    }
+
+    DOCTEST_SUBCASE("clear reuses chunks") {
+        for (int i = 0; i < 300; ++i)
+            log.append(i);
+        log.clear();
+        CHECK(log.isEmpty());
+        log.append(7);
+        REQUIRE_EQ(log.size(), 1);
+        CHECK_EQ(log[0], 7);
+    }
+
+    DOCTEST_SUBCASE("concurrent reader") {
+        constexpr int COUNT = 100000;
+        std::thread writer([&log]() {
+            for (int i = 0; i < COUNT; ++i)
+                log.append(i);
+        });
+
+        bool isOrdered = true;
+        int read = 0;
+        while (read < COUNT) {
+            const int size = log.size();
+            for (; read < size; ++read)
+                isOrdered = isOrdered && log[read] == read;
+        }
+        writer.join();
+        CHECK(isOrdered);
+    }
+}
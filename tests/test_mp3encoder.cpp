@@ -0,0 +1,60 @@
+#include <doctest.h>
+#include "mp3encoder.h"
+
+#include <QByteArray>
+#include <cstdio>
+
+static long fileSize(const char *fileName)
+{
+    FILE *fp = fopen(fileName, "rb");
+    if (!fp)
+        return -1;
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+TEST_CASE("Mp3Encoder")
+{
+    const char *fileName = "test_mp3encoder.mp3";
+    // The buffer is much smaller than the audio, so pushing waits for the encoder
+    Mp3Encoder encoder(22050, 4096);
+    const QByteArray pcm(22050 * 2, '\0');
+
+    DOCTEST_SUBCASE("finish") {
+        REQUIRE(encoder.start(fileName));
+        CHECK(encoder.isActive());
+        for (int i = 0; i < 3; ++i)
+            encoder.push(pcm.constData(), pcm.size());
+        CHECK(encoder.finish());
+        CHECK_FALSE(encoder.isActive());
+
+        const auto stats = encoder.stats();
+        CHECK_EQ(stats.pcmBytes, pcm.size() * 3);
+        CHECK_GT(stats.mp3Bytes, 0);
+        CHECK_EQ(fileSize(fileName), stats.mp3Bytes);
+        CHECK_LE(stats.peakBufferFill, 4096);
+        CHECK_FALSE(encoder.finish());
+    }
+
+    DOCTEST_SUBCASE("abort") {
+        REQUIRE(encoder.start(fileName));
+        encoder.push(pcm.constData(), pcm.size());
+        encoder.abort();
+        CHECK_FALSE(encoder.isActive());
+        CHECK_EQ(fileSize(fileName), -1);
+    }
+
+    DOCTEST_SUBCASE("restart") {
+        REQUIRE(encoder.start(fileName));
+        encoder.push(pcm.constData(), pcm.size());
+        REQUIRE(encoder.start(fileName));
+        encoder.push(pcm.constData(), 1000);
+        CHECK(encoder.finish());
+        CHECK_EQ(encoder.stats().pcmBytes, 1000);
+    }
+
+    CHECK_FALSE(encoder.start("missing/dir/file.mp3"));
+    std::remove(fileName);
+}
@@ -9,6 +9,8 @@
 #include <doctest.h>
 #include "paragraph.h"
 
+#include <type_traits>
+
 TEST_CASE("Paragraph")
 {
     Paragraph p0(0);
@@ -89,4 +91,73 @@ TEST_CASE("Paragraph")
     DOCTEST_SUBCASE("length") {
         CHECK_EQ(p0.length(), 13);
     }
+
+    DOCTEST_SUBCASE("textView") {
+        CHECK(p0.textView() == QStringView(u"one two three"));
+        CHECK(p2.textView().isEmpty());
+    }
+
+    DOCTEST_SUBCASE("word positions") {
+        p2.addLine("Hello world. One two three", "eng");
+        CHECK_EQ(p2.firstWordPosition().parPos(), 0);
+        CHECK_EQ(p2.lastWordPosition().parPos(), 21);
+        CHECK_EQ(p2.nextWordPosition(0).parPos(), 6);
+        CHECK_EQ(p2.nextWordPosition(8).parPos(), 13);
+        CHECK_EQ(p2.currentWordPosition(8).parPos(), 6);
+        CHECK_EQ(p2.currentWordPosition(8).length(), 5);
+        CHECK_EQ(p2.prevWordPosition(13).parPos(), 6);
+        CHECK_FALSE(p2.prevWordPosition(0).isValid());
+        CHECK_FALSE(p2.nextWordPosition(23).isValid());
+    }
+
+    DOCTEST_SUBCASE("sentence positions") {
+        p2.addLine("Hello world. One two three", "eng");
+        CHECK_EQ(p2.firstSentencePosition().length(), 12);
+        CHECK_EQ(p2.nextSentencePosition(0).parPos(), 12);
+        CHECK_EQ(p2.currentSentencePosition(20).parPos(), 12);
+        CHECK_FALSE(p2.nextSentencePosition(12).isValid());
+    }
+
+    DOCTEST_SUBCASE("char positions") {
+        CHECK_EQ(p0.firstCharPosition().parPos(), 0);
+        CHECK_EQ(p0.lastCharPosition().parPos(), 12);
+        CHECK_EQ(p0.nextCharPosition(3).parPos(), 4);
+        CHECK_EQ(p0.nextCharPosition(3).length(), 1);
+        CHECK_EQ(p0.prevCharPosition(3).parPos(), 2);
+        CHECK_EQ(p0.prevCharPosition(100).parPos(), 11);
+        CHECK_FALSE(p0.prevCharPosition(0).isValid());
+        CHECK_FALSE(p0.nextCharPosition(12).isValid());
+        CHECK_FALSE(p2.firstCharPosition().isValid());
+    }
+
+    DOCTEST_SUBCASE("shared storage") {
+        TextStorage storage = TextStorage::create();
+        Paragraph first(0, storage);
+        first.addLine("first", "eng");
+        Paragraph second(1, storage);
+        second.addLine("second", "eng");
+
+        CHECK_EQ(*storage, QString("first\nsecond"));
+        CHECK_EQ(first.paragraphPosition(), 0);
+        CHECK_EQ(second.paragraphPosition(), 6);
+        CHECK_EQ(second.text(), QString("second"));
+        static_assert(!std::is_copy_constructible<Paragraph>::value, "copies would share the storage");
+    }
+
+    DOCTEST_SUBCASE("lang") {
+        Paragraph mixed(0);
+        mixed.addLine("hello", "eng");
+        mixed.addLine("bonjour", "fra");
+
+        CHECK_EQ(mixed.lang(0), std::make_pair(QString("eng"), 5));
+        CHECK_EQ(mixed.lang(3), std::make_pair(QString("eng"), 5));
+        CHECK_EQ(mixed.lang(8), std::make_pair(QString("fra"), -1));
+        CHECK_EQ(p0.lang(10), std::make_pair(QString("eng"), -1));
+    }
+
+    DOCTEST_SUBCASE("isLastWordComplete") {
+        CHECK(p0.isLastWordComplete());
+        p1.addLine("six-", "eng");
+        CHECK_FALSE(p1.isLastWordComplete());
+    }
 }
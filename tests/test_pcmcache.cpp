@@ -0,0 +1,130 @@
+#include <doctest.h>
+#include "pcmcache.h"
+
+#include <cstdio>
+
+// Two bytes per sample, sample value is its index
+static QByteArray samples(int count)
+{
+    QByteArray pcm(count * 2, '\0');
+    for (int i = 0; i < count; ++i)
+        pcm[i * 2] = static_cast<char>(i);
+    return pcm;
+}
+
+TEST_CASE("PcmCache")
+{
+    PcmCache cache(1000);
+    const QByteArray text("One two three");
+    const QVector<PcmCache::Mark> marks {{0, 3, 0}, {4, 3, 10}, {8, 5, 25}};
+    cache.insert(text, samples(40), marks);
+    CHECK_EQ(cache.size(), 80);
+
+    PcmCache::Hit hit;
+
+    DOCTEST_SUBCASE("whole text") {
+        REQUIRE(cache.find(text, hit));
+        CHECK_EQ(hit.textLength, text.size());
+        CHECK_EQ(hit.pcm, samples(40));
+        CHECK_EQ(hit.marks.size(), 3);
+        CHECK_EQ(cache.hits(), 1);
+        CHECK_EQ(cache.misses(), 0);
+    }
+
+    DOCTEST_SUBCASE("from a word") {
+        REQUIRE(cache.find("two three", hit));
+        CHECK_EQ(hit.textLength, 9);
+        REQUIRE_EQ(hit.pcm.size(), 30 * 2);
+        CHECK_EQ(hit.pcm[0], 10);
+        REQUIRE_EQ(hit.marks.size(), 2);
+        CHECK_EQ(hit.marks[0].srcPos, 0);
+        CHECK_EQ(hit.marks[0].destPos, 0);
+        CHECK_EQ(hit.marks[1].srcPos, 4);
+        CHECK_EQ(hit.marks[1].srcLength, 5);
+        CHECK_EQ(hit.marks[1].destPos, 15);
+    }
+
+    DOCTEST_SUBCASE("beginning of longer text") {
+        REQUIRE(cache.find("three four five", hit));
+        CHECK_EQ(hit.textLength, 5);
+        CHECK_EQ(hit.marks.size(), 1);
+    }
+
+    DOCTEST_SUBCASE("exact text") {
+        REQUIRE(cache.findText(text, hit));
+        CHECK_EQ(hit.pcm, samples(40));
+        CHECK_EQ(hit.marks.size(), 3);
+        CHECK_FALSE(cache.findText("two three", hit));
+        CHECK_EQ(cache.hits(), 1);
+        CHECK_EQ(cache.misses(), 1);
+    }
+
+    DOCTEST_SUBCASE("beginning of a longer word") {
+        CHECK_FALSE(cache.find("threesome", hit));
+        CHECK_FALSE(cache.find("two threefold", hit));
+        REQUIRE(cache.find("three, four", hit));
+        CHECK_EQ(hit.textLength, 5);
+        CHECK_EQ(cache.misses(), 2);
+    }
+
+    DOCTEST_SUBCASE("miss") {
+        CHECK_FALSE(cache.find("wo three", hit));
+        CHECK_FALSE(cache.find("One two", hit));
+        CHECK_FALSE(cache.find("four", hit));
+        CHECK_EQ(cache.hits(), 0);
+        CHECK_EQ(cache.misses(), 3);
+    }
+
+    DOCTEST_SUBCASE("least recently used is evicted") {
+        cache.insert("Four", samples(200), {{0, 4, 0}});
+        CHECK(cache.find(text, hit));
+        cache.insert("Five", samples(200), {{0, 4, 0}});
+        CHECK_EQ(cache.size(), 880);
+
+        cache.insert("Six", samples(100), {{0, 3, 0}});
+        CHECK_EQ(cache.size(), 680);
+        CHECK_FALSE(cache.find("Four", hit));
+        CHECK(cache.find(text, hit));
+        CHECK(cache.find("Six", hit));
+    }
+
+    DOCTEST_SUBCASE("too large") {
+        cache.insert("Large", samples(501), {});
+        CHECK_EQ(cache.size(), 80);
+        CHECK_FALSE(cache.find("Large", hit));
+    }
+
+    DOCTEST_SUBCASE("clear") {
+        cache.clear();
+        CHECK_EQ(cache.size(), 0);
+        CHECK_FALSE(cache.find(text, hit));
+    }
+}
+
+TEST_CASE("PcmCache file")
+{
+    const char *fileName = "test_pcmcache.pcm";
+    const QByteArray text("End of text");
+    PcmCache cache(1000);
+    cache.insert(text, samples(100), {{0, 3, 0}, {4, 2, 30}, {7, 4, 50}});
+    CHECK(cache.contains(text));
+    CHECK_FALSE(cache.contains("End of"));
+    CHECK_FALSE(cache.save("End of", fileName));
+    REQUIRE(cache.save(text, fileName));
+
+    PcmCache loaded(1000);
+    REQUIRE(loaded.load(fileName));
+    CHECK_EQ(loaded.size(), 200);
+    PcmCache::Hit hit;
+    REQUIRE(loaded.find("text", hit));
+    CHECK_EQ(hit.pcm, samples(100).mid(100));
+    REQUIRE_EQ(hit.marks.size(), 1);
+    CHECK_EQ(hit.marks[0].srcLength, 4);
+
+    // The audio is larger than the cache
+    PcmCache small(100);
+    CHECK_FALSE(small.load(fileName));
+    CHECK_FALSE(loaded.load("missing.pcm"));
+
+    std::remove(fileName);
+}
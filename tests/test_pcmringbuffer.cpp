@@ -0,0 +1,111 @@
+#include <doctest.h>
+#include "pcmringbuffer.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST_CASE("PcmRingBuffer")
+{
+    PcmRingBuffer buffer(1000);
+    std::vector<char> data(3000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 7);
+    std::vector<char> out(data.size());
+
+    DOCTEST_SUBCASE("capacity") {
+        CHECK_EQ(buffer.capacity(), 1024);
+        CHECK(buffer.isSequential());
+        CHECK_EQ(buffer.fill(), 0);
+    }
+
+    DOCTEST_SUBCASE("push and read across the end") {
+        CHECK_EQ(buffer.push(data.data(), 700), 700);
+        CHECK_EQ(buffer.read(out.data(), 600), 600);
+        CHECK_EQ(buffer.push(data.data() + 700, 900), 900);
+        CHECK_EQ(buffer.fill(), 1000);
+        CHECK_EQ(buffer.bytesAvailable(), 1000);
+        CHECK_EQ(buffer.read(out.data() + 600, 2000), 1000);
+        CHECK(std::equal(out.begin(), out.begin() + 1600, data.begin()));
+        CHECK_EQ(buffer.peakFill(), 1000);
+        CHECK_EQ(buffer.pushed(), 1600);
+    }
+
+    DOCTEST_SUBCASE("underruns") {
+        CHECK_EQ(buffer.read(out.data(), 10), 0);
+        CHECK_EQ(buffer.read(out.data(), 10), 0);
+        CHECK_EQ(buffer.underruns(), 1);
+
+        buffer.push(data.data(), 10);
+        CHECK_EQ(buffer.read(out.data(), 100), 10);
+        CHECK_EQ(buffer.read(out.data(), 100), 0);
+        CHECK_EQ(buffer.underruns(), 2);
+
+        CHECK_FALSE(buffer.isFinished());
+        buffer.finish();
+        CHECK(buffer.isFinished());
+        buffer.push(data.data(), 10);
+        CHECK_EQ(buffer.read(out.data(), 100), 10);
+        CHECK_EQ(buffer.read(out.data(), 100), 0);
+        CHECK_EQ(buffer.underruns(), 2);
+
+        buffer.clearStream();
+        CHECK_EQ(buffer.underruns(), 0);
+        CHECK_FALSE(buffer.isFinished());
+    }
+
+    DOCTEST_SUBCASE("drain and reopen") {
+        buffer.push(data.data(), 10);
+        buffer.finish(20);
+        CHECK_EQ(buffer.read(out.data(), 100), 10);
+        CHECK_EQ(buffer.read(out.data(), 15), 15);
+        CHECK_EQ(out[0], 0);
+        CHECK_EQ(buffer.read(out.data(), 100), 5);
+        CHECK_EQ(buffer.read(out.data(), 100), 0);
+        CHECK_EQ(buffer.drainedSilence(), 20);
+
+        buffer.reopen();
+        CHECK_EQ(buffer.read(out.data(), 100), 0);
+        CHECK_EQ(buffer.underruns(), 1);
+        buffer.push(data.data(), 10);
+        buffer.finish(20);
+        CHECK_EQ(buffer.read(out.data(), 100), 10);
+        CHECK_EQ(buffer.read(out.data(), 100), 20);
+        CHECK_EQ(buffer.drainedSilence(), 40);
+    }
+
+    DOCTEST_SUBCASE("producer waits for consumer") {
+        std::thread producer([&]() {
+            buffer.push(data.data(), static_cast<qint64>(data.size()));
+            buffer.finish();
+        });
+
+        size_t received = 0;
+        qint64 maxFill = 0;
+        while (received < out.size()) {
+            maxFill = std::max(maxFill, buffer.fill());
+            received += static_cast<size_t>(buffer.read(out.data() + received, 100));
+        }
+        producer.join();
+
+        CHECK(maxFill <= buffer.capacity());
+        CHECK(out == data);
+        CHECK_EQ(buffer.peakFill(), buffer.capacity());
+    }
+
+    DOCTEST_SUBCASE("abort releases producer") {
+        qint64 pushed = -1;
+        std::thread producer([&]() {
+            pushed = buffer.push(data.data(), static_cast<qint64>(data.size()));
+        });
+        while (buffer.fill() < buffer.capacity()) {
+            std::this_thread::yield();
+        }
+        buffer.abort();
+        producer.join();
+
+        CHECK_EQ(pushed, buffer.capacity());
+        CHECK_EQ(buffer.bytesAvailable(), 0);
+        CHECK_EQ(buffer.read(out.data(), 100), 0);
+    }
+}
@@ -0,0 +1,81 @@
+#include <doctest.h>
+#include "silencetrimmer.h"
+
+#include <algorithm>
+#include <vector>
+
+static const int SAMPLE_RATE = 22050;
+static const int MS = SAMPLE_RATE / 1000;
+
+// Silence, speech and silence of the given lengths
+static std::vector<qint16> segment(int leadingMs, int speechMs, int trailingMs)
+{
+    std::vector<qint16> samples(leadingMs * MS, 3);
+    for (int i = 0; i < speechMs * MS; ++i)
+        samples.push_back(static_cast<qint16>(i % 40 < 20 ? 5000 : -5000));
+    samples.insert(samples.end(), trailingMs * MS, -2);
+    return samples;
+}
+
+static std::vector<qint16> trim(SilenceTrimmer &trimmer, const std::vector<qint16> &samples, int chunk,
+                                int leadingMs, int trailingMs)
+{
+    std::vector<qint16> output;
+    trimmer.start(leadingMs);
+    for (size_t pos = 0; pos < samples.size(); pos += chunk)
+        trimmer.push(samples.data() + pos, static_cast<int>(std::min<size_t>(chunk, samples.size() - pos)), output);
+    trimmer.finish(trailingMs, output);
+    return output;
+}
+
+TEST_CASE("SilenceTrimmer")
+{
+    SilenceTrimmer trimmer(SAMPLE_RATE);
+
+    DOCTEST_SUBCASE("caps the leading and trailing silence") {
+        for (int chunk : {1, 100, 1000, 100000}) {
+            const auto output = trim(trimmer, segment(300, 500, 600), chunk, 30, 200);
+            // Silence is cut by whole frames of 5 ms
+            CHECK_EQ(output.size(), doctest::Approx((30 + 500 + 200) * MS).epsilon(0.01));
+            CHECK_EQ(trimmer.outputPosition(300 * MS), doctest::Approx(30 * MS).epsilon(0.1));
+        }
+        CHECK_EQ(trimmer.trimmedSamples(), doctest::Approx(4 * (270 + 400) * MS).epsilon(0.01));
+    }
+
+    DOCTEST_SUBCASE("silence inside the segment is kept") {
+        auto samples = segment(0, 200, 500);
+        const auto second = segment(0, 200, 0);
+        samples.insert(samples.end(), second.begin(), second.end());
+        const auto output = trim(trimmer, samples, 512, 30, 100);
+        CHECK(output == samples);
+        CHECK_EQ(trimmer.trimmedSamples(), 0);
+    }
+
+    DOCTEST_SUBCASE("marks wait till the speech starts") {
+        const auto samples = segment(100, 100, 0);
+        std::vector<qint16> output;
+        trimmer.start(0);
+        trimmer.push(samples.data(), 50 * MS, output);
+        CHECK(trimmer.isLeading());
+        CHECK(output.empty());
+        trimmer.push(samples.data() + 50 * MS, static_cast<int>(samples.size()) - 50 * MS, output);
+        CHECK_FALSE(trimmer.isLeading());
+        CHECK_EQ(trimmer.sourcePosition(), static_cast<qint64>(samples.size()));
+        CHECK_EQ(trimmer.outputPosition(0), 0);
+        CHECK_EQ(trimmer.outputPosition(150 * MS), 50 * MS);
+    }
+
+    DOCTEST_SUBCASE("negative pause keeps the silence") {
+        const auto samples = segment(100, 100, 100);
+        CHECK(trim(trimmer, samples, 256, -1, -1) == samples);
+    }
+
+    DOCTEST_SUBCASE("pause suits the end of the text") {
+        SilenceTrimmer::Pauses pauses;
+        CHECK_EQ(SilenceTrimmer::pauseAfterMs(pauses, "It ends here. "), pauses.sentenceMs);
+        CHECK_EQ(SilenceTrimmer::pauseAfterMs(pauses, "He said \"Stop!\""), pauses.sentenceMs);
+        CHECK_EQ(SilenceTrimmer::pauseAfterMs(pauses, "first, "), pauses.clauseMs);
+        CHECK_EQ(SilenceTrimmer::pauseAfterMs(pauses, "the line goes on"), pauses.wordMs);
+        CHECK_EQ(SilenceTrimmer::pauseAfterMs(pauses, ""), pauses.wordMs);
+    }
+}
@@ -0,0 +1,50 @@
+#include <doctest.h>
+#include "snapshotbuffer.h"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("SnapshotBuffer")
+{
+    SnapshotBuffer<std::vector<int>> buffer;
+    CHECK(buffer.latest().empty());
+
+    DOCTEST_SUBCASE("latest published value") {
+        buffer.back().assign(3, 1);
+        buffer.publish();
+        buffer.back().assign(2, 2);
+        buffer.publish();
+        CHECK_EQ(buffer.latest(), std::vector<int>(2, 2));
+        // Nothing new, the value stays
+        CHECK_EQ(buffer.latest(), std::vector<int>(2, 2));
+
+        buffer.back().assign(5, 3);
+        buffer.publish();
+        CHECK_EQ(buffer.latest(), std::vector<int>(5, 3));
+    }
+
+    DOCTEST_SUBCASE("concurrent reader") {
+        constexpr int COUNT = 100000;
+        std::thread writer([&buffer]() {
+            for (int i = 1; i <= COUNT; ++i) {
+                buffer.back().assign(4, i);
+                buffer.publish();
+            }
+        });
+
+        bool isConsistent = true;
+        bool isOrdered = true;
+        int previous = 0;
+        while (previous < COUNT) {
+            const auto &value = buffer.latest();
+            if (value.empty())
+                continue;
+            isConsistent = isConsistent && value == std::vector<int>(4, value[0]);
+            isOrdered = isOrdered && value[0] >= previous;
+            previous = value[0];
+        }
+        writer.join();
+        CHECK(isConsistent);
+        CHECK(isOrdered);
+    }
+}
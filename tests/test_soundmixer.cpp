@@ -0,0 +1,182 @@
+#include <doctest.h>
+#include "soundmixer.h"
+
+#include <algorithm>
+#include <vector>
+
+static const int SAMPLE_RATE = 22050;
+static const int MS = SAMPLE_RATE / 1000;
+
+static int frames(int ms)
+{
+    return ms * SAMPLE_RATE / 1000;
+}
+
+static SoundMixer::Sound sound(int count, qint16 value)
+{
+    return std::make_shared<const std::vector<qint16>>(count, value);
+}
+
+static QByteArray wav(int channels, int sampleRate, int bits, const std::vector<int> &samples)
+{
+    QByteArray data;
+    auto append = [&data](quint32 value, int size) {
+        for (int i = 0; i < size; ++i)
+            data.append(static_cast<char>((value >> (8 * i)) & 0xff));
+    };
+    const int size = static_cast<int>(samples.size()) * bits / 8;
+    data.append("RIFF");
+    append(36 + size, 4);
+    data.append("WAVEfmt ");
+    append(16, 4);
+    append(1, 2);
+    append(channels, 2);
+    append(sampleRate, 4);
+    append(sampleRate * channels * bits / 8, 4);
+    append(channels * bits / 8, 2);
+    append(bits, 2);
+    data.append("data");
+    append(size, 4);
+    for (int sample : samples)
+        append(static_cast<quint32>(sample), bits / 8);
+    return data;
+}
+
+// Speech source of the constant samples
+struct Speech {
+    int     left;
+    qint16  value;
+
+    int operator()(qint16 *samples, int maxCount) {
+        const int count = std::min(left, maxCount);
+        std::fill(samples, samples + count, value);
+        left -= count;
+        return count;
+    }
+};
+
+TEST_CASE("SoundMixer")
+{
+    SoundMixer mixer(SAMPLE_RATE);
+    std::vector<qint16> output(100 * MS);
+    const int size = static_cast<int>(output.size());
+
+    DOCTEST_SUBCASE("decodes the WAV to mono of the sample rate") {
+        std::vector<int> stereo;
+        for (int i = 0; i < 2 * SAMPLE_RATE; ++i)
+            stereo.insert(stereo.end(), {1000, 3000});
+        const auto decoded = SoundMixer::decodeWav(wav(2, 2 * SAMPLE_RATE, 16, stereo), SAMPLE_RATE);
+        REQUIRE(decoded);
+        CHECK_EQ(decoded->size(), SAMPLE_RATE);
+        CHECK_EQ((*decoded)[100], 2000);
+
+        const auto unsignedBytes = SoundMixer::decodeWav(wav(1, SAMPLE_RATE, 8, {128, 192, 64}), SAMPLE_RATE);
+        REQUIRE(unsignedBytes);
+        CHECK(*unsignedBytes == std::vector<qint16>({0, 16384, -16384}));
+
+        CHECK_FALSE(SoundMixer::decodeWav(QByteArray("RIFF"), SAMPLE_RATE));
+        CHECK_FALSE(SoundMixer::decodeWav(wav(1, SAMPLE_RATE, 24, {0, 0, 0}), SAMPLE_RATE));
+    }
+
+    DOCTEST_SUBCASE("sounds alone play till their end") {
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 0);
+        mixer.play(sound(30 * MS, 500));
+        CHECK(mixer.isPlaying());
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 30 * MS);
+        CHECK(std::all_of(output.begin(), output.begin() + 30 * MS, [](qint16 sample) { return sample == 500; }));
+        CHECK_FALSE(mixer.isPlaying());
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 0);
+    }
+
+    DOCTEST_SUBCASE("tail of silence follows the sounds") {
+        mixer.setTail(20 * MS);
+        mixer.play(sound(30 * MS, 500));
+        CHECK_EQ(mixer.read(output.data(), 40 * MS, nullptr), 40 * MS);
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 10 * MS);
+        CHECK_EQ(output[0], 0);
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 0);
+    }
+
+    DOCTEST_SUBCASE("speech is ducked under the sound and restored after it") {
+        Speech speech {size * 3, 1000};
+        mixer.setDuckGain(0.25f);
+        mixer.play(sound(50 * MS, 100));
+        REQUIRE_EQ(mixer.read(output.data(), size, std::ref(speech)), size);
+        // Gain ramps down without a step
+        CHECK_EQ(output[0], doctest::Approx(1100).epsilon(0.01));
+        CHECK_EQ(output[40 * MS], 350);
+        CHECK_EQ(output[60 * MS], 1000);
+        for (int i = 1; i < size; ++i)
+            CHECK_LE(std::abs(output[i] - output[i - 1]), 200);
+
+        REQUIRE_EQ(mixer.read(output.data(), size, std::ref(speech)), size);
+        CHECK_EQ(output[size - 1], 1000);
+    }
+
+    DOCTEST_SUBCASE("loud sounds saturate") {
+        Speech speech {size, 30000};
+        mixer.setDuckGain(1.0f);
+        mixer.play(sound(size, 30000));
+        mixer.play(sound(size, -30000));
+        mixer.play(sound(size, 30000));
+        REQUIRE_EQ(mixer.read(output.data(), size, std::ref(speech)), size);
+        CHECK_EQ(output[10], 32767);
+    }
+
+    DOCTEST_SUBCASE("speech running dry stalls the output") {
+        Speech speech {10 * MS, 1000};
+        mixer.play(sound(50 * MS, 100));
+        CHECK_EQ(mixer.read(output.data(), size, std::ref(speech)), 10 * MS);
+        CHECK_EQ(mixer.read(output.data(), size, std::ref(speech)), 0);
+        // The rest of the sound plays when the speech is gone
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 40 * MS);
+    }
+
+    DOCTEST_SUBCASE("repeated sound is timed by the output clock") {
+        mixer.startRepeating(sound(MS, 700), 15, 30);
+        std::vector<int> starts;
+        for (int pos = 0; pos < 100 * MS; pos += 7 * MS) {
+            REQUIRE_EQ(mixer.read(output.data(), 7 * MS, nullptr), 7 * MS);
+            for (int i = 0; i < 7 * MS; ++i) {
+                if (output[i] == 700 && (i == 0 || output[i - 1] != 700))
+                    starts.push_back(pos + i);
+            }
+        }
+        CHECK(starts == std::vector<int>({frames(15), frames(15) + frames(30), frames(15) + 2 * frames(30)}));
+
+        // Repeats during the speech are skipped
+        Speech speech {60 * MS, 0};
+        REQUIRE_EQ(mixer.read(output.data(), 60 * MS, std::ref(speech)), 60 * MS);
+        CHECK(std::all_of(output.begin(), output.begin() + 60 * MS, [](qint16 sample) { return sample == 0; }));
+
+        mixer.stopRepeating();
+        CHECK_FALSE(mixer.isPlaying());
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 0);
+    }
+
+    DOCTEST_SUBCASE("speech position skips the sounds played alone") {
+        Speech speech {size, 1000};
+        mixer.resetSpeech();
+        CHECK_EQ(mixer.read(output.data(), 20 * MS, std::ref(speech)), 20 * MS);
+        mixer.play(sound(30 * MS, 500));
+        CHECK_EQ(mixer.read(output.data(), size, nullptr), 30 * MS);
+        CHECK_EQ(mixer.read(output.data(), 20 * MS, std::ref(speech)), 20 * MS);
+
+        CHECK_EQ(mixer.speechPosition(10 * MS), 10 * MS);
+        CHECK_EQ(mixer.speechPosition(35 * MS), 20 * MS);
+        CHECK_EQ(mixer.speechPosition(60 * MS), 30 * MS);
+        CHECK_EQ(mixer.speechPosition(100 * MS), 40 * MS);
+
+        SoundMixer::SpeechMap map;
+        mixer.copySpeechMap(map);
+        for (qint64 pos = 0; pos < 100 * MS; pos += MS)
+            CHECK_EQ(map.speechPosition(pos), mixer.speechPosition(pos));
+
+        // Clock of the restarted device starts at the speech read so far
+        mixer.restart();
+        CHECK_EQ(mixer.clock(), 0);
+        CHECK_EQ(mixer.speechPosition(0), 40 * MS);
+        CHECK_EQ(mixer.read(output.data(), 10 * MS, std::ref(speech)), 10 * MS);
+        CHECK_EQ(mixer.speechPosition(5 * MS), 45 * MS);
+    }
+}
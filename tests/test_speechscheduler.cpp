@@ -0,0 +1,79 @@
+#include <doctest.h>
+#include "speechscheduler.h"
+
+using Decision = SpeechScheduler::Decision;
+
+TEST_CASE("SpeechScheduler")
+{
+    SpeechScheduler scheduler;
+    QString text;
+
+    DOCTEST_SUBCASE("alert preempts the page and leaves the scheduler idle") {
+        scheduler.startPage(0);
+        CHECK_EQ(scheduler.submit("Battery low", SpeechPriority::Alert, false, 10), Decision::Start);
+        CHECK_EQ(scheduler.stats(SpeechPriority::Page).preempted, 1);
+        CHECK_FALSE(scheduler.next(text, 500));
+        CHECK(scheduler.isIdle());
+    }
+
+    DOCTEST_SUBCASE("feedback doesn't cut the alert") {
+        CHECK_EQ(scheduler.submit("USB key inserted", SpeechPriority::Alert, false, 0), Decision::Start);
+        CHECK_EQ(scheduler.submit("Volume 5", SpeechPriority::Feedback, false, 100), Decision::Queue);
+        CHECK_EQ(scheduler.submit("Battery low", SpeechPriority::Alert, false, 200), Decision::Queue);
+        // Alert goes first, then the feedback
+        REQUIRE(scheduler.next(text, 1000));
+        CHECK_EQ(text, QString("Battery low"));
+        REQUIRE(scheduler.next(text, 1500));
+        CHECK_EQ(text, QString("Volume 5"));
+        CHECK_FALSE(scheduler.next(text, 2000));
+        CHECK_EQ(scheduler.stats(SpeechPriority::Feedback).maxLatencyMs, 1400);
+        CHECK_EQ(scheduler.stats(SpeechPriority::Alert).totalLatencyMs, 800);
+    }
+
+    DOCTEST_SUBCASE("newer feedback replaces the older") {
+        CHECK_EQ(scheduler.submit("Volume 5", SpeechPriority::Feedback, false, 0), Decision::Start);
+        CHECK_EQ(scheduler.submit("Volume 6", SpeechPriority::Feedback, false, 50), Decision::Start);
+        CHECK_EQ(scheduler.stats(SpeechPriority::Feedback).preempted, 1);
+        // Pressed again, the same feedback is said again
+        CHECK_EQ(scheduler.submit("Volume 6", SpeechPriority::Feedback, false, 60), Decision::Start);
+        CHECK_EQ(scheduler.submit("Volume 6", SpeechPriority::Feedback, true, 70), Decision::Drop);
+    }
+
+    DOCTEST_SUBCASE("repeated prompt isn't said again") {
+        CHECK_EQ(scheduler.submit("Place document", SpeechPriority::Alert, false, 0), Decision::Start);
+        CHECK_EQ(scheduler.submit("Place document", SpeechPriority::Alert, false, 10), Decision::Drop);
+        CHECK_EQ(scheduler.submit("Clear surface", SpeechPriority::Alert, true, 20), Decision::Queue);
+        CHECK_EQ(scheduler.submit("Clear surface", SpeechPriority::Alert, true, 30), Decision::Drop);
+        CHECK_EQ(scheduler.queueSize(), 1);
+        CHECK_EQ(scheduler.stats(SpeechPriority::Alert).dropped, 2);
+    }
+
+    DOCTEST_SUBCASE("queued prompt waits for the page") {
+        scheduler.startPage(0);
+        CHECK_EQ(scheduler.submit("Files to convert", SpeechPriority::Feedback, true, 10), Decision::Queue);
+        REQUIRE(scheduler.next(text, 100));
+        CHECK_EQ(text, QString("Files to convert"));
+        CHECK_EQ(scheduler.currentPriority(), SpeechPriority::Feedback);
+    }
+
+    DOCTEST_SUBCASE("only the latest progress is kept") {
+        CHECK_EQ(scheduler.submit("Page 1", SpeechPriority::Background, false, 0), Decision::Start);
+        CHECK_EQ(scheduler.submit("Page 2", SpeechPriority::Background, false, 10), Decision::Queue);
+        CHECK_EQ(scheduler.submit("Page 3", SpeechPriority::Background, false, 20), Decision::Queue);
+        CHECK_EQ(scheduler.submit("Volume 5", SpeechPriority::Feedback, true, 30), Decision::Queue);
+        CHECK_EQ(scheduler.queueSize(), 2);
+        REQUIRE(scheduler.next(text, 100));
+        CHECK_EQ(text, QString("Volume 5"));
+        REQUIRE(scheduler.next(text, 200));
+        CHECK_EQ(text, QString("Page 3"));
+    }
+
+    DOCTEST_SUBCASE("progress doesn't interrupt the page") {
+        scheduler.startPage(0);
+        CHECK_EQ(scheduler.submit("Page 1", SpeechPriority::Background, false, 0), Decision::Queue);
+        scheduler.stop();
+        CHECK(scheduler.isIdle());
+        CHECK_EQ(scheduler.stats(SpeechPriority::Background).dropped, 1);
+        CHECK_EQ(scheduler.submit("Page 2", SpeechPriority::Background, false, 10), Decision::Start);
+    }
+}
@@ -0,0 +1,63 @@
+#include <doctest.h>
+#include "spscqueue.h"
+
+#include <memory>
+#include <thread>
+
+TEST_CASE("SpscQueue")
+{
+    SpscQueue<int, 4> queue;
+    int value = 0;
+    CHECK_FALSE(queue.pop(value));
+
+    DOCTEST_SUBCASE("values keep the order and the queue fills up") {
+        for (int i = 1; i <= 4; ++i)
+            REQUIRE(queue.push(i));
+        CHECK_FALSE(queue.push(5));
+        CHECK_EQ(queue.size(), 4u);
+        for (int i = 1; i <= 4; ++i) {
+            REQUIRE(queue.pop(value));
+            CHECK_EQ(value, i);
+        }
+        CHECK_FALSE(queue.pop(value));
+        // Positions wrap around the slots
+        CHECK(queue.push(6));
+        REQUIRE(queue.pop(value));
+        CHECK_EQ(value, 6);
+    }
+
+    DOCTEST_SUBCASE("popped values aren't kept") {
+        SpscQueue<std::shared_ptr<int>, 2> pointers;
+        auto pointer = std::make_shared<int>(1);
+        REQUIRE(pointers.push(pointer));
+        std::shared_ptr<int> popped;
+        REQUIRE(pointers.pop(popped));
+        popped.reset();
+        CHECK_EQ(pointer.use_count(), 1);
+    }
+
+    DOCTEST_SUBCASE("concurrent consumer") {
+        constexpr int COUNT = 100000;
+        std::thread producer([&queue]() {
+            for (int i = 1; i <= COUNT;) {
+                if (queue.push(i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+        bool isOrdered = true;
+        int previous = 0;
+        while (previous < COUNT) {
+            if (queue.pop(value)) {
+                isOrdered = isOrdered && value == previous + 1;
+                previous = value;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        CHECK(isOrdered);
+    }
+}
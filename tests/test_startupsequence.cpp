@@ -0,0 +1,47 @@
+#include <doctest.h>
+#include "startupsequence.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+
+TEST_CASE("StartupSequence")
+{
+    int argc = 1;
+    const char *argv[] = {"startup"};
+    QCoreApplication app(argc, const_cast<char **>(argv));
+
+    StartupSequence startup;
+    QMutex mutex;
+    QStringList order;
+    const auto stage = [&](const QString &name, int sleepMs) {
+        return [&, name, sleepMs]() {
+            QThread::msleep(sleepMs);
+            QMutexLocker locker(&mutex);
+            order.append(name);
+        };
+    };
+    const auto guiThread = QThread::currentThread();
+    bool isGuiStageInGuiThread = false;
+
+    startup.addStage("slow", StartupSequence::Thread::Worker, {}, stage("slow", 50));
+    startup.addStage("fast", StartupSequence::Thread::Worker, {}, stage("fast", 0));
+    startup.addStage("gui", StartupSequence::Thread::Gui, {"fast"}, [&]() {
+        isGuiStageInGuiThread = QThread::currentThread() == guiThread;
+        stage("gui", 0)();
+    });
+    startup.addStage("last", StartupSequence::Thread::Worker, {"slow", "gui"}, stage("last", 0));
+    QObject::connect(&startup, &StartupSequence::finished, &app, &QCoreApplication::quit);
+
+    startup.start();
+    CHECK_FALSE(startup.isFinished());
+    app.exec();
+
+    CHECK(startup.isFinished());
+    CHECK(startup.isFinished("gui"));
+    CHECK(isGuiStageInGuiThread);
+    CHECK_EQ(order, QStringList({"fast", "gui", "slow", "last"}));
+    CHECK(startup.report().contains("last: started at"));
+    CHECK(startup.report().contains("Total:"));
+}
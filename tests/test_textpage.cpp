@@ -37,6 +37,23 @@ TEST_CASE("TextPage 1")
         page.setCompleted();
         CHECK(page.isComplete());
     }
+
+    DOCTEST_SUBCASE("text") {
+        CHECK_EQ(page.text(), QString("Hello world one two three. Starting\nsecond paragraph"));
+    }
+
+    DOCTEST_SUBCASE("paragraphPosition") {
+        CHECK_EQ(page.paragraph(0).paragraphPosition(), 0);
+        CHECK_EQ(page.paragraph(1).paragraphPosition(), 36);
+        CHECK(page.text().mid(page.paragraph(1).paragraphPosition()) == page.paragraph(1).text());
+    }
+
+    DOCTEST_SUBCASE("text grows with the last paragraph") {
+        page.addParagraphLine("third", "eng");
+        CHECK_EQ(page.text(), QString("Hello world one two three. Starting\nsecond paragraph\nthird"));
+        CHECK_EQ(page.paragraph(2).paragraphPosition(), 53);
+        CHECK(page.paragraph(0).textView() == QStringView(u"Hello world one two three. Starting"));
+    }
 }
 
 TEST_CASE("TextPage 2")
@@ -59,3 +76,44 @@ TEST_CASE("TextPage 2")
         CHECK_EQ(page.getText(0, 0).second, QString("Hello world one two three. Starting and finishing"));
     }
 }
+
+TEST_CASE("TextPage getText of incomplete paragraph")
+{
+    TextPage page;
+
+    page.addParagraph();
+    page.addParagraphLine("When the first sentence, which is long,", "eng");
+    page.addParagraphLine("spans several lines and a hyphen-", "eng");
+
+    DOCTEST_SUBCASE("Sentence") {
+        CHECK(page.getText(0, 0, TextPage::Boundary::Sentence).second.isEmpty());
+    }
+
+    DOCTEST_SUBCASE("Clause") {
+        CHECK_EQ(page.getText(0, 0, TextPage::Boundary::Clause).second,
+                 QString("When the first sentence, which is long,"));
+    }
+
+    DOCTEST_SUBCASE("Line stops before hyphenated word") {
+        CHECK_EQ(page.getText(0, 0, TextPage::Boundary::Line).second,
+                 QString("When the first sentence, which is long, spans several lines and a"));
+    }
+
+    DOCTEST_SUBCASE("Continuation after early start") {
+        const auto first = page.getText(0, 0, TextPage::Boundary::Clause).second;
+        page.addParagraphLine("ated word. Second", "eng");
+        CHECK_EQ(page.getText(0, first.size()).second,
+                 QString(" spans several lines and a hyphenated word."));
+    }
+
+    DOCTEST_SUBCASE("Sentence terminator wins") {
+        page.addParagraphLine("ated word. Second", "eng");
+        CHECK_EQ(page.getText(0, 0, TextPage::Boundary::Line).second.right(6), QString(" word."));
+    }
+
+    DOCTEST_SUBCASE("Complete paragraph is said whole") {
+        page.addParagraph();
+        CHECK_EQ(page.getText(0, 0, TextPage::Boundary::Sentence).second,
+                 QString("When the first sentence, which is long, spans several lines and a hyphen"));
+    }
+}
@@ -0,0 +1,103 @@
+#include <doctest.h>
+#include "textscanner.h"
+
+static QVector<int> starts(const PositionTable &positions)
+{
+    QVector<int> result;
+    for (int i = 0; i < positions.size(); ++i)
+        result.append(positions.start(i));
+    return result;
+}
+
+TEST_CASE("TextScanner words")
+{
+    PositionTable words;
+
+    DOCTEST_SUBCASE("latin") {
+        TextScanner::scanWords(u"It's 42 words_here, ok", 0, words);
+        CHECK(starts(words) == QVector<int>{0, 5, 8, 20});
+        CHECK_EQ(words.length(2), 10);
+    }
+
+    DOCTEST_SUBCASE("trailing fragment") {
+        TextScanner::scanWords(u"Hello world!", 0, words);
+        CHECK(starts(words) == QVector<int>{0, 6, 11});
+        CHECK_EQ(words.length(2), 1);
+    }
+
+    DOCTEST_SUBCASE("trailing dash is not a word") {
+        TextScanner::scanWords(u"Hello -", 0, words);
+        CHECK(starts(words) == QVector<int>{0});
+    }
+
+    DOCTEST_SUBCASE("from position") {
+        TextScanner::scanWords(u"one two three", 5, words);
+        CHECK(starts(words) == QVector<int>{5, 8});
+        CHECK_EQ(words.length(0), 2);
+    }
+
+    DOCTEST_SUBCASE("accented and cyrillic") {
+        TextScanner::scanWords(u"café привет", 0, words);
+        CHECK(starts(words) == QVector<int>{0, 5});
+        CHECK_EQ(words.length(1), 6);
+    }
+
+    DOCTEST_SUBCASE("every ideograph is a word") {
+        TextScanner::scanWords(u"我爱你。", 0, words);
+        CHECK(starts(words) == QVector<int>{0, 1, 2, 3});
+    }
+}
+
+TEST_CASE("TextScanner sentences")
+{
+    PositionTable sentences;
+    const auto endMask = TextScanner::sentenceEndMask("eng");
+
+    DOCTEST_SUBCASE("latin") {
+        TextScanner::scanSentences(u"Hello world. One two three", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 12});
+        CHECK_EQ(sentences.length(0), 12);
+        CHECK_EQ(sentences.length(1), 14);
+    }
+
+    DOCTEST_SUBCASE("too short sentence is joined to the trailing fragment") {
+        TextScanner::scanSentences(u"First one! A. Ok", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 10});
+        CHECK_EQ(sentences.length(1), 6);
+    }
+
+    DOCTEST_SUBCASE("greek question mark") {
+        TextScanner::scanSentences(u"Τι κάνεις; Καλά.", 0, TextScanner::sentenceEndMask("ell"), sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 10});
+    }
+
+    DOCTEST_SUBCASE("semicolon doesn't end english sentence") {
+        TextScanner::scanSentences(u"One; two three.", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0});
+    }
+
+    DOCTEST_SUBCASE("arabic") {
+        TextScanner::scanSentences(u"كيف حالك؟ أنا بخير، شكرا.", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 9});
+    }
+
+    DOCTEST_SUBCASE("cjk full stop") {
+        TextScanner::scanSentences(u"今天天气很好。我们去公园吧！", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 7});
+    }
+
+    DOCTEST_SUBCASE("long ascii run") {
+        TextScanner::scanSentences(u"abcdefghijklmnopqrstuvwxyz abcdefghijklmnopqrstuvwxyz. x", 0, endMask, sentences);
+        CHECK(starts(sentences) == QVector<int>{0, 54});
+        CHECK_EQ(sentences.length(0), 54);
+    }
+}
+
+TEST_CASE("TextScanner lastIndexOf")
+{
+    const auto endMask = TextScanner::sentenceEndMask("eng");
+    CHECK_EQ(TextScanner::lastIndexOf(u"One. Two! Three", endMask), 8);
+    CHECK_EQ(TextScanner::lastIndexOf(u"No terminator", endMask), -1);
+    CHECK_EQ(TextScanner::lastIndexOf(u"Τι; Καλά", TextScanner::sentenceEndMask("ell")), 2);
+    CHECK_EQ(TextScanner::lastIndexOf(u"One, two three", TextScanner::ClauseEnd), 3);
+}
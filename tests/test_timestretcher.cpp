@@ -0,0 +1,112 @@
+#include <doctest.h>
+#include "timestretcher.h"
+
+#include <cmath>
+#include <vector>
+
+static const int SAMPLE_RATE = 22050;
+
+static std::vector<qint16> sine(double frequency, int count)
+{
+    std::vector<qint16> samples(count);
+    for (int i = 0; i < count; ++i)
+        samples[i] = static_cast<qint16>(10000 * std::sin(2 * 3.14159265358979 * frequency * i / SAMPLE_RATE));
+    return samples;
+}
+
+// Feeds the source in chunks like the audio output and collects all the output
+static std::vector<qint16> stretch(TimeStretcher &stretcher, const std::vector<qint16> &source)
+{
+    std::vector<qint16> output;
+    qint16 buffer[512];
+    for (size_t pos = 0; pos < source.size(); pos += 1000) {
+        stretcher.push(source.data() + pos, static_cast<int>(std::min<size_t>(1000, source.size() - pos)));
+        while (int count = stretcher.pull(buffer, 512))
+            output.insert(output.end(), buffer, buffer + count);
+    }
+    return output;
+}
+
+static double crossingsPerSample(const std::vector<qint16> &samples, size_t from, size_t to)
+{
+    int crossings = 0;
+    for (size_t i = from + 1; i < to; ++i)
+        crossings += (samples[i - 1] < 0) != (samples[i] < 0);
+    return static_cast<double>(crossings) / (to - from);
+}
+
+TEST_CASE("TimeStretcher")
+{
+    TimeStretcher stretcher(SAMPLE_RATE);
+    const auto source = sine(220, SAMPLE_RATE * 2);
+
+    DOCTEST_SUBCASE("tempo 1 passes the samples through") {
+        const auto output = stretch(stretcher, source);
+        CHECK(output == source);
+        CHECK_EQ(stretcher.sourcePosition(12345), 12345);
+        CHECK_EQ(stretcher.stats().stretchedSamples, 0);
+    }
+
+    DOCTEST_SUBCASE("tempo changes the duration, not the pitch") {
+        for (double tempo : {0.5, 0.8, 1.5, 2.0}) {
+            stretcher.reset();
+            stretcher.setTempo(tempo);
+            const auto output = stretch(stretcher, source);
+            // Only the frames still waiting for the source are missing
+            CHECK_EQ(output.size(), doctest::Approx(source.size() / tempo).epsilon(0.05));
+            CHECK_EQ(crossingsPerSample(output, 0, output.size()),
+                     doctest::Approx(crossingsPerSample(source, 0, source.size())).epsilon(0.02));
+
+            const qint64 middle = static_cast<qint64>(output.size() / 2);
+            CHECK_EQ(stretcher.sourcePosition(middle), doctest::Approx(middle * tempo).epsilon(0.02));
+        }
+    }
+
+    DOCTEST_SUBCASE("native tempo from the position") {
+        stretcher.setTempo(2);
+        stretcher.setNativeFrom(SAMPLE_RATE);
+        const auto output = stretch(stretcher, source);
+        CHECK_EQ(output.size(), doctest::Approx(source.size() * 0.75).epsilon(0.02));
+
+        // The rest of the source follows unchanged
+        const size_t native = output.size() - SAMPLE_RATE / 2;
+        const qint64 sourcePos = stretcher.sourcePosition(static_cast<qint64>(native));
+        CHECK(std::equal(output.begin() + native, output.end(), source.begin() + sourcePos));
+        CHECK_EQ(stretcher.sourcePosition(static_cast<qint64>(output.size())), static_cast<qint64>(source.size()));
+    }
+
+    DOCTEST_SUBCASE("source positions don't go back") {
+        stretcher.setTempo(1.7);
+        const auto output = stretch(stretcher, sine(130, SAMPLE_RATE * 2));
+        qint64 previous = 0;
+        bool isMonotonic = true;
+        for (qint64 pos = 0; pos < static_cast<qint64>(output.size()); pos += 7) {
+            isMonotonic = isMonotonic && stretcher.sourcePosition(pos) >= previous;
+            previous = stretcher.sourcePosition(pos);
+        }
+        CHECK(isMonotonic);
+    }
+
+    DOCTEST_SUBCASE("copied position map") {
+        stretcher.setTempo(1.3);
+        const auto output = stretch(stretcher, sine(200, SAMPLE_RATE * 2));
+        TimeStretcher::PositionMap map;
+        stretcher.copyPositionMap(map);
+        bool isEqual = true;
+        for (qint64 pos = 0; pos < static_cast<qint64>(output.size()) + 1000; pos += 13)
+            isEqual = isEqual && map.sourcePosition(pos) == stretcher.sourcePosition(pos);
+        CHECK(isEqual);
+    }
+
+    DOCTEST_SUBCASE("CPU cost") {
+        stretcher.setTempo(1.5);
+        for (int i = 0; i < 5; ++i)
+            stretch(stretcher, source);
+        const auto stats = stretcher.stats();
+        REQUIRE_GT(stats.stretchedSamples, 0);
+        const double outputSeconds = static_cast<double>(stats.stretchedSamples) / SAMPLE_RATE;
+        MESSAGE("Time stretch of 22050 Hz mono takes " << stats.stretchNs / 1e6 / outputSeconds
+                << " ms of CPU per second of audio");
+        CHECK_LT(stats.stretchNs / 1e9, outputSeconds);
+    }
+}
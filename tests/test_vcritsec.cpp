@@ -0,0 +1,94 @@
+#include <doctest.h>
+
+#include <ve_ttsapi.h>
+#include <vcritsec.h>
+#include <vheap.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Vocalizer critical sections")
+{
+    VE_INSTALL install;
+    memset(&install, 0, sizeof(install));
+    VPLATFORM_RESOURCES resources;
+    memset(&resources, 0, sizeof(resources));
+    REQUIRE_EQ(vplatform_heap_GetInterface(&install, &resources), NUAN_OK);
+    REQUIRE_EQ(vplatform_critsec_GetInterface(&install, &resources), NUAN_OK);
+    REQUIRE(install.pICritSec != nullptr);
+    const auto critSec = install.pICritSec;
+
+    void *hCritSec = nullptr;
+    REQUIRE_EQ(critSec->pfOpen(install.hCSClass, install.hHeap, &hCritSec), NUAN_OK);
+
+    DOCTEST_SUBCASE("recursive enter") {
+        CHECK_EQ(critSec->pfEnter(hCritSec), NUAN_OK);
+        CHECK_EQ(critSec->pfEnter(hCritSec), NUAN_OK);
+        CHECK_EQ(critSec->pfLeave(hCritSec), NUAN_OK);
+        // Still held by the first enter
+        CHECK_EQ(critSec->pfClose(hCritSec), NUAN_E_WRONG_STATE);
+        CHECK_EQ(critSec->pfLeave(hCritSec), NUAN_OK);
+        CHECK_EQ(critSec->pfLeave(hCritSec), NUAN_E_WRONG_STATE);
+    }
+
+    // Several instances, as each TTS engine has its own install, share the counters
+    DOCTEST_SUBCASE("concurrent stress") {
+        constexpr int INSTANCES = 3;
+        constexpr int THREADS_PER_INSTANCE = 3;
+        constexpr int ITERATIONS = 20000;
+
+        VE_INSTALL installs[INSTANCES];
+        void *hCritSecs[INSTANCES] = {};
+        int counters[INSTANCES] = {};
+        for (int i = 0; i < INSTANCES; ++i) {
+            memset(&installs[i], 0, sizeof(installs[i]));
+            REQUIRE_EQ(vplatform_heap_GetInterface(&installs[i], &resources), NUAN_OK);
+            REQUIRE_EQ(vplatform_critsec_GetInterface(&installs[i], &resources), NUAN_OK);
+            REQUIRE_EQ(critSec->pfOpen(installs[i].hCSClass, installs[i].hHeap, &hCritSecs[i]), NUAN_OK);
+        }
+
+        int shared = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < INSTANCES * THREADS_PER_INSTANCE; ++i) {
+            threads.emplace_back([&, i]() {
+                const int instance = i % INSTANCES;
+                for (int n = 0; n < ITERATIONS; ++n) {
+                    critSec->pfEnter(hCritSecs[instance]);
+                    ++counters[instance];
+                    critSec->pfLeave(hCritSecs[instance]);
+
+                    // Critical section of the class, used by all instances
+                    critSec->pfEnter(hCritSec);
+                    critSec->pfEnter(hCritSec);
+                    ++shared;
+                    critSec->pfLeave(hCritSec);
+                    critSec->pfLeave(hCritSec);
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        for (int i = 0; i < INSTANCES; ++i) {
+            CHECK_EQ(counters[i], THREADS_PER_INSTANCE * ITERATIONS);
+
+            VPLATFORM_CRITSEC_STATS stats;
+            REQUIRE_EQ(vplatform_critsec_GetStats(installs[i].hCSClass, &stats), NUAN_OK);
+            CHECK_EQ(stats.cntEnter, static_cast<unsigned long long>(THREADS_PER_INSTANCE * ITERATIONS));
+            CHECK_LE(stats.cntContended, stats.cntEnter);
+            CHECK_EQ(stats.cntOpen, 1u);
+
+            CHECK_EQ(critSec->pfClose(hCritSecs[i]), NUAN_OK);
+            CHECK_EQ(vplatform_critsec_ReleaseInterface(installs[i].hCSClass), NUAN_OK);
+        }
+        CHECK_EQ(shared, INSTANCES * THREADS_PER_INSTANCE * ITERATIONS);
+
+        VPLATFORM_CRITSEC_STATS stats;
+        REQUIRE_EQ(vplatform_critsec_GetStats(install.hCSClass, &stats), NUAN_OK);
+        CHECK_EQ(stats.cntEnter, static_cast<unsigned long long>(INSTANCES * THREADS_PER_INSTANCE * ITERATIONS));
+    }
+
+    CHECK_EQ(critSec->pfClose(hCritSec), NUAN_OK);
+    CHECK_EQ(vplatform_critsec_ReleaseInterface(install.hCSClass), NUAN_OK);
+}
@@ -0,0 +1,74 @@
+#include <doctest.h>
+
+#include <ve_ttsapi.h>
+#include <vdata.h>
+#include <vheap.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void writeFile(const std::string &fileName, const char *contents, const char *mode = "wb")
+{
+    FILE *fp = fopen(fileName.c_str(), mode);
+    REQUIRE(fp != nullptr);
+    fputs(contents, fp);
+    fclose(fp);
+}
+
+TEST_CASE("Vocalizer data index")
+{
+    char dirName[] = "test_vdataindex_XXXXXX";
+    REQUIRE(mkdtemp(dirName) != nullptr);
+    const std::string dir = dirName;
+    writeFile(dir + "/voice.hdr", "[header]\n");
+    writeFile(dir + "/voice.dat", "data");
+    writeFile(dir + "/extra.dat", "data");
+
+    char *installPaths[] = {dirName};
+    VPLATFORM_RESOURCES resources;
+    memset(&resources, 0, sizeof(resources));
+    resources.u16NbrOfDataInstall = 1;
+    resources.apDataInstall = installPaths;
+
+    // Broker info of a new engine and whether it came from the index
+    auto init = [&resources](std::string &brokerInfo) {
+        VE_INSTALL install;
+        memset(&install, 0, sizeof(install));
+        VPLATFORM_DATA_INDEX_STATS before, after;
+        REQUIRE_EQ(vplatform_data_GetIndexStats(&before), NUAN_OK);
+        REQUIRE_EQ(vplatform_heap_GetInterface(&install, &resources), NUAN_OK);
+        REQUIRE_EQ(vplatform_data_GetInterface(&install, &resources), NUAN_OK);
+        REQUIRE_EQ(vplatform_data_GetIndexStats(&after), NUAN_OK);
+        brokerInfo = install.pBinBrokerInfo ? static_cast<const char *>(install.pBinBrokerInfo) : "";
+        CHECK_EQ(vplatform_data_ReleaseInterface(install.hDataClass), NUAN_OK);
+        CHECK_EQ(vplatform_heap_ReleaseInterface(install.hHeap), NUAN_OK);
+        CHECK_EQ(after.cntHits + after.cntMisses, before.cntHits + before.cntMisses + 1);
+        return after.cntHits > before.cntHits;
+    };
+
+    std::string first, second;
+    CHECK_FALSE(init(first));
+    CHECK(first.find("[header]") != std::string::npos);
+    CHECK(init(second));
+    CHECK_EQ(second, first);
+
+    // Changed header is read again
+    writeFile(dir + "/voice.hdr", "[changed]\n", "ab");
+    CHECK_FALSE(init(second));
+    CHECK(second.find("[changed]") != std::string::npos);
+    CHECK(init(second));
+
+    // Removed data file is dropped from the index
+    REQUIRE_EQ(std::remove((dir + "/extra.dat").c_str()), 0);
+    CHECK_FALSE(init(second));
+    CHECK(init(second));
+
+    CHECK_EQ(vplatform_data_GetIndexStats(nullptr), NUAN_E_NULLPOINTER);
+
+    std::remove((dir + "/voice.hdr").c_str());
+    std::remove((dir + "/voice.dat").c_str());
+    rmdir(dirName);
+}
@@ -0,0 +1,80 @@
+#include <doctest.h>
+
+#include <ve_ttsapi.h>
+#include <vfile.h>
+#include <vmap.h>
+
+#include <cstdio>
+#include <cstring>
+
+TEST_CASE("Vocalizer mapped files")
+{
+    const char *fileName = "test_vfile.dat";
+    const char contents[] = "0123456789";
+    FILE *fp = fopen(fileName, "wb");
+    REQUIRE(fp != nullptr);
+    fwrite(contents, 1, 10, fp);
+    fclose(fp);
+
+    // Only the broker strings are resolved through the data class
+    int dataClass = 0;
+    char buffer[16] = {};
+
+    DOCTEST_SUBCASE("read and seek") {
+        VPLATFORM_FILE_H hFile = nullptr;
+        REQUIRE_EQ(vplatform_file_Open(&dataClass, nullptr, fileName, "rb", &hFile), NUAN_OK);
+        CHECK_EQ(vplatform_file_GetSize(hFile), 10u);
+
+        CHECK_EQ(vplatform_file_Read(buffer, 2, 2, hFile), 2u);
+        CHECK_EQ(memcmp(buffer, "0123", 4), 0);
+        CHECK_EQ(vplatform_file_Seek(hFile, 3, VE_STREAM_SEEK_END, VE_STREAM_BACKWARD), NUAN_OK);
+        // Only whole elements are read
+        CHECK_EQ(vplatform_file_Read(buffer, 2, 4, hFile), 1u);
+        CHECK_EQ(memcmp(buffer, "78", 2), 0);
+        CHECK_EQ(vplatform_file_Seek(hFile, 20, VE_STREAM_SEEK_CUR, VE_STREAM_BACKWARD), NUAN_E_FILESEEK);
+        CHECK_EQ(vplatform_file_Seek(hFile, 20, VE_STREAM_SEEK_SET, VE_STREAM_FORWARD), NUAN_OK);
+        CHECK_EQ(vplatform_file_Read(buffer, 1, 4, hFile), 0u);
+        CHECK_EQ(vplatform_file_Error(hFile), NUAN_OK);
+        CHECK_EQ(vplatform_file_Write(buffer, 1, 1, hFile), 0u);
+
+        // The second open of the file shares its pages
+        VPLATFORM_FILE_H hSecond = nullptr;
+        REQUIRE_EQ(vplatform_file_Open(&dataClass, nullptr, fileName, "rb", &hSecond), NUAN_OK);
+        const void *pData = nullptr, *pSecondData = nullptr;
+        size_t cBytes = 0;
+        REQUIRE_EQ(vplatform_file_GetData(hFile, &pData, &cBytes), NUAN_OK);
+        REQUIRE_EQ(vplatform_file_GetData(hSecond, &pSecondData, &cBytes), NUAN_OK);
+        CHECK_EQ(pData, pSecondData);
+        CHECK_EQ(vplatform_file_Close(hFile), NUAN_OK);
+        CHECK_EQ(vplatform_file_Close(hSecond), NUAN_OK);
+    }
+
+    DOCTEST_SUBCASE("written files use stdio") {
+        VPLATFORM_FILE_H hFile = nullptr;
+        REQUIRE_EQ(vplatform_file_Open(&dataClass, nullptr, fileName, "ab", &hFile), NUAN_OK);
+        const void *pData = nullptr;
+        size_t cBytes = 0;
+        CHECK_EQ(vplatform_file_GetData(hFile, &pData, &cBytes), NUAN_E_NOTIMPLEMENTED);
+        CHECK_EQ(vplatform_file_Write("ab", 1, 2, hFile), 2u);
+        CHECK_EQ(vplatform_file_GetSize(hFile), 12u);
+        CHECK_EQ(vplatform_file_Close(hFile), NUAN_OK);
+    }
+
+    DOCTEST_SUBCASE("data mapping") {
+        void *hMapping = nullptr;
+        REQUIRE_EQ(vplatform_datamapping_Open(&dataClass, nullptr, fileName, &hMapping), NUAN_OK);
+        const void *pData = nullptr;
+        size_t cBytes = 100;
+        REQUIRE_EQ(vplatform_datamapping_Map(hMapping, 4, &cBytes, &pData), NUAN_OK);
+        CHECK_EQ(cBytes, 6u);
+        CHECK_EQ(memcmp(pData, "456789", 6), 0);
+        CHECK_EQ(vplatform_datamapping_Unmap(hMapping, pData), NUAN_OK);
+        cBytes = 1;
+        CHECK_EQ(vplatform_datamapping_Map(hMapping, 11, &cBytes, &pData), NUAN_E_OUTOFRANGE);
+        CHECK_EQ(vplatform_datamapping_Close(hMapping), NUAN_OK);
+
+        CHECK_EQ(vplatform_datamapping_Open(&dataClass, nullptr, "missing.dat", &hMapping), NUAN_E_COULDNOTOPENFILE);
+    }
+
+    std::remove(fileName);
+}
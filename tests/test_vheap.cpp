@@ -0,0 +1,114 @@
+#include <doctest.h>
+
+#include <ve_ttsapi.h>
+#include <vheap.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Vocalizer pool heap")
+{
+    VE_INSTALL install;
+    memset(&install, 0, sizeof(install));
+    VPLATFORM_RESOURCES resources;
+    memset(&resources, 0, sizeof(resources));
+
+    DOCTEST_SUBCASE("C library heap by default") {
+        REQUIRE_EQ(vplatform_heap_GetInterface(&install, &resources), NUAN_OK);
+        CHECK_EQ(install.hHeap, nullptr);
+        VPLATFORM_HEAP_STATS stats;
+        CHECK_EQ(vplatform_heap_GetStats(install.hHeap, &stats), NUAN_E_NULLPOINTER);
+        void *p = install.pIHeap->pfMalloc(install.hHeap, 100);
+        CHECK(p != nullptr);
+        install.pIHeap->pfFree(install.hHeap, p);
+    }
+
+    resources.bFlags = F_POOL_HEAP;
+    REQUIRE_EQ(vplatform_heap_GetInterface(&install, &resources), NUAN_OK);
+    REQUIRE(install.hHeap != nullptr);
+    const auto heap = install.pIHeap;
+    void *const hHeap = install.hHeap;
+    VPLATFORM_HEAP_STATS stats;
+
+    DOCTEST_SUBCASE("blocks are reused") {
+        void *p = heap->pfMalloc(hHeap, 100);
+        REQUIRE(p != nullptr);
+        CHECK_EQ(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t), 0u);
+        heap->pfFree(hHeap, p);
+        CHECK_EQ(heap->pfMalloc(hHeap, 90), p);
+        heap->pfFree(hHeap, p);
+
+        REQUIRE_EQ(vplatform_heap_GetStats(hHeap, &stats), NUAN_OK);
+        CHECK_EQ(stats.cntAlloc, 2u);
+        CHECK_EQ(stats.cntFree, 2u);
+        CHECK_EQ(stats.cBytesInUse, 0u);
+        CHECK_EQ(stats.cBytesPeak, 100u);
+        CHECK_EQ(stats.cBytesPooled, 0u);
+        CHECK_EQ(stats.cBytesReserved, 64u * 1024);
+    }
+
+    DOCTEST_SUBCASE("calloc and realloc") {
+        auto p = static_cast<unsigned char *>(heap->pfCalloc(hHeap, 10, 10));
+        REQUIRE(p != nullptr);
+        CHECK(std::all_of(p, p + 100, [](unsigned char c) { return c == 0; }));
+        memset(p, 7, 100);
+
+        // Grows in place within the block, then moves to the larger class
+        CHECK_EQ(heap->pfRealloc(hHeap, p, 110), p);
+        p = static_cast<unsigned char *>(heap->pfRealloc(hHeap, p, 1000));
+        REQUIRE(p != nullptr);
+        CHECK(std::all_of(p, p + 100, [](unsigned char c) { return c == 7; }));
+
+        // Large blocks come right from the C library
+        p = static_cast<unsigned char *>(heap->pfRealloc(hHeap, p, 100000));
+        REQUIRE(p != nullptr);
+        CHECK_EQ(p[99], 7);
+        REQUIRE_EQ(vplatform_heap_GetStats(hHeap, &stats), NUAN_OK);
+        CHECK_EQ(stats.cntLarge, 1u);
+        CHECK_EQ(stats.cBytesInUse, 100000u);
+
+        CHECK_EQ(heap->pfRealloc(hHeap, p, 0), nullptr);
+        CHECK_EQ(heap->pfCalloc(hHeap, SIZE_MAX / 2, 4), nullptr);
+        REQUIRE_EQ(vplatform_heap_GetStats(hHeap, &stats), NUAN_OK);
+        CHECK_EQ(stats.cBytesInUse, 0u);
+        CHECK_EQ(stats.cBytesReserved, 64u * 1024);
+        CHECK_GT(stats.cBytesPeakReserved, 64u * 1024 + 100000);
+    }
+
+    DOCTEST_SUBCASE("concurrent stress") {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&, i]() {
+                std::vector<unsigned char *> blocks;
+                for (int n = 0; n < 20000; ++n) {
+                    const size_t size = (n * 37 + i) % 5000 + 1;
+                    auto p = static_cast<unsigned char *>(heap->pfMalloc(hHeap, size));
+                    p[0] = p[size - 1] = static_cast<unsigned char>(i);
+                    blocks.push_back(p);
+                    if (n % 3 == 0) {
+                        heap->pfFree(hHeap, blocks.front());
+                        blocks.erase(blocks.begin());
+                    }
+                }
+                for (auto p : blocks) {
+                    CHECK_EQ(p[0], i);
+                    heap->pfFree(hHeap, p);
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        REQUIRE_EQ(vplatform_heap_GetStats(hHeap, &stats), NUAN_OK);
+        CHECK_EQ(stats.cntAlloc, 80000u);
+        CHECK_EQ(stats.cntFree, 80000u);
+        CHECK_EQ(stats.cBytesInUse, 0u);
+        CHECK_EQ(stats.cBytesPooled, 0u);
+    }
+
+    CHECK_EQ(vplatform_heap_ReleaseInterface(hHeap), NUAN_OK);
+}
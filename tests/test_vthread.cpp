@@ -0,0 +1,118 @@
+#include <doctest.h>
+
+#include <ve_ttsapi.h>
+#include <vthread.h>
+
+#include <atomic>
+#include <cstring>
+#include <sched.h>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+static void *addOne(void *arg)
+{
+    ++*static_cast<std::atomic<int> *>(arg);
+    return arg;
+}
+
+static void *waitForFlag(void *arg)
+{
+    auto flag = static_cast<std::atomic<bool> *>(arg);
+    while (!*flag)
+        std::this_thread::yield();
+    return nullptr;
+}
+
+TEST_CASE("Vocalizer thread pool")
+{
+    VE_INSTALL install;
+    memset(&install, 0, sizeof(install));
+    VPLATFORM_RESOURCES resources;
+    memset(&resources, 0, sizeof(resources));
+    REQUIRE_EQ(vplatform_thread_GetInterface(&install, &resources), NUAN_OK);
+    const auto thread = install.pIThread;
+
+    void *hThread = nullptr;
+    REQUIRE_EQ(thread->pfOpen(nullptr, nullptr, &hThread), NUAN_OK);
+    std::atomic<int> counter {0};
+    VPLATFORM_THREAD_STATS before, after;
+
+    DOCTEST_SUBCASE("workers are reused") {
+        void *result = nullptr;
+        REQUIRE_EQ(thread->pfStart(hThread, addOne, &counter, 64 * 1024), NUAN_OK);
+        CHECK_EQ(thread->pfStart(hThread, addOne, &counter, 64 * 1024), NUAN_E_WRONG_STATE);
+        REQUIRE_EQ(thread->pfJoin(hThread, &result), NUAN_OK);
+        CHECK_EQ(result, &counter);
+        CHECK_EQ(thread->pfJoin(hThread, &result), NUAN_E_NOK);
+
+        REQUIRE_EQ(vplatform_thread_GetStats(&before), NUAN_OK);
+        REQUIRE_EQ(thread->pfStart(hThread, addOne, &counter, 64 * 1024), NUAN_OK);
+        REQUIRE_EQ(thread->pfJoin(hThread, nullptr), NUAN_OK);
+        REQUIRE_EQ(vplatform_thread_GetStats(&after), NUAN_OK);
+        CHECK_EQ(counter, 2);
+        CHECK_EQ(after.cntCreated, before.cntCreated);
+        CHECK_EQ(after.cntReused, before.cntReused + 1);
+        CHECK_EQ(after.cntJoin, before.cntJoin + 1);
+    }
+
+    DOCTEST_SUBCASE("running thread can't be closed") {
+        std::atomic<bool> flag {false};
+        REQUIRE_EQ(thread->pfStart(hThread, waitForFlag, &flag, 0), NUAN_OK);
+        CHECK_EQ(thread->pfClose(hThread), NUAN_E_WRONG_STATE);
+        flag = true;
+        REQUIRE_EQ(thread->pfJoin(hThread, nullptr), NUAN_OK);
+    }
+
+    DOCTEST_SUBCASE("concurrent threads") {
+        constexpr int THREADS = 8;
+        std::vector<void *> handles(THREADS);
+        for (int n = 0; n < 50; ++n) {
+            for (auto &h : handles) {
+                REQUIRE_EQ(thread->pfOpen(nullptr, nullptr, &h), NUAN_OK);
+                REQUIRE_EQ(thread->pfStart(h, addOne, &counter, 0), NUAN_OK);
+            }
+            for (auto h : handles) {
+                CHECK_EQ(thread->pfJoin(h, nullptr), NUAN_OK);
+                CHECK_EQ(thread->pfClose(h), NUAN_OK);
+            }
+        }
+        CHECK_EQ(counter, 50 * THREADS);
+        REQUIRE_EQ(vplatform_thread_GetStats(&after), NUAN_OK);
+        CHECK_LE(after.cntIdle, 4u);
+    }
+
+    DOCTEST_SUBCASE("role parameters") {
+        VPLATFORM_THREAD_PARAMS params;
+        memset(&params, 0, sizeof(params));
+        params.iPolicy = SCHED_OTHER;
+        params.iNice = 5;
+        CHECK_EQ(vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_COUNT, &params), NUAN_E_INVALIDARG);
+        REQUIRE_EQ(vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_BACKGROUND, &params), NUAN_OK);
+        REQUIRE_EQ(vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_ENGINE, &params), NUAN_OK);
+
+        // Nice value of a thread can always be raised
+        int nice = 0;
+        std::thread([&nice]() {
+            CHECK_EQ(vplatform_thread_ApplyRole(VPLATFORM_THREAD_ROLE_BACKGROUND), NUAN_OK);
+            nice = getpriority(PRIO_PROCESS, 0);
+        }).join();
+        CHECK_EQ(nice, 5);
+
+        auto niceOfWorker = [](void *arg) -> void * {
+            *static_cast<int *>(arg) = getpriority(PRIO_PROCESS, 0);
+            return nullptr;
+        };
+        nice = 0;
+        REQUIRE_EQ(thread->pfStart(hThread, niceOfWorker, &nice, 0), NUAN_OK);
+        REQUIRE_EQ(thread->pfJoin(hThread, nullptr), NUAN_OK);
+        CHECK_EQ(nice, 5);
+
+        params.iNice = 0;
+        vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_BACKGROUND, &params);
+        vplatform_thread_SetRoleParams(VPLATFORM_THREAD_ROLE_ENGINE, &params);
+    }
+
+    CHECK_EQ(thread->pfClose(hThread), NUAN_OK);
+    CHECK_EQ(vplatform_thread_ReleaseInterface(nullptr), NUAN_OK);
+}
@@ -9,9 +9,13 @@
 
 #include <QApplication>
 #include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QProcess>
 #include <vector>
 #include <dirent.h>
 #include <unistd.h>
+#include <signal.h>
 
 using namespace std;
 
@@ -56,15 +60,18 @@ vector<int> getProcIdByName(string procName) {
 void KillProgramsByName(string sName) {
     vector<int> vId = getProcIdByName(sName);
     int nSelfId = getpid();
-    char sCommand[256];
     for(vector<int>::const_iterator i = vId.begin(); i != vId.end(); ++i) {
-        if(*i != nSelfId) {
-            sprintf(sCommand, "kill -9 %d", *i);
-            system(sCommand);
-        }
+        if(*i != nSelfId)
+            kill(*i, SIGKILL);
     }
 }
 
+// Plays in background without starting a shell
+void PlayStartupSound() {
+    if(!QProcess::startDetached("aplay", {"/opt/zyrlo/Distrib/Data/start_up.wav"}))
+        qWarning() << "Can't play startup sound";
+}
+
 string GetProgName(const string & sPath) {
     auto pos = sPath.find_last_of("/");
     if(pos == string::npos)
@@ -76,9 +83,12 @@ void RebootOnBtError();
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer timer;
+    timer.start();
     RebootOnBtError();
-    system("aplay /opt/zyrlo/Distrib/Data/start_up.wav &");
+    PlayStartupSound();
     KillProgramsByName(GetProgName(argv[0]));
+    qDebug() << "Startup checks took" << timer.elapsed() << "ms";
     // This is required for tesseract
     qputenv("LC_ALL", "C");
     QCoreApplication::setOrganizationName("Zyrlo");
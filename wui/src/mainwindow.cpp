@@ -79,8 +79,13 @@ MainWindow::MainWindow(QWidget *parent)
 
     ShowButtons(m_bShowButtons);
 
+    // Input is dispatched to the controller when its startup is done
+    setEnabled(m_controller.isReady());
+    connect(&m_controller, &MainController::ready, this, [this]() { setEnabled(true); });
+
     connect(ui->startButton, &QPushButton::clicked, this, &MainWindow::start);
-    connect(&m_controller, &MainController::textUpdated, this, &MainWindow::updateText);
+    connect(&m_controller, &MainController::textAppended, this, &MainWindow::appendText);
+    connect(&m_controller, &MainController::textReset, this, &MainWindow::clearText);
     connect(&m_controller, &MainController::wordPositionChanged, this, &MainWindow::highlighWord);
     connect(&m_controller, &MainController::previewUpdated, this, &MainWindow::updatePreview);
     connect(&m_controller, &MainController::openMainMenu, this, &MainWindow::mainMenu);
@@ -339,23 +344,32 @@ void MainWindow::start()
     m_controller.startFile(ui->fileNameLineEdit->text());
 }
 
-void MainWindow::updateText(QString text)
+void MainWindow::appendText(int offset, const QString &text)
 {
-    const auto currentText = ui->textBrowser->toPlainText();
-    if (text.left(currentText.size()) == currentText) {
-        // Remove the currentText from the text
-        text.remove(0, currentText.size());
-    } else {
-        // text is not according to the current text, will clear and replace it
-        ui->textBrowser->clear();
-    }
-
     QTextCharFormat fmt;
     fmt.setFontPointSize(14);
 
+    if (offset != m_textLength) {
+        // The view missed a part of the page, will clear and replace it with the full text
+        const auto pageText = m_controller.getPageText();
+        clearText();
+        QTextCursor cursor(ui->textBrowser->document());
+        cursor.insertText(pageText, fmt);
+        m_textLength = pageText.size();
+        return;
+    }
+
     QTextCursor cursor(ui->textBrowser->document());
     cursor.movePosition(QTextCursor::End);
     cursor.insertText(text, fmt);
+    m_textLength = offset + text.size();
+}
+
+void MainWindow::clearText()
+{
+    ui->textBrowser->clear();
+    m_textLength = 0;
+    m_prevPosition.clear();
 }
 
 void MainWindow::highlighWord(const TextPosition &position)
@@ -40,7 +40,8 @@ protected:
 
 private slots:
     void start();
-    void updateText(QString text);
+    void appendText(int offset, const QString &text);
+    void clearText();
     void highlighWord(const TextPosition &position);
     void updatePreview(const cv::Mat &img);
 
@@ -70,6 +71,7 @@ private:
     MainController m_controller;
     TextPosition m_prevPosition;
     QTextCharFormat m_prevFormat;
+    int m_textLength {0};
     cv::Mat m_prevImg;
     bool m_bSavePreviewImage = false, m_bPreviewOn = false, m_bShowButtons = false;
 